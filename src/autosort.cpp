@@ -0,0 +1,183 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+//Project includes
+#include "autosort.h"
+
+/**	@brief	Create instance of the auto sort class from shared object
+ *	@return	A new instance of AutoSort as Sorter*
+ */
+extern "C" JAC::Integer::SortAlgorithm* create() {
+	return new JAC::Integer::AutoSort();
+}
+
+/**	@brief	Deletes the specified instance of a AutoSort, allocated by this module
+ *	@param	val	Pointer to a AutoSort that was allocated by this module's
+ * 							CreateInstance() function
+ */
+extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
+	if(obj != nullptr) delete obj;
+	obj = nullptr;
+}
+
+/**	@brief	Describes the auto sort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		false,	//Stable
+		false,	//In place
+		true,	//Parallel
+		8.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth64,	//Key widths
+		0,	//Min keys
+		0,	//Max keys
+		"Profiles the input and dispatches to the best available algorithm"
+	};
+	return &caps;
+}
+
+namespace JAC::Integer {
+
+/**	@brief	Default constructor */
+AutoSort::AutoSort() {
+}
+
+/**	@brief	Destructor */
+AutoSort::~AutoSort() {
+}
+
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void AutoSort::sort(uint64_t* keys, size_t count) {
+	InputProfile profile = profileKeys(keys, count);
+	choice_ = selector_.choose(profile);
+	if(log_)
+		std::cerr << "auto: chose '" << choice_.algorithm << "' for " <<
+			AlgorithmSelector::describe(profile) << ": " << choice_.reason << std::endl;
+
+	if(choice_.algorithm == AlgorithmSelector::AlreadySorted) {
+		//Nothing to do
+	}
+	else if(choice_.algorithm == AlgorithmSelector::Reverse) {
+		std::reverse(keys, keys + count);
+	}
+	else if(choice_.algorithm == AlgorithmSelector::RunMerge) {
+		mergeRuns(keys, count);
+	}
+	else if(choice_.algorithm == AlgorithmSelector::Insertion) {
+		insertionSort(keys, count);
+	}
+	else if(choice_.algorithm == AlgorithmSelector::Introsort) {
+		std::sort(keys, keys + count);
+	}
+	else {
+		SortAlgorithm* delegate = SortAlgorithm::create(choice_.algorithm);
+		try {
+			for(const auto& option : options_)
+				delegate->setOption(option.first, option.second);
+			delegate->sort(keys, count);
+		}
+		catch(...) {
+			SortAlgorithm::destroy(delegate);
+			throw;
+		}
+		SortAlgorithm::destroy(delegate);
+	}
+}
+
+/**	@brief	Sets an option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True
+ *	@throws	std::invalid_argument	On an invalid value for a recognized option
+ */
+bool AutoSort::setOption(const std::string& name, const std::string& value) {
+	if(name == "log") {
+		if(value != "0" && value != "1")
+			throw std::invalid_argument("log must be 0 or 1, got: " + value);
+		log_ = (value == "1");
+		return true;
+	}
+	if(name == "threads") {
+		size_t used = 0;
+		unsigned long threads = 0;
+		try {
+			threads = std::stoul(value, &used);
+		}
+		catch(const std::exception&) {
+			used = 0;
+		}
+		if(used == 0 || used != value.size())
+			throw std::invalid_argument("threads must be a number, got: " + value);
+		selector_ = AlgorithmSelector((unsigned) threads);
+	}
+	options_.emplace_back(name, value);
+	return true;
+}
+
+/**	@brief	Merges an array made of a few sorted runs
+ *	@param	keys	The keys, sorted in place
+ *	@param	count	Number of keys
+ */
+void AutoSort::mergeRuns(uint64_t* keys, size_t count) {
+	//Run boundaries, including both ends
+	std::vector<size_t> bounds = { 0 };
+	for(size_t idx = 1; idx < count; idx++) {
+		if(keys[idx] < keys[idx-1]) bounds.push_back(idx);
+	}
+	bounds.push_back(count);
+
+	//Merge neighbouring runs pairwise until one remains
+	while(bounds.size() > 2) {
+		std::vector<size_t> merged = { 0 };
+		for(size_t run = 0; run + 1 < bounds.size() - 1; run += 2) {
+			std::inplace_merge(keys + bounds[run], keys + bounds[run+1],
+				keys + bounds[run+2]);
+			merged.push_back(bounds[run+2]);
+		}
+		if(merged.back() != count) merged.push_back(count);
+		bounds.swap(merged);
+	}
+}
+
+/**	@brief	Insertion sort for tiny arrays
+ *	@param	keys	The keys, sorted in place
+ *	@param	count	Number of keys
+ */
+void AutoSort::insertionSort(uint64_t* keys, size_t count) {
+	for(size_t idx = 1; idx < count; idx++) {
+		uint64_t key = keys[idx];
+		size_t pos = idx;
+		while(pos > 0 && keys[pos-1] > key) {
+			keys[pos] = keys[pos-1];
+			pos--;
+		}
+		keys[pos] = key;
+	}
+}
+
+}; //End namespace
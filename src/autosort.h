@@ -0,0 +1,111 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _AUTOSORT_INCLUDED
+#define _AUTOSORT_INCLUDED
+//System includes
+//Library includes
+#include <string>
+#include <utility>
+#include <vector>
+//Project includes
+#include "sortalgorithm.h"
+#include "selector.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Self-selecting sort for sorting library
+ *	Profiles each input (key range, runs, duplicates) and hands it to the
+ *	algorithm that suits it: nothing for sorted input, a reversal or a run
+ *	merge for input that is already mostly ordered, insertion sort for tiny
+ *	input, and the best available radix plugin otherwise, or std::sort if
+ *	no plugin can be loaded. With the log option the choice and the reason
+ *	for it are written to stderr.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class AutoSort : public SortAlgorithm {
+private:
+	//Options forwarded to the chosen plugin
+	typedef std::vector<std::pair<std::string, std::string>> Options_t;
+
+private:
+	//The sort type string
+	std::string 			type_ = "auto";
+
+	//Log each choice to stderr
+	bool							log_ = false;
+
+	//Chooses the algorithm for each input
+	AlgorithmSelector	selector_;
+
+	//Options for the chosen plugin
+	Options_t					options_;
+
+	//The last choice made
+	AlgorithmChoice		choice_;
+
+public:
+	/**	@brief	Default constructor */
+	AutoSort();
+
+	/**	@brief	Destructor */
+	virtual ~AutoSort();
+
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	void sort(uint64_t* keys, size_t count) override;
+
+	/**	@brief	Sets an option
+	 *	Recognized options:
+	 *		log			1 to log each choice to stderr, 0 (default) for silence
+	 *		threads	Threads available to parallel plugins; also forwarded
+	 *	Anything else is forwarded to the chosen plugin, which may ignore it.
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True
+	 *	@throws	std::invalid_argument	On an invalid value for a recognized option
+	 */
+	bool setOption(const std::string& name, const std::string& value) override;
+
+	/**	@brief	The algorithm chosen by the last sort() */
+	inline const AlgorithmChoice& lastChoice() const { return choice_; }
+
+private:
+	/**	@brief	Merges an array made of a few sorted runs
+	 *	@param	keys	The keys, sorted in place
+	 *	@param	count	Number of keys
+	 */
+	static void mergeRuns(uint64_t* keys, size_t count);
+
+	/**	@brief	Insertion sort for tiny arrays
+	 *	@param	keys	The keys, sorted in place
+	 *	@param	count	Number of keys
+	 */
+	static void insertionSort(uint64_t* keys, size_t count);
+};
+
+AutoSort __autosort_instance;
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,440 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <getopt.h>
+//Library includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+//Local includes
+#include "sortalgorithm.h"
+#include "generator.h"
+
+//Integer library namespace
+using namespace JAC::Integer;
+
+//For high-resolution clock
+using namespace std::chrono;
+
+//Defaults
+static const char*		DefaultSizes					= "1000,100000,1000000";
+static const char*		DefaultDistributions	= "uniform,zipf,normal,sorted,reverse,nearly,few,sawtooth";
+static const unsigned	DefaultRepeats				= 5;
+static const unsigned	DefaultWarmups				= 1;
+static const double		DefaultTimeLimit			= 10.0;
+
+/**	@brief	Timings for one algorithm, distribution and input size */
+struct BenchResult {
+	std::string					algorithm;			/*! Plugin name */
+	std::string					distribution;		/*! Distribution specification */
+	uint64_t						size;						/*! Keys per input */
+	std::string					status;					/*! ok, timeout, skipped, failed or unsorted */
+	std::vector<double>	seconds;				/*! Timed trials, in seconds */
+	uint64_t						segments;				/*! Segments per input, 0 for one array */
+};
+
+/**	@brief	Splits a comma-separated list */
+static std::vector<std::string> splitList(const std::string& text) {
+	std::vector<std::string> items;
+	std::stringstream stream(text);
+	std::string item;
+	while(std::getline(stream, item, ','))
+		if(!item.empty()) items.push_back(item);
+	return items;
+}
+
+/**	@brief	Lists the plugins in the plugin directory
+ *	The directory is $ISORT_PLUGIN_DIR if set, otherwise the sort library's
+ *	own directory. Libraries that do not export the plugin API are ignored.
+ */
+static std::vector<std::string> discoverPlugins() {
+	const char* dir = getenv("ISORT_PLUGIN_DIR");
+	SortAlgorithm::loadPlugins((dir != nullptr) ? std::string(dir) : SortAlgorithm::pluginDirectory());
+	return SortAlgorithm::algorithms();
+}
+
+/**	@brief	Nearest-rank percentile of a set of timings
+ *	@param	seconds	The timings
+ *	@param	pct			Percentile, 0-100
+ */
+static double percentile(std::vector<double> seconds, double pct) {
+	if(seconds.empty()) return 0;
+	std::sort(seconds.begin(), seconds.end());
+	size_t rank = (size_t) std::ceil(pct / 100 * seconds.size());
+	return seconds[std::max<size_t>(rank, 1) - 1];
+}
+
+/**	@brief	Order-independent checksum of a set of keys */
+static std::pair<uint64_t, uint64_t> checksum(const std::vector<uint64_t>& keys) {
+	uint64_t sum = 0, mix = 0;
+	for(uint64_t key : keys) {
+		sum += key;
+		mix ^= key * 0x9E3779B97F4A7C15ULL;
+	}
+	return { sum, mix };
+}
+
+/**	@brief	Splits size keys into segments of random length
+ *	@param	size			Number of keys
+ *	@param	minKeys		Shortest segment
+ *	@param	maxKeys		Longest segment
+ *	@param	seed			Seed for the segment lengths
+ *	@return	Segment boundaries, one more than the number of segments
+ */
+static std::vector<uint64_t> segmentOffsets(uint64_t size, uint64_t minKeys, uint64_t maxKeys,
+	uint64_t seed) {
+	std::mt19937_64 random(seed);
+	std::uniform_int_distribution<uint64_t> length(minKeys, maxKeys);
+	std::vector<uint64_t> offsets = { 0 };
+	while(offsets.back() < size)
+		offsets.push_back(std::min(size, offsets.back() + length(random)));
+	return offsets;
+}
+
+/**	@brief	True if every segment of a flat buffer is sorted */
+static bool segmentsSorted(const std::vector<uint64_t>& keys,
+	const std::vector<uint64_t>& offsets) {
+	for(size_t segment = 0; segment + 1 < offsets.size(); segment++) {
+		if(!std::is_sorted(keys.begin() + offsets[segment], keys.begin() + offsets[segment+1]))
+			return false;
+	}
+	return true;
+}
+
+/**	@brief	Segments sorted per second at the median time, 0 for whole-array results */
+static double segmentRate(const BenchResult& result) {
+	double median = percentile(result.seconds, 50);
+	return (result.segments > 0 && median > 0) ? result.segments / median : 0;
+}
+
+/**	@brief	Writes results as an aligned text table */
+static void writeTable(std::ostream& out, const std::vector<BenchResult>& results) {
+	const bool segmented = !results.empty() && results.front().segments > 0;
+	char line[256];
+	snprintf(line, sizeof(line), "%-12s %-14s %12s %8s %12s %12s %10s%s\n", "algorithm",
+		"distribution", "size", "status", "median(s)", "p90(s)", "ns/elem",
+		segmented ? "       segs/s" : "");
+	out << line;
+	for(const BenchResult& result : results) {
+		double median = percentile(result.seconds, 50);
+		snprintf(line, sizeof(line), "%-12s %-14s %12lu %8s %12.6f %12.6f %10.2f",
+			result.algorithm.c_str(), result.distribution.c_str(), result.size,
+			result.status.c_str(), median, percentile(result.seconds, 90),
+			median * 1e9 / std::max<uint64_t>(result.size, 1));
+		out << line;
+		if(segmented) {
+			snprintf(line, sizeof(line), " %12.0f", segmentRate(result));
+			out << line;
+		}
+		out << "\n";
+	}
+}
+
+/**	@brief	Writes results as CSV, one row per result */
+static void writeCsv(std::ostream& out, const std::vector<BenchResult>& results) {
+	const bool segmented = !results.empty() && results.front().segments > 0;
+	out << "algorithm,distribution,size,status,trials,median_s,p90_s,min_s,ns_per_element" <<
+		(segmented ? ",segments,segments_per_s\n" : "\n");
+	for(const BenchResult& result : results) {
+		double median = percentile(result.seconds, 50);
+		char line[256];
+		snprintf(line, sizeof(line), "%s,%s,%lu,%s,%zu,%.9f,%.9f,%.9f,%.3f",
+			result.algorithm.c_str(), result.distribution.c_str(), result.size,
+			result.status.c_str(), result.seconds.size(), median,
+			percentile(result.seconds, 90), percentile(result.seconds, 0),
+			median * 1e9 / std::max<uint64_t>(result.size, 1));
+		out << line;
+		if(segmented) {
+			snprintf(line, sizeof(line), ",%lu,%.0f", result.segments, segmentRate(result));
+			out << line;
+		}
+		out << "\n";
+	}
+}
+
+/**	@brief	Writes results and run settings as a JSON document */
+static void writeJson(std::ostream& out, const std::vector<BenchResult>& results,
+	uint64_t seed, unsigned repeats, unsigned warmups) {
+	out << "{\n  \"seed\": " << seed << ",\n  \"repeats\": " << repeats <<
+		",\n  \"warmups\": " << warmups << ",\n  \"results\": [";
+	for(size_t idx = 0; idx < results.size(); idx++) {
+		const BenchResult& result = results[idx];
+		double median = percentile(result.seconds, 50);
+		char line[512];
+		snprintf(line, sizeof(line), "%s\n    {\"algorithm\": \"%s\", \"distribution\": \"%s\", "
+			"\"size\": %lu, \"status\": \"%s\", \"trials\": %zu, \"median_s\": %.9f, "
+			"\"p90_s\": %.9f, \"min_s\": %.9f, \"ns_per_element\": %.3f",
+			(idx > 0) ? "," : "", result.algorithm.c_str(), result.distribution.c_str(),
+			result.size, result.status.c_str(), result.seconds.size(), median,
+			percentile(result.seconds, 90), percentile(result.seconds, 0),
+			median * 1e9 / std::max<uint64_t>(result.size, 1));
+		out << line;
+		if(result.segments > 0) {
+			snprintf(line, sizeof(line), ", \"segments\": %lu, \"segments_per_s\": %.0f",
+				result.segments, segmentRate(result));
+			out << line;
+		}
+		out << "}";
+	}
+	out << "\n  ]\n}\n";
+}
+
+/**	@brief	Prints usage information */
+static void usage() {
+	std::cout << "Benchmark sort plugins across input sizes and distributions." << std::endl;
+	std::cout << "Usage: " << std::endl;
+	std::cout << "   isort-bench [OPTION]..." << std::endl << std::endl;
+	std::cout << "Options: " << std::endl;
+	std::cout << "  -a <list>       Comma-separated plugins (default: every plugin in $ISORT_PLUGIN_DIR," << std::endl;
+	std::cout << "                  else in the sort library's directory)." << std::endl;
+	std::cout << "  -n <list>       Comma-separated input sizes (default " << DefaultSizes << ")." << std::endl;
+	std::cout << "  -d <list>       Comma-separated distributions, as for isort -d (default all)." << std::endl;
+	std::cout << "  -s <max>        Keys are in [0, max); 0 for the full 64-bit range (default 0)." << std::endl;
+	std::cout << "  -r <count>      Timed trials per input (default " << DefaultRepeats << ")." << std::endl;
+	std::cout << "  -w <count>      Untimed warm-up trials per input (default " << DefaultWarmups << ")." << std::endl;
+	std::cout << "  -t <seconds>    A plugin whose trial exceeds this, or is projected to, skips" << std::endl;
+	std::cout << "                  larger inputs of that distribution (default " << DefaultTimeLimit << ")." << std::endl;
+	std::cout << "  -O <name=value> Tuning option for every plugin that accepts it. May be repeated." << std::endl;
+	std::cout << "  -f <format>     Output format: table (default), csv or json." << std::endl;
+	std::cout << "  -o <file>       Write results to a file rather than standard output." << std::endl;
+	std::cout << "  -g <min[:max]>  Split each input into segments of min to max keys and sort" << std::endl;
+	std::cout << "                  them with one batch call, reporting segments/s." << std::endl;
+	std::cout << "  --seed <n>      Seed for generated inputs (default 1)." << std::endl;
+	std::cout << "  -h              Displays this help information." << std::endl << std::endl;
+}
+
+/**	@brief	Benchmark program entry point
+ *	@param	argc	Number of arguments passed on command line
+ *	@param	argv	Pointer to arguments
+ *	@return On success, returns 0. Otherwise, returns 1
+ */
+int main(int argc, char** argv) {
+	std::vector<std::string> algorithms;
+	std::vector<std::string> distributions = splitList(DefaultDistributions);
+	std::vector<uint64_t> sizes;
+	std::vector<std::pair<std::string, std::string>> options;
+	uint64_t dataMax = 0;
+	uint64_t seed = 1;
+	unsigned repeats = DefaultRepeats;
+	unsigned warmups = DefaultWarmups;
+	double timeLimit = DefaultTimeLimit;
+	std::string format = "table";
+	std::string outputFileName;
+	std::string sizeList = DefaultSizes;
+	uint64_t segmentMin = 0;
+	uint64_t segmentMax = 0;
+
+	enum { OptSeed = 256 };
+	static const struct option longOptions[] = {
+		{ "seed",	required_argument,	nullptr,	OptSeed },
+		{ "help",	no_argument,				nullptr,	'h' },
+		{ nullptr,	0,								nullptr,	0 }
+	};
+
+	try {
+		int opt;
+		while((opt = getopt_long(argc, argv, "a:n:d:s:r:w:t:O:f:o:g:h", longOptions, nullptr)) != -1) {
+			switch(opt) {
+				case 'a': algorithms = splitList(optarg); break;
+				case 'n': sizeList = optarg; break;
+				case 'd': distributions = splitList(optarg); break;
+				case 's': dataMax = std::stoull(optarg); break;
+				case 'r': repeats = std::max(1UL, std::stoul(optarg)); break;
+				case 'w': warmups = std::stoul(optarg); break;
+				case 't': timeLimit = std::stod(optarg); break;
+				case 'f': format = optarg; break;
+				case 'o': outputFileName = optarg; break;
+				case OptSeed: seed = std::stoull(optarg); break;
+				case 'g': {
+					std::string range(optarg);
+					size_t colon = range.find(':');
+					segmentMin = std::stoull(range.substr(0, colon));
+					segmentMax = (colon == std::string::npos) ? segmentMin :
+						std::stoull(range.substr(colon + 1));
+					if(segmentMin == 0 || segmentMax < segmentMin)
+						throw std::invalid_argument("Invalid segment length: " + range);
+					break;
+				}
+				case 'O': {
+					std::string option(optarg);
+					size_t eq = option.find('=');
+					if(eq == std::string::npos || eq == 0)
+						throw std::invalid_argument("Expected -O name=value, got: " + option);
+					options.emplace_back(option.substr(0, eq), option.substr(eq+1));
+					break;
+				}
+				case 'h':
+				default:
+					usage();
+					return (opt == 'h') ? 0 : 1;
+			}
+		}
+		for(const std::string& size : splitList(sizeList))
+			sizes.push_back(std::stoull(size));
+		std::sort(sizes.begin(), sizes.end());
+		if(format != "table" && format != "csv" && format != "json")
+			throw std::invalid_argument("Unknown output format: " + format);
+		for(const std::string& distribution : distributions)
+			parseDistribution(distribution);
+	}
+	catch(const std::exception& e) {
+		std::cerr << "isort-bench: " << e.what() << std::endl;
+		return 1;
+	}
+
+	//Load the plugins up front; anything that does not load is not a plugin
+	bool discovered = algorithms.empty();
+	if(discovered) algorithms = discoverPlugins();
+	std::vector<SortAlgorithm*> sorters;
+	std::vector<std::string> names;
+	for(const std::string& name : algorithms) {
+		SortAlgorithm* sorter;
+		try {
+			sorter = SortAlgorithm::create(name);
+		}
+		catch(const std::exception&) {
+			if(!discovered) std::cerr << "Skipping '" << name << "': unable to load plugin" << std::endl;
+			continue;
+		}
+		for(const auto& option : options) {
+			try {
+				sorter->setOption(option.first, option.second);
+			}
+			catch(const std::exception& e) {
+				std::cerr << "Option '" << option.first << "' for '" << name << "': " <<
+					e.what() << std::endl;
+			}
+		}
+		sorters.push_back(sorter);
+		names.push_back(name);
+	}
+	if(sorters.empty()) {
+		std::cerr << "isort-bench: no plugins to benchmark" << std::endl;
+		return 1;
+	}
+
+	std::vector<BenchResult> results;
+	for(const std::string& distribution : distributions) {
+		//Per plugin: last two (size, seconds) points, and whether to skip the rest
+		std::vector<std::vector<std::pair<double, double>>> history(sorters.size());
+		std::vector<bool> skip(sorters.size(), false);
+
+		for(uint64_t size : sizes) {
+			std::vector<uint64_t> input(size);
+			DataGenerator generator(parseDistribution(distribution), size, dataMax, seed);
+			generator.generate(input.data());
+			std::pair<uint64_t, uint64_t> inputSum = checksum(input);
+			std::vector<uint64_t> work;
+			std::vector<uint64_t> offsets;
+			if(segmentMin > 0) offsets = segmentOffsets(size, segmentMin, segmentMax, seed);
+			const uint64_t segments = offsets.empty() ? 0 : offsets.size() - 1;
+
+			for(size_t idx = 0; idx < sorters.size(); idx++) {
+				BenchResult result = { names[idx], distribution, size, "ok", {}, segments };
+
+				//Project this size from the growth between the last two sizes
+				if(!skip[idx] && !history[idx].empty()) {
+					const auto& last = history[idx].back();
+					double exponent = 1;
+					if(history[idx].size() > 1) {
+						const auto& prior = history[idx][history[idx].size() - 2];
+						if(last.second > 0 && prior.second > 0)
+							exponent = std::log(last.second / prior.second) / std::log(last.first / prior.first);
+						exponent = std::clamp(exponent, 1.0, 3.0);
+					}
+					if(last.second * std::pow(size / last.first, exponent) > timeLimit)
+						skip[idx] = true;
+				}
+				if(skip[idx]) {
+					result.status = "skipped";
+					results.push_back(result);
+					continue;
+				}
+
+				try {
+					for(unsigned trial = 0; trial < warmups + repeats; trial++) {
+						//Every trial sorts a fresh copy of the same input
+						work = input;
+						auto start = steady_clock::now();
+						if(segments > 0)
+							sorters[idx]->sortSegments(work.data(), offsets.data(), segments);
+						else
+							sorters[idx]->sort(work);
+						double seconds = duration<double>(steady_clock::now() - start).count();
+
+						bool ordered = (segments > 0) ? segmentsSorted(work, offsets) :
+							std::is_sorted(work.begin(), work.end());
+						if(trial == 0 && (work.size() != size || !ordered || checksum(work) != inputSum)) {
+							result.status = "unsorted";
+							skip[idx] = true;
+							break;
+						}
+						if(trial >= warmups) result.seconds.push_back(seconds);
+						if(seconds > timeLimit) {
+							//Keep what was measured, but stop here
+							if(result.seconds.empty()) result.seconds.push_back(seconds);
+							result.status = "timeout";
+							skip[idx] = true;
+							break;
+						}
+					}
+				}
+				catch(...) {
+					result.status = "failed";
+					skip[idx] = true;
+				}
+
+				if(!result.seconds.empty())
+					history[idx].emplace_back((double) std::max<uint64_t>(size, 1),
+						percentile(result.seconds, 50));
+				std::cerr << names[idx] << " " << distribution << " " << size << ": " <<
+					result.status << std::endl;
+				results.push_back(result);
+			}
+		}
+	}
+
+	for(SortAlgorithm*& sorter : sorters)
+		SortAlgorithm::destroy(sorter);
+
+	//Report
+	std::ofstream file;
+	if(!outputFileName.empty()) {
+		file.open(outputFileName);
+		if(!file) {
+			std::cerr << "isort-bench: unable to open '" << outputFileName << "'" << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& out = outputFileName.empty() ? std::cout : file;
+	if(format == "csv") writeCsv(out, results);
+	else if(format == "json") writeJson(out, results, seed, repeats, warmups);
+	else writeTable(out, results);
+
+	return 0;
+}
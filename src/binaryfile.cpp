@@ -0,0 +1,253 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+//Library includes
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+//Project includes
+#include "binaryfile.h"
+
+namespace JAC::Integer {
+
+//Largest single pwrite() request; Linux transfers at most ~2 GB per call
+static const size_t MaxWriteBytes = 1UL << 30;
+
+/**	@brief	Builds a header in file byte order
+ *	@param	count		Number of keys in the file
+ *	@param	sorted	True if the keys are in ascending order
+ */
+BinaryKeyHeader makeBinaryHeader(uint64_t count, bool sorted) {
+	BinaryKeyHeader header;
+	std::memcpy(header.magic, BinaryKeyHeader::Magic, sizeof(header.magic));
+	header.version = littleEndian(BinaryKeyHeader::CurrentVersion);
+	header.flags = littleEndian(sorted ? BinaryKeyHeader::SortedFlag : 0U);
+	header.count = littleEndian(count);
+	header.reserved = 0;
+	return header;
+}
+
+/**	@brief	Validates a header read from a file and converts it to host order
+ *	@param	header	The header as read from the file; converted in place
+ *	@param	path		The file path, for diagnostics
+ *	@throws	std::runtime_error	If the header is not a supported binary key header
+ */
+void checkBinaryHeader(BinaryKeyHeader& header, const std::string& path) {
+	if(std::memcmp(header.magic, BinaryKeyHeader::Magic, sizeof(header.magic)) != 0)
+		throw std::runtime_error("'" + path + "' is not a binary key file");
+
+	header.version = littleEndian(header.version);
+	header.flags = littleEndian(header.flags);
+	header.count = littleEndian(header.count);
+	if(header.version != BinaryKeyHeader::CurrentVersion)
+		throw std::runtime_error("'" + path + "' has unsupported binary format version " +
+			std::to_string(header.version));
+}
+
+/**	@brief	Determines whether a path names a binary key file by extension
+ *	@param	path	The file path
+ *	@return	True if the path ends in ".bin"
+ */
+bool hasBinaryExtension(const std::string& path) {
+	static const std::string extension = ".bin";
+	return path.size() > extension.size() &&
+		path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/**	@brief	Determines whether a file starts with the binary key file magic
+ *	@param	path	The file path
+ *	@return	True if the file exists and starts with BinaryKeyHeader::Magic
+ */
+bool isBinaryKeyFile(const std::string& path) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) return false;
+
+	char magic[sizeof(BinaryKeyHeader::Magic)];
+	ssize_t bytes = ::pread(fd, magic, sizeof(magic), 0);
+	::close(fd);
+	return bytes == (ssize_t) sizeof(magic) &&
+		std::memcmp(magic, BinaryKeyHeader::Magic, sizeof(magic)) == 0;
+}
+
+/**	@brief	Opens an output file without disturbing the file it replaces
+ *	@param	path		The output file
+ *	@param	target	Receives the file to replace: path, with symbolic links resolved
+ *	@param	temp		Receives the temporary file, or is cleared if path is open
+ *	@return	A descriptor open for writing
+ *	@throws	std::runtime_error	If the file cannot be created
+ */
+int openOutputFile(const std::string& path, std::string& target, std::string& temp) {
+	target = path;
+	temp.clear();
+
+	struct stat st;
+	char resolved[PATH_MAX];
+	if(::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+		::realpath(path.c_str(), resolved) != nullptr) {
+		//Beside the target, so the rename stays on one file system
+		target = resolved;
+		std::string pattern = target + ".XXXXXX";
+		int fd = ::mkstemp(pattern.data());
+		if(fd < 0)
+			throw std::runtime_error("Unable to create a temporary file for '" + path + "': " +
+				strerror(errno));
+		::fchmod(fd, st.st_mode & 07777);
+		temp = pattern;
+		return fd;
+	}
+
+	int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		throw std::runtime_error("Unable to open output file '" + path + "': " +
+			strerror(errno));
+	return fd;
+}
+
+/**	@brief	Renames a complete temporary output over its target
+ *	@param	target	The file to replace
+ *	@param	temp		The temporary file, closed; cleared on return
+ *	@throws	std::runtime_error	If the rename fails, which removes temp
+ */
+void replaceOutputFile(const std::string& target, std::string& temp) {
+	if(temp.empty()) return;
+	if(::rename(temp.c_str(), target.c_str()) != 0) {
+		int error = errno;
+		discardOutputFile(temp);
+		throw std::runtime_error("Unable to replace '" + target + "': " + strerror(error));
+	}
+	temp.clear();
+}
+
+/**	@brief	Removes an incomplete temporary output, leaving its target alone
+ *	@param	temp		The temporary file, or empty; cleared on return
+ */
+void discardOutputFile(std::string& temp) {
+	if(!temp.empty()) ::unlink(temp.c_str());
+	temp.clear();
+}
+
+/**	@brief	Writes keys to a binary key file with a single large write
+ *	@param	path		The file to create or replace
+ *	@param	keys		The keys to write
+ *	@param	count		Number of keys
+ *	@param	sorted	True if the keys are in ascending order
+ *	@throws	std::runtime_error	On I/O errors
+ */
+void writeBinaryKeys(const std::string& path, const uint64_t* keys, size_t count,
+	bool sorted) {
+	std::string target, temp;
+	int fd = openOutputFile(path, target, temp);
+
+	BinaryKeyHeader header = makeBinaryHeader(count, sorted);
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	//Keys are stored little-endian; swap a copy on big-endian hosts
+	std::vector<uint64_t> swapped(keys, keys + count);
+	for(uint64_t& key : swapped) key = littleEndian(key);
+	keys = swapped.data();
+#endif
+
+	const char* data = (const char*) keys;
+	uint64_t remaining = (uint64_t) count * sizeof(uint64_t);
+	off_t offset = sizeof(header);
+	bool ok = ::pwrite(fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header);
+	while(ok && remaining > 0) {
+		ssize_t written = ::pwrite(fd, data, std::min<uint64_t>(remaining, MaxWriteBytes), offset);
+		if(written < 0 && errno == EINTR) continue;
+		ok = written > 0;
+		if(ok) {
+			data += written;
+			offset += written;
+			remaining -= written;
+		}
+	}
+
+	int error = errno;
+	if(::close(fd) != 0 && ok) {
+		ok = false;
+		error = errno;
+	}
+	if(!ok) {
+		discardOutputFile(temp);
+		throw std::runtime_error("Error writing '" + path + "': " + strerror(error));
+	}
+	replaceOutputFile(target, temp);
+}
+
+/**	@brief	Maps a binary key file
+ *	@param	path	The file to map
+ *	@throws	std::runtime_error	If the file cannot be mapped or is not a key file
+ */
+MappedKeyFile::MappedKeyFile(const std::string& path) :
+	path_(path),
+	map_(MAP_FAILED),
+	mapBytes_(0),
+	keys_(nullptr) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		throw std::runtime_error("Unable to open input file '" + path + "': " +
+			strerror(errno));
+
+	struct stat st;
+	if(::fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(BinaryKeyHeader)) {
+		::close(fd);
+		throw std::runtime_error("'" + path + "' is not a binary key file");
+	}
+	mapBytes_ = st.st_size;
+
+	//Private, writable mapping: pages are only copied if modified
+	map_ = ::mmap(nullptr, mapBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE,
+		fd, 0);
+	::close(fd);
+	if(map_ == MAP_FAILED)
+		throw std::runtime_error("Unable to map '" + path + "': " + strerror(errno));
+
+	std::memcpy(&header_, map_, sizeof(header_));
+	try {
+		checkBinaryHeader(header_, path_);
+		if(header_.count > (mapBytes_ - sizeof(header_)) / sizeof(uint64_t))
+			throw std::runtime_error("'" + path + "' is truncated");
+	}
+	catch(...) {
+		::munmap(map_, mapBytes_);
+		map_ = MAP_FAILED;
+		throw;
+	}
+	keys_ = (uint64_t*) ((char*) map_ + sizeof(BinaryKeyHeader));
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	for(size_t idx = 0; idx < count(); idx++) keys_[idx] = littleEndian(keys_[idx]);
+#endif
+}
+
+/**	@brief	Destructor, unmaps the file */
+MappedKeyFile::~MappedKeyFile() {
+	if(map_ != MAP_FAILED) ::munmap(map_, mapBytes_);
+}
+
+}; //End namespace
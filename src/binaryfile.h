@@ -0,0 +1,175 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _BINARYFILE_INCLUDED
+#define _BINARYFILE_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace JAC::Integer {
+
+/**	@brief	Header at the start of a binary key file
+ *	All fields, like the keys that follow, are stored little-endian. The
+ *	header is 32 bytes so the key array that follows stays 8-byte aligned
+ *	when the file is mapped.
+ */
+struct BinaryKeyHeader {
+	//File identifier
+	static constexpr char Magic[8] = { 'I', 'S', 'O', 'R', 'T', 'U', '6', '4' };
+
+	//Current format version
+	static constexpr uint32_t CurrentVersion = 1;
+
+	//Flag bits
+	static constexpr uint32_t SortedFlag = 1U << 0;
+
+	char			magic[8];			/*! Magic, see Magic */
+	uint32_t	version;			/*! Format version */
+	uint32_t	flags;				/*! Flag bits (ie: SortedFlag) */
+	uint64_t	count;				/*! Number of keys following the header */
+	uint64_t	reserved;			/*! Zero */
+};
+static_assert(sizeof(BinaryKeyHeader) == 32, "Binary key header must be 32 bytes");
+
+/**	@brief	Converts between host and little-endian (file) byte order */
+inline uint64_t littleEndian(uint64_t val) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return __builtin_bswap64(val);
+#else
+	return val;
+#endif
+}
+
+/**	@brief	Converts between host and little-endian (file) byte order */
+inline uint32_t littleEndian(uint32_t val) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return __builtin_bswap32(val);
+#else
+	return val;
+#endif
+}
+
+/**	@brief	Builds a header in file byte order
+ *	@param	count		Number of keys in the file
+ *	@param	sorted	True if the keys are in ascending order
+ */
+BinaryKeyHeader makeBinaryHeader(uint64_t count, bool sorted);
+
+/**	@brief	Validates a header read from a file and converts it to host order
+ *	@param	header	The header as read from the file; converted in place
+ *	@param	path		The file path, for diagnostics
+ *	@throws	std::runtime_error	If the header is not a supported binary key header
+ */
+void checkBinaryHeader(BinaryKeyHeader& header, const std::string& path);
+
+/**	@brief	Determines whether a path names a binary key file by extension
+ *	@param	path	The file path
+ *	@return	True if the path ends in ".bin"
+ */
+bool hasBinaryExtension(const std::string& path);
+
+/**	@brief	Determines whether a file starts with the binary key file magic
+ *	@param	path	The file path
+ *	@return	True if the file exists and starts with BinaryKeyHeader::Magic
+ */
+bool isBinaryKeyFile(const std::string& path);
+
+/**	@brief	Opens an output file without disturbing the file it replaces
+ *	An existing regular file may still be an input (ie: mapped or streamed),
+ *	so the output goes to a temporary file beside it, with its permissions,
+ *	that replaceOutputFile() renames over it once complete. New files and
+ *	anything else (ie: /dev/null) are opened directly.
+ *	@param	path		The output file
+ *	@param	target	Receives the file to replace: path, with symbolic links resolved
+ *	@param	temp		Receives the temporary file, or is cleared if path is open
+ *	@return	A descriptor open for writing
+ *	@throws	std::runtime_error	If the file cannot be created
+ */
+int openOutputFile(const std::string& path, std::string& target, std::string& temp);
+
+/**	@brief	Renames a complete temporary output over its target
+ *	Does nothing if the output was opened directly.
+ *	@param	target	The file to replace
+ *	@param	temp		The temporary file, closed; cleared on return
+ *	@throws	std::runtime_error	If the rename fails, which removes temp
+ */
+void replaceOutputFile(const std::string& target, std::string& temp);
+
+/**	@brief	Removes an incomplete temporary output, leaving its target alone
+ *	@param	temp		The temporary file, or empty; cleared on return
+ */
+void discardOutputFile(std::string& temp);
+
+/**	@brief	Writes keys to a binary key file with a single large write
+ *	The file is replaced only once every key is written (see openOutputFile()),
+ *	so the keys may come from a mapping of the same file.
+ *	@param	path		The file to create or replace
+ *	@param	keys		The keys to write
+ *	@param	count		Number of keys
+ *	@param	sorted	True if the keys are in ascending order
+ *	@throws	std::runtime_error	On I/O errors
+ */
+void writeBinaryKeys(const std::string& path, const uint64_t* keys, size_t count,
+	bool sorted);
+
+/**	@brief	Read-only view of a binary key file through a private mapping
+ *	The file is mapped copy-on-write, so keys may be modified (ie: sorted) in
+ *	place without parsing, copying up front, or changing the file on disk.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class MappedKeyFile {
+public:
+	/**	@brief	Maps a binary key file
+	 *	@param	path	The file to map
+	 *	@throws	std::runtime_error	If the file cannot be mapped or is not a key file
+	 */
+	explicit MappedKeyFile(const std::string& path);
+
+	/**	@brief	Destructor, unmaps the file */
+	virtual ~MappedKeyFile();
+
+	MappedKeyFile(const MappedKeyFile&) = delete;
+	MappedKeyFile& operator=(const MappedKeyFile&) = delete;
+
+	/**	@brief	The keys, in host byte order */
+	inline uint64_t* data() { return keys_; }
+
+	/**	@brief	The keys, in host byte order */
+	inline const uint64_t* data() const { return keys_; }
+
+	/**	@brief	Number of keys in the file */
+	inline size_t count() const { return (size_t) header_.count; }
+
+	/**	@brief	True if the file header marks the keys as sorted */
+	inline bool sorted() const { return (header_.flags & BinaryKeyHeader::SortedFlag) != 0; }
+
+private:
+	std::string				path_;			/*! Path to the mapped file */
+	BinaryKeyHeader		header_;		/*! Header, in host byte order */
+	void*							map_;				/*! Start of the mapping */
+	size_t						mapBytes_;	/*! Length of the mapping */
+	uint64_t*					keys_;			/*! First key in the mapping */
+};
+
+}; //End namespace
+
+#endif //Include once
@@ -38,23 +38,42 @@ extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
 	obj = nullptr;
 }
 
+/**	@brief	Describes the bubble sort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		true,	//Stable
+		true,	//In place
+		false,	//Parallel
+		0.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth64,	//Key widths
+		0,	//Min keys
+		1 << 10,	//Max keys
+		"Bubble sort, for small or nearly sorted inputs"
+	};
+	return &caps;
+}
+
 namespace JAC::Integer {
 
-/** @brief	Implementation-specific sort method for arrays of unsigned LL
- *	@param	arr	A std::vector<uint64_t> of values to be sorted
- *	@return	A std::vector<uint64_t> containing the values from arr in sorted order
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
  */
-SortAlgorithm::IntVector_t BubbleSort::sort(SortAlgorithm::IntVector_t& arr) {
-	IntVectorIterator_t itr;
+void BubbleSort::sort(uint64_t* keys, size_t count) {
+	if(count < 2) return;
+
+	uint64_t* itr;
 	do {
 		swapped_ = false;
-		for(itr = arr.begin(); itr != arr.end()-1; itr++) {
+		for(itr = keys; itr != keys+count-1; itr++) {
 			if((*itr) > (*(itr+1))) {
 				swap(itr, itr+1);
 			}
 		}
 	} while(swapped_ == true);
-	return arr;
 }
 
 }; //End namespace
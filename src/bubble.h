@@ -46,14 +46,16 @@ public:
 	/**	@brief	Destructor */
 	virtual ~BubbleSort() {};
 
-	/** @brief	Implementation-specific sort method for arrays of unsigned LL
-	 *	@param	arr	A std::vector<uint64_t> of values to be sorted
-	 *	@return	A std::vector<uint64_t> containing the values from arr in sorted order
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
 	 */
-	IntVector_t sort(IntVector_t& arr) override;
+	void sort(uint64_t* keys, size_t count) override;
 
 protected:
-	inline void swap(IntVectorIterator_t left, IntVectorIterator_t right) {
+	inline void swap(uint64_t* left, uint64_t* right) {
 		uint64_t temp = *left;
 		*left = *right;
 		*right = temp;
@@ -0,0 +1,444 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+//Project includes
+#include "counting.h"
+#include "parallel.h"
+#include "unique.h"
+
+/**	@brief	Create instance of the counting sort class from shared object
+ *	@return	A new instance of CountingSort as Sorter*
+ */
+extern "C" JAC::Integer::SortAlgorithm* create() {
+	return new JAC::Integer::CountingSort();
+}
+
+/**	@brief	Deletes the specified instance of a CountingSort, allocated by this module
+ *	@param	val	Pointer to a CountingSort that was allocated by this module's
+ * 							CreateInstance() function
+ */
+extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
+	if(obj != nullptr) delete obj;
+	obj = nullptr;
+}
+
+/**	@brief	Describes the counting sort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		false,	//Stable
+		true,	//In place
+		true,	//Parallel
+		0.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth64,	//Key widths
+		1 << 10,	//Min keys
+		0,	//Max keys
+		"Parallel counting sort for narrow or highly repetitive keys"
+	};
+	return &caps;
+}
+
+namespace JAC::Integer {
+
+/**	@brief	Parses an unsigned option value
+ *	@param	name	The option name, for the error message
+ *	@param	value	The option value as text
+ *	@throws	std::invalid_argument	If value is not a number
+ */
+static uint64_t parseCount(const std::string& name, const std::string& value) {
+	size_t used = 0;
+	uint64_t parsed = 0;
+	try {
+		parsed = std::stoull(value, &used);
+	}
+	catch(const std::exception&) {
+		used = 0;
+	}
+	if(used == 0 || used != value.size())
+		throw std::invalid_argument("Invalid value for " + name + ": " + value);
+	return parsed;
+}
+
+/**	@brief	Default constructor */
+CountingSort::CountingSort() {
+}
+
+/**	@brief	Destructor */
+CountingSort::~CountingSort() {
+}
+
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+ */
+void CountingSort::sort(uint64_t* keys, size_t count) {
+	countSort(keys, count, false, nullptr);
+}
+
+/**	@brief	Counting sort that writes each distinct key once instead of filling
+ *	@param	keys		Keys to sort; the distinct keys are left at the front
+ *	@param	count		Number of keys
+ *	@return	The number of distinct keys
+ *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+ */
+size_t CountingSort::sortUnique(uint64_t* keys, size_t count) {
+	return countSort(keys, count, true, nullptr);
+}
+
+/**	@brief	Counting sort that writes each distinct key once with its count
+ *	@param	keys		Keys to sort; the distinct keys are left at the front
+ *	@param	count		Number of keys
+ *	@param	counts	Receives the occurrences of each distinct key; at least
+ *									count elements
+ *	@return	The number of distinct keys
+ *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+ */
+size_t CountingSort::sortCounted(uint64_t* keys, size_t count, uint64_t* counts) {
+	return countSort(keys, count, true, counts);
+}
+
+/**	@brief	Sorts keys, either rewriting every key or only the distinct ones
+ *	@param	keys					Keys to sort
+ *	@param	count					Number of keys
+ *	@param	collapse			True to write each distinct key once
+ *	@param	multiplicity	Receives the count of each distinct key when collapsing,
+ *												or nullptr
+ *	@return	The number of keys written: count, or the number of distinct keys
+ *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+ */
+size_t CountingSort::countSort(uint64_t* keys, size_t count, bool collapse,
+	uint64_t* multiplicity) {
+	//Nothing to do for empty or single-value arrays
+	if(count < 2)
+		return collapse ? collapseRuns(keys, count, multiplicity) : count;
+
+	//Limit threads so every block is worth the thread
+	size_t threads = (threads_ > 0) ? threads_ : defaultThreads();
+	threads = std::max<size_t>(1, std::min(threads, count / MinKeysPerThread));
+
+	//Key range
+	std::vector<uint64_t> mins(threads), maxs(threads);
+	parallelFor((unsigned) threads, [&](unsigned tid) {
+		const uint64_t* begin = keys + count * tid / threads;
+		const uint64_t* end = keys + count * (tid+1) / threads;
+		auto range = std::minmax_element(begin, end);
+		mins[tid] = *range.first;
+		maxs[tid] = *range.second;
+	});
+	const uint64_t minKey = *std::min_element(mins.begin(), mins.end());
+	const uint64_t range = *std::max_element(maxs.begin(), maxs.end()) - minKey;
+	if(range == 0) {
+		if(!collapse) return count;
+		if(multiplicity != nullptr) multiplicity[0] = count;
+		return 1;
+	}
+
+	//Dense when the histograms are no bigger than the input and fit the budget;
+	//one histogram per thread plus the merged counts
+	if(range < maxRange_ && range < count * DenseBucketsPerKey) {
+		const uint64_t buckets = range + 1;
+		uint64_t fits = maxBytes_ / (buckets * sizeof(uint64_t));
+		if(fits >= 2)
+			return denseSort(keys, count, minKey, buckets,
+				(unsigned) std::min<uint64_t>(threads, fits - 1), collapse, multiplicity);
+	}
+
+	size_t written = count;
+	if(sparseSort(keys, count, (unsigned) threads, collapse, multiplicity, written))
+		return written;
+	return delegate(keys, count, "too many distinct keys to count", collapse, multiplicity);
+}
+
+/**	@brief	Sets a counting sort tuning option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True if the option is recognized, otherwise false
+ *	@throws	std::invalid_argument	On an invalid value for a recognized option
+ */
+bool CountingSort::setOption(const std::string& name, const std::string& value) {
+	if(name == "threads")
+		threads_ = (unsigned) parseCount(name, value);
+	else if(name == "max-range")
+		maxRange_ = parseCount(name, value);
+	else if(name == "max-distinct")
+		maxDistinct_ = parseCount(name, value);
+	else if(name == "max-bytes")
+		maxBytes_ = parseCount(name, value);
+	else if(name == "fallback")
+		fallback_ = (value == "none") ? "" : value;
+	else
+		return false;
+	return true;
+}
+
+/**	@brief	Sorts with one dense histogram per thread
+ *	@param	data		Keys to sort
+ *	@param	length	Number of keys
+ *	@param	minKey	Smallest key
+ *	@param	buckets	Buckets per histogram, maxKey - minKey + 1
+ *	@param	threads	Number of threads to use
+ *	@param	collapse			True to write each distinct key once
+ *	@param	multiplicity	Receives the count of each distinct key, or nullptr
+ *	@return	The number of keys written
+ */
+size_t CountingSort::denseSort(uint64_t* data, size_t length, uint64_t minKey,
+	uint64_t buckets, unsigned threads, bool collapse, uint64_t* multiplicity) {
+	Count_t counts(buckets * threads, 0);
+	Count_t starts(buckets + 1);
+
+	//Histogram of each block
+	parallelFor(threads, [&](unsigned tid) {
+		uint64_t* hist = counts.data() + buckets * tid;
+		const uint64_t* end = data + length * (tid+1) / threads;
+		for(const uint64_t* key = data + length * tid / threads; key < end; key++)
+			hist[*key - minKey]++;
+	});
+
+	//Merge the histograms, each thread summing its own range of buckets
+	parallelFor(threads, [&](unsigned tid) {
+		const uint64_t begin = buckets * tid / threads;
+		const uint64_t end = buckets * (tid+1) / threads;
+		std::copy(counts.begin() + begin, counts.begin() + end, starts.begin() + begin);
+		for(unsigned t = 1; t < threads; t++) {
+			const uint64_t* hist = counts.data() + buckets * t;
+			for(uint64_t bucket = begin; bucket < end; bucket++)
+				starts[bucket] += hist[bucket];
+		}
+	});
+
+	//Output position of each key's run
+	uint64_t run = 0;
+	for(uint64_t bucket = 0; bucket < buckets; bucket++) {
+		uint64_t count = starts[bucket];
+		starts[bucket] = run;
+		run += count;
+	}
+	starts[buckets] = run;
+
+	if(collapse)
+		return writeRuns(data, nullptr, minKey, starts.data(), buckets, multiplicity);
+	fill(data, length, nullptr, minKey, starts.data(), buckets, threads);
+	return length;
+}
+
+/**	@brief	Sorts with one hashed histogram per thread
+ *	@param	data		Keys to sort
+ *	@param	length	Number of keys
+ *	@param	threads	Number of threads to use
+ *	@param	collapse			True to write each distinct key once
+ *	@param	multiplicity	Receives the count of each distinct key, or nullptr
+ *	@param	written				Receives the number of keys written
+ *	@return	False, leaving data unchanged, if there are too many distinct keys
+ */
+bool CountingSort::sparseSort(uint64_t* data, size_t length, unsigned threads,
+	bool collapse, uint64_t* multiplicity, size_t& written) {
+	//Distinct keys per thread; tables are kept at most half full
+	const uint64_t limit = std::min(maxDistinct_,
+		maxBytes_ / (threads * sizeof(Slot) * 2));
+
+	std::vector<SlotTable_t> tables(threads);
+	Count_t empties(threads, 0);
+	std::atomic<bool> overflow(false);
+
+	parallelFor(threads, [&](unsigned tid) {
+		SlotTable_t& table = tables[tid];
+		table.assign(InitialSlots, Slot{ EmptyKey, 0 });
+		unsigned bits = __builtin_ctzll(InitialSlots);
+		uint64_t used = 0;
+		uint64_t empty = 0;
+
+		const uint64_t* begin = data + length * tid / threads;
+		const uint64_t* end = data + length * (tid+1) / threads;
+		for(const uint64_t* pos = begin; pos < end; pos++) {
+			const uint64_t key = *pos;
+			const size_t done = pos - begin;
+			if(done % CheckKeys == 0 && done > 0) {
+				//Counting only pays off if keys repeat; stop as soon as they do not
+				if(used * 2 > done || overflow.load(std::memory_order_relaxed)) {
+					overflow = true;
+					return;
+				}
+			}
+			if(key == EmptyKey) {
+				empty++;
+				continue;
+			}
+
+			size_t mask = table.size() - 1;
+			size_t slot = (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+			while(table[slot].key != key && table[slot].key != EmptyKey)
+				slot = (slot + 1) & mask;
+			if(table[slot].key == key) {
+				table[slot].count++;
+				continue;
+			}
+			table[slot] = { key, 1 };
+			if(++used * 2 <= table.size())
+				continue;
+
+			//Grow, unless that would pass the limit
+			if(used > limit) {
+				overflow = true;
+				return;
+			}
+			SlotTable_t grown(table.size() * 2, Slot{ EmptyKey, 0 });
+			bits++;
+			mask = grown.size() - 1;
+			for(const Slot& entry : table) {
+				if(entry.key == EmptyKey) continue;
+				slot = (size_t) ((entry.key * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+				while(grown[slot].key != EmptyKey)
+					slot = (slot + 1) & mask;
+				grown[slot] = entry;
+			}
+			table.swap(grown);
+		}
+		empties[tid] = empty;
+	});
+	if(overflow)
+		return false;
+
+	//Merge the tables into sorted distinct keys and their counts
+	SlotTable_t entries;
+	uint64_t empty = 0;
+	for(unsigned tid = 0; tid < threads; tid++) {
+		empty += empties[tid];
+		for(const Slot& entry : tables[tid]) {
+			if(entry.key != EmptyKey) entries.push_back(entry);
+		}
+		SlotTable_t().swap(tables[tid]);
+	}
+	if(empty > 0) entries.push_back({ EmptyKey, empty });
+	std::sort(entries.begin(), entries.end(),
+		[](const Slot& lhs, const Slot& rhs) { return lhs.key < rhs.key; });
+
+	Count_t keys;
+	Count_t starts;
+	keys.reserve(entries.size());
+	starts.reserve(entries.size() + 1);
+	uint64_t run = 0;
+	for(size_t idx = 0; idx < entries.size(); idx++) {
+		if(idx == 0 || entries[idx].key != entries[idx-1].key) {
+			keys.push_back(entries[idx].key);
+			starts.push_back(run);
+		}
+		run += entries[idx].count;
+	}
+	starts.push_back(run);
+
+	if(collapse) {
+		written = writeRuns(data, keys.data(), 0, starts.data(), keys.size(), multiplicity);
+		return true;
+	}
+	fill(data, length, keys.data(), 0, starts.data(), keys.size(), threads);
+	written = length;
+	return true;
+}
+
+/**	@brief	Rewrites the keys in order from merged counts
+ *	@param	data		Output, length keys
+ *	@param	length	Number of keys
+ *	@param	keys		Distinct keys in ascending order; nullptr for base + index
+ *	@param	base		Key of the first bucket when keys is nullptr
+ *	@param	starts	Output position of each key's run, plus length at the end
+ *	@param	count		Number of distinct keys
+ *	@param	threads	Number of threads to use
+ */
+void CountingSort::fill(uint64_t* data, size_t length, const uint64_t* keys,
+	uint64_t base, const uint64_t* starts, size_t count, unsigned threads) {
+	parallelFor(threads, [&](unsigned tid) {
+		size_t pos = length * tid / threads;
+		const size_t end = length * (tid+1) / threads;
+		if(pos == end) return;
+
+		//The run covering the start of this share
+		size_t idx = std::upper_bound(starts, starts + count + 1, pos) - starts - 1;
+		while(pos < end) {
+			size_t runEnd = std::min<size_t>(starts[idx+1], end);
+			std::fill(data + pos, data + runEnd, (keys != nullptr) ? keys[idx] : base + idx);
+			pos = runEnd;
+			idx++;
+		}
+	});
+}
+
+/**	@brief	Writes each key with a non-empty run once, in order
+ *	@param	data					Output, one key per non-empty run
+ *	@param	keys					Distinct keys in ascending order; nullptr for base + index
+ *	@param	base					Key of the first bucket when keys is nullptr
+ *	@param	starts				Output position of each key's run, plus length at the end
+ *	@param	count					Number of runs
+ *	@param	multiplicity	Receives the length of each non-empty run, or nullptr
+ *	@return	The number of keys written
+ */
+size_t CountingSort::writeRuns(uint64_t* data, const uint64_t* keys, uint64_t base,
+	const uint64_t* starts, size_t count, uint64_t* multiplicity) {
+	size_t distinct = 0;
+	for(size_t idx = 0; idx < count; idx++) {
+		const uint64_t run = starts[idx+1] - starts[idx];
+		if(run == 0) continue;
+		data[distinct] = (keys != nullptr) ? keys[idx] : base + idx;
+		if(multiplicity != nullptr) multiplicity[distinct] = run;
+		distinct++;
+	}
+	return distinct;
+}
+
+/**	@brief	Sorts with the fallback plugin
+ *	@param	keys					The keys, sorted in place
+ *	@param	count					Number of keys
+ *	@param	why						Reason the keys cannot be counted, for the error if there is no fallback
+ *	@param	collapse			True to keep one copy of each key
+ *	@param	multiplicity	Receives the count of each distinct key when collapsing,
+ *												or nullptr
+ *	@return	The number of keys written: count, or the number of distinct keys
+ *	@throws	std::runtime_error	If there is no fallback
+ */
+size_t CountingSort::delegate(uint64_t* keys, size_t count, const std::string& why,
+	bool collapse, uint64_t* multiplicity) {
+	if(fallback_.empty())
+		throw std::runtime_error("counting: " + why + " and no fallback is set");
+
+	SortAlgorithm* fallback = SortAlgorithm::create(fallback_);
+	try {
+		if(threads_ > 0)
+			fallback->setOption("threads", std::to_string(threads_));
+		if(!collapse)
+			fallback->sort(keys, count);
+		else if(multiplicity == nullptr)
+			count = fallback->sortUnique(keys, count);
+		else
+			count = fallback->sortCounted(keys, count, multiplicity);
+	}
+	catch(...) {
+		SortAlgorithm::destroy(fallback);
+		throw;
+	}
+	SortAlgorithm::destroy(fallback);
+	return count;
+}
+
+}; //End namespace
@@ -0,0 +1,233 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _COUNTING_INCLUDED
+#define _COUNTING_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <string>
+#include <vector>
+//Project includes
+#include "sortalgorithm.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Counting sort implementation for sorting library
+ *	Suited to inputs whose keys span a small range, or repeat heavily,
+ *	compared with the number of keys. One parallel pass builds a histogram
+ *	per thread and a second parallel pass rewrites the keys in order from
+ *	the merged counts, each thread filling an equal share of the output.
+ *
+ *	Narrow ranges use a dense histogram indexed by key - min. Wider ranges
+ *	use a hashed histogram of the distinct keys, which is abandoned as soon
+ *	as the keys turn out to be mostly distinct. Inputs that fit neither
+ *	within the memory budget are handed to a fallback plugin.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class CountingSort : public SortAlgorithm {
+private:
+	//Container of counters
+	typedef std::vector<uint64_t>		Count_t;
+
+	//One hashed histogram entry
+	struct Slot {
+		uint64_t	key;			/*! The key; EmptyKey in an unused slot */
+		uint64_t	count;		/*! Occurrences of key */
+	};
+
+	//Hashed histogram, open addressing with linear probing
+	typedef std::vector<Slot>				SlotTable_t;
+
+	//Key marking an unused slot; occurrences of it are counted separately
+	static constexpr uint64_t EmptyKey = 0;
+
+	//Below this many keys per thread fewer threads are used
+	static constexpr size_t MinKeysPerThread = 1 << 16;
+
+	//A dense histogram may have at most this many buckets per key
+	static constexpr uint64_t DenseBucketsPerKey = 4;
+
+	//Initial slots in a hashed histogram
+	static constexpr size_t InitialSlots = 1 << 10;
+
+	//Keys hashed before checking that the input repeats enough to pay off
+	static constexpr size_t CheckKeys = 1 << 16;
+
+public:
+	//Default largest dense histogram, in buckets
+	static constexpr uint64_t DefaultMaxRange = 1 << 24;
+
+	//Default largest number of distinct keys in a hashed histogram
+	static constexpr uint64_t DefaultMaxDistinct = 1 << 20;
+
+	//Default memory budget for all histograms, in bytes
+	static constexpr uint64_t DefaultMaxBytes = 256 << 20;
+
+private:
+	//The sort type string
+	std::string 			type_ = "counting";
+
+	//Number of threads to use, 0 for the default
+	unsigned					threads_ = 0;
+
+	//Largest dense histogram, in buckets
+	uint64_t					maxRange_ = DefaultMaxRange;
+
+	//Largest number of distinct keys in a hashed histogram
+	uint64_t					maxDistinct_ = DefaultMaxDistinct;
+
+	//Memory budget for all histograms, in bytes
+	uint64_t					maxBytes_ = DefaultMaxBytes;
+
+	//Plugin for inputs that cannot be counted, empty to refuse them
+	std::string				fallback_ = "radix";
+
+public:
+	/**	@brief	Default constructor */
+	CountingSort();
+
+	/**	@brief	Destructor */
+	virtual ~CountingSort();
+
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+	 */
+	void sort(uint64_t* keys, size_t count) override;
+
+	/**	@brief	Counting sort that writes each distinct key once instead of filling
+	 *	@param	keys		Keys to sort; the distinct keys are left at the front
+	 *	@param	count		Number of keys
+	 *	@return	The number of distinct keys
+	 *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+	 */
+	size_t sortUnique(uint64_t* keys, size_t count) override;
+
+	/**	@brief	Counting sort that writes each distinct key once with its count
+	 *	@param	keys		Keys to sort; the distinct keys are left at the front
+	 *	@param	count		Number of keys
+	 *	@param	counts	Receives the occurrences of each distinct key; at least
+	 *									count elements
+	 *	@return	The number of distinct keys
+	 *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+	 */
+	size_t sortCounted(uint64_t* keys, size_t count, uint64_t* counts) override;
+
+	/**	@brief	Sets a counting sort tuning option
+	 *	Recognized options:
+	 *		threads				Number of threads, 0 for the default
+	 *		max-range			Largest dense histogram, in buckets
+	 *		max-distinct	Largest number of distinct keys counted by hashing
+	 *		max-bytes			Memory budget for all histograms, in bytes
+	 *		fallback			Plugin for inputs that cannot be counted, or "none"
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized, otherwise false
+	 *	@throws	std::invalid_argument	On an invalid value for a recognized option
+	 */
+	bool setOption(const std::string& name, const std::string& value) override;
+
+private:
+	/**	@brief	Sorts keys, either rewriting every key or only the distinct ones
+	 *	@param	keys					Keys to sort
+	 *	@param	count					Number of keys
+	 *	@param	collapse			True to write each distinct key once
+	 *	@param	multiplicity	Receives the count of each distinct key when collapsing,
+	 *												or nullptr
+	 *	@return	The number of keys written: count, or the number of distinct keys
+	 *	@throws	std::runtime_error	If the input cannot be counted and there is no fallback
+	 */
+	size_t countSort(uint64_t* keys, size_t count, bool collapse, uint64_t* multiplicity);
+
+	/**	@brief	Sorts with one dense histogram per thread
+	 *	@param	data		Keys to sort
+	 *	@param	length	Number of keys
+	 *	@param	minKey	Smallest key
+	 *	@param	buckets	Buckets per histogram, maxKey - minKey + 1
+	 *	@param	threads	Number of threads to use
+	 *	@param	collapse			True to write each distinct key once
+	 *	@param	multiplicity	Receives the count of each distinct key, or nullptr
+	 *	@return	The number of keys written
+	 */
+	size_t denseSort(uint64_t* data, size_t length, uint64_t minKey, uint64_t buckets,
+		unsigned threads, bool collapse, uint64_t* multiplicity);
+
+	/**	@brief	Sorts with one hashed histogram per thread
+	 *	@param	data		Keys to sort
+	 *	@param	length	Number of keys
+	 *	@param	threads	Number of threads to use
+	 *	@param	collapse			True to write each distinct key once
+	 *	@param	multiplicity	Receives the count of each distinct key, or nullptr
+	 *	@param	written				Receives the number of keys written
+	 *	@return	False, leaving data unchanged, if there are too many distinct keys
+	 */
+	bool sparseSort(uint64_t* data, size_t length, unsigned threads, bool collapse,
+		uint64_t* multiplicity, size_t& written);
+
+	/**	@brief	Rewrites the keys in order from merged counts
+	 *	Each thread fills an equal share of the output, starting from the key
+	 *	whose run covers the start of its share.
+	 *	@param	data		Output, length keys
+	 *	@param	length	Number of keys
+	 *	@param	keys		Distinct keys in ascending order; nullptr for base + index
+	 *	@param	base		Key of the first bucket when keys is nullptr
+	 *	@param	starts	Output position of each key's run, plus length at the end
+	 *	@param	count		Number of distinct keys
+	 *	@param	threads	Number of threads to use
+	 */
+	static void fill(uint64_t* data, size_t length, const uint64_t* keys, uint64_t base,
+		const uint64_t* starts, size_t count, unsigned threads);
+
+	/**	@brief	Writes each key with a non-empty run once, in order
+	 *	Used in place of fill() when only the distinct keys are wanted, so the
+	 *	output costs one write per distinct key rather than one per key.
+	 *	@param	data					Output, one key per non-empty run
+	 *	@param	keys					Distinct keys in ascending order; nullptr for base + index
+	 *	@param	base					Key of the first bucket when keys is nullptr
+	 *	@param	starts				Output position of each key's run, plus length at the end
+	 *	@param	count					Number of runs
+	 *	@param	multiplicity	Receives the length of each non-empty run, or nullptr
+	 *	@return	The number of keys written
+	 */
+	static size_t writeRuns(uint64_t* data, const uint64_t* keys, uint64_t base,
+		const uint64_t* starts, size_t count, uint64_t* multiplicity);
+
+	/**	@brief	Sorts with the fallback plugin
+	 *	@param	keys					The keys, sorted in place
+	 *	@param	count					Number of keys
+	 *	@param	why						Reason the keys cannot be counted, for the error if there is no fallback
+	 *	@param	collapse			True to keep one copy of each key
+	 *	@param	multiplicity	Receives the count of each distinct key when collapsing,
+	 *												or nullptr
+	 *	@return	The number of keys written: count, or the number of distinct keys
+	 *	@throws	std::runtime_error	If there is no fallback
+	 */
+	size_t delegate(uint64_t* keys, size_t count, const std::string& why, bool collapse,
+		uint64_t* multiplicity);
+};
+
+CountingSort __countingsort_instance;
+
+}; //End namespace
+
+#endif //Include once
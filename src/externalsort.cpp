@@ -0,0 +1,229 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+//Library includes
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+//Project includes
+#include "externalsort.h"
+#include "losertree.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Construct for an algorithm, memory budget and temporary directory
+ *	@param	algorithm		The algorithm used to sort each chunk
+ *	@param	memoryBudget	Approximate upper bound on memory used, in bytes
+ *	@param	tempDir				Directory in which run files are created
+ */
+ExternalSorter::ExternalSorter(SortAlgorithm& algorithm, uint64_t memoryBudget,
+	const std::string& tempDir) :
+	algorithm_(algorithm),
+	memoryBudget_(memoryBudget),
+	tempDir_(tempDir),
+	runCount_(0),
+	badLines_(0)
+	{}
+
+/**	@brief	Destructor, removes any remaining run files */
+ExternalSorter::~ExternalSorter() {
+	for(const std::string& path : tempFiles_)
+		::unlink(path.c_str());
+}
+
+/**	@brief	Sorts a file of keys into an output file
+ *	@param	inputPath			Path of the file to sort
+ *	@param	inputFormat		Format of the input file
+ *	@param	outputPath		Path of the sorted output, or "-" for standard output
+ *	@param	outputFormat	Format of the output file
+ *	@return	The number of keys sorted
+ *	@throws	std::runtime_error	On I/O errors or malformed input
+ */
+uint64_t ExternalSorter::sort(const std::string& inputPath, KeyFormat inputFormat,
+	const std::string& outputPath, KeyFormat outputFormat) {
+	//Chunk size leaves room for the algorithm's own copies of the chunk
+	const size_t chunkKeys = std::max<uint64_t>(
+		memoryBudget_ / (ChunkCopies * sizeof(uint64_t)), 1024);
+	const size_t ioBytes = std::clamp<uint64_t>(memoryBudget_ / 16, 64 << 10, MaxIoBytes);
+
+	std::vector<std::string> runs;
+	uint64_t total = 0;
+	runCount_ = 0;
+	badLines_ = 0;
+	errors_.clear();
+
+	{
+		KeyReader input(inputPath, inputFormat, ioBytes);
+		SortAlgorithm::IntVector_t chunk;
+
+		for(;;) {
+			//Fill the next chunk
+			chunk.resize(chunkKeys);
+			size_t count = 0;
+			while(count < chunkKeys) {
+				size_t got = input.read(chunk.data() + count, chunkKeys - count);
+				if(got == 0) break;
+				count += got;
+			}
+			chunk.resize(count);
+			badLines_ = input.badLines();
+			errors_ = input.errors();
+			if(count == 0) break;
+
+			algorithm_.sort(chunk);
+			total += count;
+
+			//Everything fit in one chunk; no runs needed
+			if(count < chunkKeys && runs.empty()) {
+				KeyWriter output(outputPath, outputFormat, ioBytes);
+				output.setSorted(true);
+				output.write(chunk.data(), chunk.size());
+				output.close();
+				return total;
+			}
+
+			runs.push_back(writeRun(chunk.data(), chunk.size()));
+			if(count < chunkKeys) break;
+		}
+	}
+	runCount_ = runs.size();
+
+	//Read buffers per merge need at least MinMergeBlockKeys each, plus output
+	const uint64_t blocks = memoryBudget_ / (MinMergeBlockKeys * sizeof(uint64_t));
+	const size_t fanIn = (blocks > 3) ? blocks - 1 : 2;
+
+	//Merge groups of runs until a single merge can produce the output
+	while(runs.size() > fanIn) {
+		std::vector<std::string> merged;
+		for(size_t first = 0; first < runs.size(); first += fanIn) {
+			size_t last = std::min(first + fanIn, runs.size());
+			std::vector<std::string> group(runs.begin() + first, runs.begin() + last);
+			if(group.size() == 1) {
+				merged.push_back(group[0]);
+				continue;
+			}
+
+			std::string path = createTempFile();
+			KeyWriter output(path, KeyFormat::Raw, ioBytes);
+			merge(group, output);
+			output.close();
+			merged.push_back(path);
+		}
+		runs.swap(merged);
+	}
+
+	KeyWriter output(outputPath, outputFormat, ioBytes);
+	output.setSorted(true);
+	merge(runs, output);
+	output.close();
+	return total;
+}
+
+/**	@brief	Writes a sorted chunk to a new temporary run file
+ *	@return	Path of the run file
+ */
+std::string ExternalSorter::writeRun(const uint64_t* keys, size_t count) {
+	std::string path = createTempFile();
+	KeyWriter run(path, KeyFormat::Raw, MaxIoBytes);
+	run.write(keys, count);
+	run.close();
+	return path;
+}
+
+/**	@brief	Merges sorted run files into a writer
+ *	@param	runs		Paths of the run files, removed once merged
+ *	@param	output	Destination for the merged keys
+ */
+void ExternalSorter::merge(const std::vector<std::string>& runs, KeyWriter& output) {
+	const size_t sources = runs.size();
+	const size_t blockKeys = std::max<uint64_t>(1024,
+		memoryBudget_ / sizeof(uint64_t) / (sources + 1));
+
+	//One read block per run, plus one output block
+	std::vector<std::unique_ptr<KeyReader>> readers;
+	std::vector<uint64_t> blocks(sources * blockKeys);
+	std::vector<size_t> position(sources, 0);
+	std::vector<size_t> length(sources, 0);
+	std::vector<uint64_t> out(blockKeys);
+	size_t outCount = 0;
+
+	LoserTree tree(sources);
+	for(size_t source = 0; source < sources; source++) {
+		readers.emplace_back(new KeyReader(runs[source], KeyFormat::Raw));
+		uint64_t* block = blocks.data() + source * blockKeys;
+		length[source] = readers[source]->read(block, blockKeys);
+		if(length[source] > 0) tree.set(source, block[0]);
+	}
+	tree.build();
+
+	while(!tree.empty()) {
+		size_t source = tree.winner();
+		out[outCount++] = tree.winnerKey();
+		if(outCount == blockKeys) {
+			output.write(out.data(), outCount);
+			outCount = 0;
+		}
+
+		//Advance the winning run, refilling its block as needed
+		uint64_t* block = blocks.data() + source * blockKeys;
+		if(++position[source] == length[source]) {
+			position[source] = 0;
+			length[source] = readers[source]->read(block, blockKeys);
+			if(length[source] == 0) {
+				tree.pop();
+				continue;
+			}
+		}
+		tree.replace(block[position[source]]);
+	}
+	output.write(out.data(), outCount);
+
+	readers.clear();
+	for(const std::string& path : runs)
+		removeTempFile(path);
+}
+
+/**	@brief	Creates a uniquely named, empty file in the temporary directory */
+std::string ExternalSorter::createTempFile() {
+	std::string pattern = tempDir_ + "/isort-run-XXXXXX";
+	std::vector<char> path(pattern.begin(), pattern.end());
+	path.push_back('\0');
+
+	int fd = ::mkstemp(path.data());
+	if(fd < 0)
+		throw std::runtime_error("Unable to create run file in '" + tempDir_ +
+			"': " + strerror(errno));
+	::close(fd);
+
+	tempFiles_.push_back(path.data());
+	return tempFiles_.back();
+}
+
+/**	@brief	Deletes a temporary file and forgets it */
+void ExternalSorter::removeTempFile(const std::string& path) {
+	::unlink(path.c_str());
+	tempFiles_.erase(std::remove(tempFiles_.begin(), tempFiles_.end(), path),
+		tempFiles_.end());
+}
+
+}; //End namespace
@@ -0,0 +1,112 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EXTERNALSORT_INCLUDED
+#define _EXTERNALSORT_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <string>
+#include <vector>
+//Project includes
+#include "sortalgorithm.h"
+#include "keystream.h"
+
+namespace JAC::Integer {
+
+/**	@brief	External-memory merge sort for files larger than RAM
+ *	The input is read in chunks sized to the memory budget, each chunk is
+ *	sorted with the supplied algorithm and spilled to a temporary run file,
+ *	and the runs are combined with a buffered k-way loser tree merge. If there
+ *	are more runs than the budget allows read buffers for, groups of runs are
+ *	merged into longer runs first. Input that fits in a single chunk is sorted
+ *	and written directly without touching the temporary directory.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class ExternalSorter {
+public:
+	//Copies of a chunk alive while it is sorted: the chunk and its scratch
+	static constexpr uint64_t ChunkCopies = 2;
+
+	//Smallest per-run read buffer worth merging with, in keys
+	static constexpr size_t MinMergeBlockKeys = 1 << 15;
+
+public:
+	/**	@brief	Construct for an algorithm, memory budget and temporary directory
+	 *	@param	algorithm		The algorithm used to sort each chunk
+	 *	@param	memoryBudget	Approximate upper bound on memory used, in bytes
+	 *	@param	tempDir				Directory in which run files are created
+	 */
+	ExternalSorter(SortAlgorithm& algorithm, uint64_t memoryBudget,
+		const std::string& tempDir);
+
+	/**	@brief	Destructor, removes any remaining run files */
+	virtual ~ExternalSorter();
+
+	/**	@brief	Sorts a file of keys into an output file
+	 *	@param	inputPath			Path of the file to sort
+	 *	@param	inputFormat		Format of the input file
+	 *	@param	outputPath		Path of the sorted output, or "-" for standard output
+	 *	@param	outputFormat	Format of the output file
+	 *	@return	The number of keys sorted
+	 *	@throws	std::runtime_error	On I/O errors or malformed input
+	 */
+	uint64_t sort(const std::string& inputPath, KeyFormat inputFormat,
+		const std::string& outputPath, KeyFormat outputFormat);
+
+	/**	@brief	Number of runs spilled by the last sort() */
+	inline size_t runCount() const { return runCount_; }
+
+	/**	@brief	Number of malformed text lines skipped by the last sort() */
+	inline uint64_t badLines() const { return badLines_; }
+
+	/**	@brief	The first malformed text lines skipped by the last sort() */
+	inline const std::vector<ParseError>& errors() const { return errors_; }
+
+private:
+	/**	@brief	Writes a sorted chunk to a new temporary run file
+	 *	@return	Path of the run file
+	 */
+	std::string writeRun(const uint64_t* keys, size_t count);
+
+	/**	@brief	Merges sorted run files into a writer
+	 *	@param	runs		Paths of the run files, removed once merged
+	 *	@param	output	Destination for the merged keys
+	 */
+	void merge(const std::vector<std::string>& runs, KeyWriter& output);
+
+	/**	@brief	Creates a uniquely named, empty file in the temporary directory */
+	std::string createTempFile();
+
+	/**	@brief	Deletes a temporary file and forgets it */
+	void removeTempFile(const std::string& path);
+
+private:
+	SortAlgorithm&						algorithm_;		/*! Chunk sort algorithm */
+	uint64_t									memoryBudget_;/*! Memory budget in bytes */
+	std::string								tempDir_;			/*! Directory for run files */
+	std::vector<std::string>	tempFiles_;		/*! Run files not yet removed */
+	size_t										runCount_;		/*! Runs spilled by the last sort */
+	uint64_t									badLines_;		/*! Malformed lines in the last sort */
+	std::vector<ParseError>		errors_;			/*! First malformed lines in the last sort */
+};
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,321 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+//Project includes
+#include "generator.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+//Names accepted by parseDistribution(), in Distribution order
+static const char* DistributionNames[] = {
+	"uniform", "zipf", "normal", "sorted", "reverse", "nearly", "few", "sawtooth"
+};
+
+/**	@brief	Parses a distribution specification of the form name[:parameter]
+ *	@param	text	The specification
+ *	@throws	std::invalid_argument	If the name or parameter is not recognized
+ */
+DistributionSpec parseDistribution(const std::string& text) {
+	size_t colon = text.find(':');
+	std::string name = text.substr(0, colon);
+
+	DistributionSpec spec = { Distribution::Uniform, 0 };
+	const size_t names = sizeof(DistributionNames) / sizeof(DistributionNames[0]);
+	size_t idx = 0;
+	while(idx < names && name != DistributionNames[idx]) idx++;
+	if(idx == names)
+		throw std::invalid_argument("Unknown distribution: " + name);
+	spec.type = (Distribution) idx;
+
+	if(colon != std::string::npos) {
+		std::string value = text.substr(colon + 1);
+		size_t used = 0;
+		try {
+			spec.parameter = std::stod(value, &used);
+		}
+		catch(const std::exception&) {
+			used = 0;
+		}
+		if(used == 0 || used != value.size() || !(spec.parameter > 0))
+			throw std::invalid_argument("Invalid parameter for distribution '" + name +
+				"': " + value);
+	}
+	return spec;
+}
+
+/**	@brief	Returns the name of a distribution, as accepted by parseDistribution() */
+std::string distributionName(Distribution type) {
+	return DistributionNames[(size_t) type];
+}
+
+/**	@brief	Construct for a dataset
+ *	@param	spec		The distribution to draw from
+ *	@param	count		Number of keys to generate
+ *	@param	max			Keys are in [0, max); 0 for the full 64-bit range
+ *	@param	seed		Seed for the random streams
+ *	@param	threads	Number of threads to use, 0 for the default
+ *	@throws	std::invalid_argument	If the distribution parameter is out of range
+ */
+DataGenerator::DataGenerator(const DistributionSpec& spec, uint64_t count, uint64_t max,
+	uint64_t seed, unsigned threads) :
+	spec_(spec),
+	count_(count),
+	max_(max),
+	span_((max > 0) ? (unsigned __int128) max : ((unsigned __int128) 1 << 64)),
+	seed_(seed),
+	threads_(threads),
+	runLength_(0),
+	zipfN_(0),
+	zipfHX1_(0),
+	zipfHN_(0),
+	zipfS_(0) {
+	//Setup draws come from the seed's first stream; blocks start one jump later
+	Xoshiro256 rng(seed_);
+
+	switch(spec_.type) {
+		case Distribution::Zipf: {
+			if(spec_.parameter == 0) spec_.parameter = DefaultZipfSkew;
+			zipfN_ = (double) span_;
+			zipfHX1_ = zipfHIntegral(1.5) - 1.0;
+			zipfHN_ = zipfHIntegral(zipfN_ + 0.5);
+			zipfS_ = 2.0 - zipfHIntegralInverse(zipfHIntegral(2.5) - zipfH(2.0));
+			break;
+		}
+		case Distribution::Normal:
+			if(spec_.parameter == 0) spec_.parameter = DefaultNormalDeviation;
+			break;
+		case Distribution::FewUnique: {
+			if(spec_.parameter == 0) spec_.parameter = DefaultUniqueValues;
+			if(spec_.parameter < 1 || spec_.parameter > BlockKeys)
+				throw std::invalid_argument("Distinct value count must be between 1 and " +
+					std::to_string(BlockKeys));
+			unique_.resize((size_t) spec_.parameter);
+			for(uint64_t& value : unique_) value = rng.bounded(max_);
+			break;
+		}
+		case Distribution::Sawtooth:
+			if(spec_.parameter == 0) spec_.parameter = DefaultRunLength;
+			runLength_ = std::max<uint64_t>(1, (uint64_t) spec_.parameter);
+			break;
+		case Distribution::NearlySorted: {
+			uint64_t swaps = (spec_.parameter > 0) ? (uint64_t) spec_.parameter :
+				count_ / DefaultSwapFraction;
+			if(count_ < 2) swaps = 0;
+
+			//Apply the swaps to a sparse overlay of the sorted sequence
+			std::unordered_map<uint64_t, uint64_t> overlay;
+			auto keyAt = [&](uint64_t index) {
+				auto found = overlay.find(index);
+				return (found != overlay.end()) ? found->second : spaced(index, count_);
+			};
+			for(uint64_t swap = 0; swap < swaps; swap++) {
+				uint64_t a = rng.bounded(count_);
+				uint64_t b = rng.bounded(count_);
+				uint64_t keyA = keyAt(a);
+				overlay[a] = keyAt(b);
+				overlay[b] = keyA;
+			}
+			swapped_.assign(overlay.begin(), overlay.end());
+			std::sort(swapped_.begin(), swapped_.end());
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**	@brief	Destructor */
+DataGenerator::~DataGenerator() {
+}
+
+/**	@brief	Generates the dataset
+ *	@param	writer	Receives the keys, in order
+ */
+void DataGenerator::generate(KeyWriter& writer) {
+	uint64_t blocks = (count_ + BlockKeys - 1) / BlockKeys;
+	size_t threads = (threads_ > 0) ? threads_ : defaultThreads();
+	threads = std::max<size_t>(1, std::min<uint64_t>(threads, blocks));
+
+	std::vector<std::vector<uint64_t>> buffers(threads,
+		std::vector<uint64_t>(std::min<uint64_t>(count_, BlockKeys)));
+	std::vector<Xoshiro256> streams(threads, Xoshiro256(0));
+	Xoshiro256 stream(seed_);
+
+	for(uint64_t block = 0; block < blocks; block += threads) {
+		size_t round = std::min<uint64_t>(threads, blocks - block);
+
+		//Stream for block b is the seed's stream jumped b+1 times
+		for(size_t tid = 0; tid < round; tid++) {
+			stream.jump();
+			streams[tid] = stream;
+		}
+
+		parallelFor(round, [&](unsigned tid) {
+			uint64_t first = (block + tid) * BlockKeys;
+			size_t keys = std::min<uint64_t>(BlockKeys, count_ - first);
+			fillBlock(first, keys, streams[tid], buffers[tid].data());
+		});
+
+		for(size_t tid = 0; tid < round; tid++) {
+			uint64_t first = (block + tid) * BlockKeys;
+			writer.write(buffers[tid].data(), std::min<uint64_t>(BlockKeys, count_ - first));
+		}
+	}
+}
+
+/**	@brief	Generates the dataset into memory
+ *	@param	keys	Destination, room for the full count of keys
+ */
+void DataGenerator::generate(uint64_t* keys) {
+	uint64_t blocks = (count_ + BlockKeys - 1) / BlockKeys;
+	size_t threads = (threads_ > 0) ? threads_ : defaultThreads();
+	threads = std::max<size_t>(1, std::min<uint64_t>(threads, blocks));
+
+	//Same streams as generate(KeyWriter&), so both produce the same keys
+	std::vector<Xoshiro256> streams;
+	Xoshiro256 stream(seed_);
+	for(uint64_t block = 0; block < blocks; block++) {
+		stream.jump();
+		streams.push_back(stream);
+	}
+
+	parallelFor(threads, [&](unsigned tid) {
+		for(uint64_t block = tid; block < blocks; block += threads) {
+			uint64_t first = block * BlockKeys;
+			fillBlock(first, std::min<uint64_t>(BlockKeys, count_ - first), streams[block],
+				keys + first);
+		}
+	});
+}
+
+/**	@brief	Fills one block of the dataset
+ *	@param	first	Index of the block's first key in the dataset
+ *	@param	count	Number of keys in the block
+ *	@param	rng		The block's random stream
+ *	@param	out		Destination for the keys
+ */
+void DataGenerator::fillBlock(uint64_t first, size_t count, Xoshiro256& rng,
+	uint64_t* out) const {
+	switch(spec_.type) {
+		case Distribution::Uniform:
+			for(size_t idx = 0; idx < count; idx++) out[idx] = rng.bounded(max_);
+			break;
+
+		case Distribution::Zipf:
+			for(size_t idx = 0; idx < count; idx++) out[idx] = zipf(rng) - 1;
+			break;
+
+		case Distribution::Normal: {
+			double mean = (double) span_ / 2;
+			double deviation = (double) span_ * spec_.parameter;
+			double limit = (double) span_;
+			for(size_t idx = 0; idx < count; ) {
+				//Marsaglia polar method, two values per accepted point
+				double u, v, s;
+				do {
+					u = 2 * rng.uniform() - 1;
+					v = 2 * rng.uniform() - 1;
+					s = u * u + v * v;
+				} while(s >= 1 || s == 0);
+				double scale = std::sqrt(-2 * std::log(s) / s);
+				for(double value : { mean + deviation * u * scale, mean + deviation * v * scale }) {
+					if(idx < count && value >= 0 && value < limit) {
+						uint64_t key = (uint64_t) value;
+						out[idx++] = (max_ > 0) ? std::min(key, max_ - 1) : key;
+					}
+				}
+			}
+			break;
+		}
+
+		case Distribution::Sorted:
+		case Distribution::NearlySorted:
+			for(size_t idx = 0; idx < count; idx++) out[idx] = spaced(first + idx, count_);
+			break;
+
+		case Distribution::Reverse:
+			for(size_t idx = 0; idx < count; idx++)
+				out[idx] = spaced(count_ - 1 - (first + idx), count_);
+			break;
+
+		case Distribution::FewUnique:
+			for(size_t idx = 0; idx < count; idx++) out[idx] = unique_[rng.bounded(unique_.size())];
+			break;
+
+		case Distribution::Sawtooth:
+			for(size_t idx = 0; idx < count; idx++)
+				out[idx] = spaced((first + idx) % runLength_, runLength_);
+			break;
+	}
+
+	//Nearly sorted: overlay the swapped keys that fall in this block
+	auto itr = std::lower_bound(swapped_.begin(), swapped_.end(),
+		std::make_pair(first, (uint64_t) 0));
+	for(; itr != swapped_.end() && itr->first < first + count; itr++)
+		out[itr->first - first] = itr->second;
+}
+
+/**	@brief	Draws a Zipf rank in [1, max] by rejection-inversion
+ *	See Hörmann and Derflinger, "Rejection-inversion to generate variates
+ *	from monotone discrete distributions" (1996). Runs in constant expected
+ *	time for any number of ranks.
+ */
+uint64_t DataGenerator::zipf(Xoshiro256& rng) const {
+	for(;;) {
+		double u = zipfHN_ + rng.uniform() * (zipfHX1_ - zipfHN_);
+		double x = zipfHIntegralInverse(u);
+		double k = std::floor(x + 0.5);
+		if(k < 1) k = 1;
+		else if(k > zipfN_) k = zipfN_;
+		if(k - x <= zipfS_ || u >= zipfHIntegral(k + 0.5) - zipfH(k)) {
+			//The top rank may round up to 2^64 in double precision
+			return (k >= 0x1.0p64) ? UINT64_MAX : std::max<uint64_t>(1, (uint64_t) k);
+		}
+	}
+}
+
+/**	@brief	Zipf: the unnormalized density h(x) = x^-s */
+double DataGenerator::zipfH(double x) const {
+	return std::exp(-spec_.parameter * std::log(x));
+}
+
+/**	@brief	Zipf: H(x), an integral of h(x) */
+double DataGenerator::zipfHIntegral(double x) const {
+	double logX = std::log(x);
+	double t = (1.0 - spec_.parameter) * logX;
+	double helper = (std::fabs(t) > 1e-8) ? std::expm1(t) / t :
+		1.0 + t * 0.5 * (1.0 + t / 3.0 * (1.0 + 0.25 * t));
+	return helper * logX;
+}
+
+/**	@brief	Zipf: the inverse of H(x) */
+double DataGenerator::zipfHIntegralInverse(double x) const {
+	double t = std::max(-1.0, x * (1.0 - spec_.parameter));
+	double helper = (std::fabs(t) > 1e-8) ? std::log1p(t) / t :
+		1.0 - t * (0.5 - t * (1.0 / 3.0 - 0.25 * t));
+	return std::exp(helper * x);
+}
+
+}; //End namespace
@@ -0,0 +1,237 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _GENERATOR_INCLUDED
+#define _GENERATOR_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+//Project includes
+#include "keystream.h"
+
+namespace JAC::Integer {
+
+/**	@brief	xoshiro256** pseudo-random generator
+ *	Small, fast and statistically strong. Seeded through splitmix64, and
+ *	jump() advances the state by 2^128 steps so each block of a generated
+ *	dataset can draw from its own non-overlapping stream.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class Xoshiro256 {
+public:
+	/**	@brief	Construct from a 64-bit seed */
+	explicit Xoshiro256(uint64_t seed) {
+		for(uint64_t& word : state_) {
+			seed += 0x9E3779B97F4A7C15ULL;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			word = z ^ (z >> 31);
+		}
+	}
+
+	/**	@brief	Returns the next 64 random bits */
+	inline uint64_t next() {
+		uint64_t result = rotl(state_[1] * 5, 7) * 9;
+		uint64_t t = state_[1] << 17;
+		state_[2] ^= state_[0];
+		state_[3] ^= state_[1];
+		state_[1] ^= state_[2];
+		state_[0] ^= state_[3];
+		state_[2] ^= t;
+		state_[3] = rotl(state_[3], 45);
+		return result;
+	}
+
+	/**	@brief	Returns a uniform value in [0, range) without modulo bias
+	 *	@param	range	Number of possible values, 0 for the full 64-bit range
+	 */
+	inline uint64_t bounded(uint64_t range) {
+		if(range == 0) return next();
+
+		//Lemire's multiply-and-reject
+		unsigned __int128 product = (unsigned __int128) next() * range;
+		uint64_t low = (uint64_t) product;
+		if(low < range) {
+			uint64_t threshold = -range % range;
+			while(low < threshold) {
+				product = (unsigned __int128) next() * range;
+				low = (uint64_t) product;
+			}
+		}
+		return (uint64_t) (product >> 64);
+	}
+
+	/**	@brief	Returns a uniform double in [0, 1) */
+	inline double uniform() {
+		return (next() >> 11) * 0x1.0p-53;
+	}
+
+	/**	@brief	Advances the state by 2^128 steps */
+	void jump() {
+		static const uint64_t Jump[] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+			0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+		uint64_t jumped[4] = { 0, 0, 0, 0 };
+		for(uint64_t bits : Jump) {
+			for(int bit = 0; bit < 64; bit++) {
+				if(bits & (1ULL << bit)) {
+					for(int word = 0; word < 4; word++) jumped[word] ^= state_[word];
+				}
+				next();
+			}
+		}
+		for(int word = 0; word < 4; word++) state_[word] = jumped[word];
+	}
+
+private:
+	static inline uint64_t rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+private:
+	uint64_t	state_[4];			/*! Generator state */
+};
+
+/**	@brief	Shapes of generated datasets */
+enum class Distribution {
+	Uniform,			/*! Independent uniform values */
+	Zipf,					/*! Value v drawn with probability proportional to 1/(v+1)^s */
+	Normal,				/*! Normal around the middle of the range, clipped to it */
+	Sorted,				/*! Evenly spaced ascending values */
+	Reverse,			/*! Evenly spaced descending values */
+	NearlySorted,	/*! Sorted, then k random pairs swapped */
+	FewUnique,		/*! Uniform picks from a small set of distinct values */
+	Sawtooth			/*! Repeated ascending runs */
+};
+
+/**	@brief	A distribution and its optional parameter */
+struct DistributionSpec {
+	Distribution	type;					/*! The distribution */
+	double				parameter;		/*! Distribution-specific parameter, 0 for its default */
+};
+
+/**	@brief	Parses a distribution specification of the form name[:parameter]
+ *	Names are uniform, zipf[:skew], normal[:stddev as a fraction of the range],
+ *	sorted, reverse, nearly[:swaps], few[:distinct values] and sawtooth[:run length].
+ *	@param	text	The specification
+ *	@throws	std::invalid_argument	If the name or parameter is not recognized
+ */
+DistributionSpec parseDistribution(const std::string& text);
+
+/**	@brief	Returns the name of a distribution, as accepted by parseDistribution() */
+std::string distributionName(Distribution type);
+
+/**	@brief	Parallel, streaming generator for test datasets
+ *	Keys are produced in fixed-size blocks. Block b always draws from the
+ *	seed's stream jumped b times, so a dataset depends only on its seed and
+ *	parameters, not on the thread count. Each round, every thread fills one
+ *	block and the blocks are written in order, so memory use is bounded by
+ *	the thread count rather than the dataset size.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class DataGenerator {
+public:
+	//Keys per generated block
+	static constexpr size_t BlockKeys = 1 << 20;
+
+	//Parameter defaults
+	static constexpr double DefaultZipfSkew = 1.0;
+	static constexpr double DefaultNormalDeviation = 0.125;
+	static constexpr double DefaultUniqueValues = 16;
+	static constexpr double DefaultRunLength = 1000;
+	static constexpr uint64_t DefaultSwapFraction = 1000;	//One swap per this many keys
+
+public:
+	/**	@brief	Construct for a dataset
+	 *	@param	spec		The distribution to draw from
+	 *	@param	count		Number of keys to generate
+	 *	@param	max			Keys are in [0, max); 0 for the full 64-bit range
+	 *	@param	seed		Seed for the random streams
+	 *	@param	threads	Number of threads to use, 0 for the default
+	 *	@throws	std::invalid_argument	If the distribution parameter is out of range
+	 */
+	DataGenerator(const DistributionSpec& spec, uint64_t count, uint64_t max, uint64_t seed,
+		unsigned threads = 0);
+
+	/**	@brief	Destructor */
+	virtual ~DataGenerator();
+
+	/**	@brief	Generates the dataset
+	 *	@param	writer	Receives the keys, in order
+	 */
+	void generate(KeyWriter& writer);
+
+	/**	@brief	Generates the dataset into memory
+	 *	@param	keys	Destination, room for the full count of keys
+	 */
+	void generate(uint64_t* keys);
+
+private:
+	/**	@brief	Fills one block of the dataset
+	 *	@param	first	Index of the block's first key in the dataset
+	 *	@param	count	Number of keys in the block
+	 *	@param	rng		The block's random stream
+	 *	@param	out		Destination for the keys
+	 */
+	void fillBlock(uint64_t first, size_t count, Xoshiro256& rng, uint64_t* out) const;
+
+	/**	@brief	The key at an index of an evenly spaced ascending sequence
+	 *	@param	index	Position in the sequence
+	 *	@param	length	Length of the sequence
+	 */
+	inline uint64_t spaced(uint64_t index, uint64_t length) const {
+		return (uint64_t) (((unsigned __int128) index * span_) / length);
+	}
+
+	/**	@brief	Draws a Zipf rank in [1, max] by rejection-inversion */
+	uint64_t zipf(Xoshiro256& rng) const;
+
+	/**	@brief	Zipf: the unnormalized density h(x) = x^-s */
+	double zipfH(double x) const;
+
+	/**	@brief	Zipf: H(x), an integral of h(x) */
+	double zipfHIntegral(double x) const;
+
+	/**	@brief	Zipf: the inverse of H(x) */
+	double zipfHIntegralInverse(double x) const;
+
+private:
+	DistributionSpec	spec_;				/*! The distribution */
+	uint64_t					count_;				/*! Keys to generate */
+	uint64_t					max_;					/*! Exclusive upper bound, 0 for none */
+	unsigned __int128	span_;				/*! Number of possible key values */
+	uint64_t					seed_;				/*! Seed for the random streams */
+	unsigned					threads_;			/*! Thread count, 0 for the default */
+	uint64_t					runLength_;		/*! Sawtooth run length */
+	double						zipfN_;				/*! Zipf: number of ranks */
+	double						zipfHX1_;			/*! Zipf: H(1.5) - 1 */
+	double						zipfHN_;			/*! Zipf: H(N + 0.5) */
+	double						zipfS_;				/*! Zipf: squeeze threshold */
+	std::vector<uint64_t>	unique_;	/*! Few-unique: the distinct values */
+	std::vector<std::pair<uint64_t, uint64_t>>	swapped_;	/*! Nearly sorted: (index, key), by index */
+};
+
+}; //End namespace
+
+#endif //Include once
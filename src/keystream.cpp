@@ -0,0 +1,364 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+//Library includes
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+//Project includes
+#include "keystream.h"
+#include "binaryfile.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Builds an exception message from an operation, path and errno */
+static std::runtime_error ioError(const std::string& what, const std::string& path) {
+	return std::runtime_error(what + " '" + path + "': " + strerror(errno));
+}
+
+/**	@brief	Chooses the format of a file from a flag, its extension or contents
+ *	@param	path		The file path
+ *	@param	binary	True to force the binary format
+ *	@param	sniff		True to also check an existing file for the binary magic
+ *	@return	KeyFormat::Binary or KeyFormat::Text
+ */
+KeyFormat keyFormatFor(const std::string& path, bool binary, bool sniff) {
+	if(binary || hasBinaryExtension(path) || (sniff && isBinaryKeyFile(path)))
+		return KeyFormat::Binary;
+	return KeyFormat::Text;
+}
+
+/**	@brief	Opens a file of keys for reading
+ *	@param	path				Path to the file
+ *	@param	format			Format of the file contents
+ *	@param	bufferBytes	Size of each sequential read
+ *	@throws	std::runtime_error	If the file cannot be opened
+ */
+KeyReader::KeyReader(const std::string& path, KeyFormat format, size_t bufferBytes) :
+	path_(path),
+	format_(format),
+	fd_(-1),
+	begin_(0),
+	end_(0),
+	eof_(false),
+	line_(0),
+	remaining_(0),
+	sorted_(false),
+	badLines_(0) {
+	fd_ = ::open(path.c_str(), O_RDONLY);
+	if(fd_ < 0)
+		throw ioError("Unable to open input file", path_);
+	::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	if(format_ == KeyFormat::Binary) {
+		BinaryKeyHeader header;
+		ssize_t bytes = ::read(fd_, &header, sizeof(header));
+		try {
+			if(bytes != (ssize_t) sizeof(header))
+				throw std::runtime_error("'" + path_ + "' is not a binary key file");
+			checkBinaryHeader(header, path_);
+		}
+		catch(...) {
+			::close(fd_);
+			throw;
+		}
+		remaining_ = header.count;
+		sorted_ = (header.flags & BinaryKeyHeader::SortedFlag) != 0;
+	}
+
+	if(format_ == KeyFormat::Text)
+		buffer_.resize(std::max(bufferBytes, (size_t) 4096));
+}
+
+/**	@brief	Destructor, closes the file */
+KeyReader::~KeyReader() {
+	if(fd_ >= 0) ::close(fd_);
+}
+
+/**	@brief	Reads the next block of keys
+ *	@param	keys		Destination for the keys
+ *	@param	maxKeys	Maximum number of keys to read
+ *	@return	The number of keys read; 0 only at end of file
+ *	@throws	std::runtime_error	On a read error or malformed line
+ */
+size_t KeyReader::read(uint64_t* keys, size_t maxKeys) {
+	//Binary files hold exactly the number of keys in the header
+	if(format_ == KeyFormat::Binary) {
+		maxKeys = std::min<uint64_t>(maxKeys, remaining_);
+		if(maxKeys == 0) return 0;
+	}
+
+	if(format_ != KeyFormat::Text) {
+		//Read straight into the caller's block
+		char* dst = (char*) keys;
+		size_t want = maxKeys * sizeof(uint64_t);
+		size_t got = 0;
+		while(got < want && !eof_) {
+			ssize_t bytes = ::read(fd_, dst + got, want - got);
+			if(bytes < 0) {
+				if(errno == EINTR) continue;
+				throw ioError("Error reading", path_);
+			}
+			if(bytes == 0) eof_ = true;
+			got += bytes;
+		}
+		size_t count = got / sizeof(uint64_t);
+		if(got % sizeof(uint64_t) != 0 || (format_ == KeyFormat::Binary && count < maxKeys))
+			throw std::runtime_error("'" + path_ + "' is truncated");
+
+		if(format_ == KeyFormat::Binary) {
+			remaining_ -= count;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			for(size_t idx = 0; idx < count; idx++) keys[idx] = littleEndian(keys[idx]);
+#endif
+		}
+		return count;
+	}
+
+	size_t count = 0;
+	while(count < maxKeys) {
+		const char* begin = buffer_.data() + begin_;
+		const char* newline = (const char*) memchr(begin, '\n', end_ - begin_);
+
+		if(newline != nullptr) {
+			if(parseLine(begin, newline, keys[count])) count++;
+			begin_ = newline + 1 - buffer_.data();
+		}
+		else if(!fill()) {
+			//Final line without a trailing newline
+			if(begin_ < end_) {
+				if(parseLine(buffer_.data() + begin_, buffer_.data() + end_, keys[count])) count++;
+				begin_ = end_;
+			}
+			break;
+		}
+	}
+	return count;
+}
+
+/**	@brief	Refills the byte buffer, preserving any unconsumed bytes
+ *	@return	False if the end of the file has been reached
+ */
+bool KeyReader::fill() {
+	if(eof_) return false;
+
+	//Move the partial line to the front, growing if it fills the buffer
+	if(begin_ > 0) {
+		std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+		end_ -= begin_;
+		begin_ = 0;
+	}
+	if(end_ == buffer_.size())
+		buffer_.resize(buffer_.size() * 2);
+
+	for(;;) {
+		ssize_t bytes = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+		if(bytes < 0) {
+			if(errno == EINTR) continue;
+			throw ioError("Error reading", path_);
+		}
+		if(bytes == 0) {
+			eof_ = true;
+			return false;
+		}
+		end_ += bytes;
+		return true;
+	}
+}
+
+/**	@brief	Parses one text line, recording it if malformed
+ *	@param	begin	First byte of the line
+ *	@param	end		One past the last byte, excluding the newline
+ *	@param	value	Receives the parsed value
+ *	@return	False if the line is malformed and was skipped
+ */
+bool KeyReader::parseLine(const char* begin, const char* end, uint64_t& value) {
+	line_++;
+	if(parseKeyLine(begin, end, value))
+		return true;
+
+	badLines_++;
+	if(errors_.size() < TextKeyParser::MaxReportedErrors)
+		errors_.push_back({ line_, std::string(begin,
+			std::min<size_t>(end - begin, TextKeyParser::MaxErrorText)) });
+	return false;
+}
+
+/**	@brief	Creates (or replaces) a file of keys for writing
+ *	@param	path				Path to the file, or "-" for standard output
+ *	@param	format			Format of the file contents
+ *	@param	bufferBytes	Size of each sequential write
+ *	@throws	std::runtime_error	If the file cannot be created
+ */
+KeyWriter::KeyWriter(const std::string& path, KeyFormat format, size_t bufferBytes) :
+	path_(path),
+	format_(format),
+	fd_(-1),
+	ownFd_(true),
+	used_(0),
+	count_(0),
+	sorted_(false) {
+	if(path_ == "-") {
+		if(format_ == KeyFormat::Binary)
+			throw std::runtime_error("Binary output requires a regular file");
+		fd_ = STDOUT_FILENO;
+		ownFd_ = false;
+	}
+	else {
+		fd_ = openOutputFile(path_, target_, temp_);
+	}
+	buffer_.resize(std::max(bufferBytes, MaxTextKeyBytes * 64));
+
+	//Placeholder header; the count and flags are written at close()
+	if(format_ == KeyFormat::Binary) {
+		BinaryKeyHeader header = makeBinaryHeader(0, false);
+		std::memcpy(buffer_.data(), &header, sizeof(header));
+		used_ = sizeof(header);
+	}
+}
+
+/**	@brief	Destructor, flushes and closes the file */
+KeyWriter::~KeyWriter() {
+	if(!temp_.empty()) {
+		if(fd_ >= 0) ::close(fd_);
+		fd_ = -1;
+		discardOutputFile(temp_);
+		return;
+	}
+	try {
+		close();
+	}
+	catch(const std::exception&) {
+		//Errors are only reported through an explicit close()
+	}
+}
+
+/**	@brief	Appends keys to the file
+ *	@param	keys		Keys to write
+ *	@param	count		Number of keys
+ *	@throws	std::runtime_error	On a write error
+ */
+void KeyWriter::write(const uint64_t* keys, size_t count) {
+	if(fd_ < 0)
+		throw std::runtime_error("Write to closed file '" + path_ + "'");
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	//Binary files are little-endian; swap through a temporary block
+	if(format_ == KeyFormat::Binary) {
+		std::vector<uint64_t> swapped(keys, keys + count);
+		for(uint64_t& key : swapped) key = littleEndian(key);
+		format_ = KeyFormat::Raw;
+		write(swapped.data(), count);
+		format_ = KeyFormat::Binary;
+		return;
+	}
+#endif
+
+	if(format_ != KeyFormat::Text) {
+		size_t bytes = count * sizeof(uint64_t);
+
+		//Large blocks bypass the buffer entirely
+		if(bytes >= buffer_.size()) {
+			flush();
+			writeBytes((const char*) keys, bytes);
+		}
+		else {
+			if(used_ + bytes > buffer_.size()) flush();
+			std::memcpy(buffer_.data() + used_, keys, bytes);
+			used_ += bytes;
+		}
+	}
+	else if(count >= TextKeyFormatter::MinKeysPerThread) {
+		//Large blocks are formatted in parallel and written in order
+		flush();
+		formatter_.format(keys, count, [this](const char* data, size_t length) {
+			writeBytes(data, length);
+		});
+	}
+	else {
+		for(size_t done = 0; done < count; ) {
+			if(buffer_.size() - used_ < MaxTextKeyBytes) flush();
+			size_t block = std::min(count - done, (buffer_.size() - used_) / MaxTextKeyBytes);
+			used_ += formatKeys(keys + done, block, buffer_.data() + used_);
+			done += block;
+		}
+	}
+	count_ += count;
+}
+
+/**	@brief	Flushes buffered output and closes the file
+ *	@throws	std::runtime_error	On a write error
+ */
+void KeyWriter::close() {
+	if(fd_ < 0) return;
+
+	//An empty text file still ends with a newline
+	if(format_ == KeyFormat::Text && count_ == 0)
+		buffer_[used_++] = '\n';
+
+	int fd = fd_;
+	try {
+		flush();
+
+		//Fill in the header now the count is known
+		if(format_ == KeyFormat::Binary) {
+			BinaryKeyHeader header = makeBinaryHeader(count_, sorted_);
+			if(::pwrite(fd_, &header, sizeof(header), 0) != (ssize_t) sizeof(header))
+				throw ioError("Error writing header to", path_);
+		}
+	}
+	catch(...) {
+		if(ownFd_) ::close(fd);
+		fd_ = -1;
+		discardOutputFile(temp_);
+		throw;
+	}
+	fd_ = -1;
+	if(ownFd_ && ::close(fd) != 0) {
+		std::runtime_error error = ioError("Error closing", path_);
+		discardOutputFile(temp_);
+		throw error;
+	}
+	replaceOutputFile(target_, temp_);
+}
+
+/**	@brief	Writes the buffer contents to the file */
+void KeyWriter::flush() {
+	writeBytes(buffer_.data(), used_);
+	used_ = 0;
+}
+
+/**	@brief	Writes bytes to the file, retrying short writes */
+void KeyWriter::writeBytes(const char* data, size_t length) {
+	while(length > 0) {
+		ssize_t bytes = ::write(fd_, data, length);
+		if(bytes < 0) {
+			if(errno == EINTR) continue;
+			throw ioError("Error writing", path_);
+		}
+		data += bytes;
+		length -= bytes;
+	}
+}
+
+}; //End namespace
@@ -0,0 +1,207 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _KEYSTREAM_INCLUDED
+#define _KEYSTREAM_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+//Project includes
+#include "textparser.h"
+#include "textformat.h"
+
+namespace JAC::Integer {
+
+/**	@brief	On-disk representations of a sequence of keys */
+enum class KeyFormat {
+	Text,		/*! One decimal value per line */
+	Binary,	/*! Little-endian uint64_t values after a BinaryKeyHeader */
+	Raw			/*! Native uint64_t values with no header (temporary run files) */
+};
+
+//Largest single read or write request made through a KeyReader or KeyWriter
+static const size_t MaxIoBytes = 8 << 20;
+
+/**	@brief	Chooses the format of a file from a flag, its extension or contents
+ *	@param	path		The file path
+ *	@param	binary	True to force the binary format
+ *	@param	sniff		True to also check an existing file for the binary magic
+ *	@return	KeyFormat::Binary or KeyFormat::Text
+ */
+KeyFormat keyFormatFor(const std::string& path, bool binary, bool sniff);
+
+/**	@brief	Sequential, block-buffered reader for a file of keys
+ *	Keys are read with large sequential read() calls into an internal buffer
+ *	and handed out in blocks of the caller's choosing, so a file of any size
+ *	can be consumed in bounded memory.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class KeyReader {
+public:
+	//Default size of the read buffer
+	static const size_t DefaultBufferBytes = 4 << 20;
+
+public:
+	/**	@brief	Opens a file of keys for reading
+	 *	@param	path				Path to the file
+	 *	@param	format			Format of the file contents
+	 *	@param	bufferBytes	Size of each sequential read
+	 *	@throws	std::runtime_error	If the file cannot be opened
+	 */
+	KeyReader(const std::string& path, KeyFormat format,
+		size_t bufferBytes = DefaultBufferBytes);
+
+	/**	@brief	Destructor, closes the file */
+	virtual ~KeyReader();
+
+	KeyReader(const KeyReader&) = delete;
+	KeyReader& operator=(const KeyReader&) = delete;
+
+	/**	@brief	Reads the next block of keys
+	 *	@param	keys		Destination for the keys
+	 *	@param	maxKeys	Maximum number of keys to read
+	 *	@return	The number of keys read; 0 only at end of file
+	 *	@throws	std::runtime_error	On a read error or truncated binary file
+	 */
+	size_t read(uint64_t* keys, size_t maxKeys);
+
+	/**	@brief	Path of the file being read */
+	inline const std::string& path() const { return path_; }
+
+	/**	@brief	True if the file is known to hold keys in ascending order
+	 *	Only binary files carry this flag; text files always report false.
+	 */
+	inline bool sorted() const { return sorted_; }
+
+	/**	@brief	Number of malformed text lines skipped so far */
+	inline uint64_t badLines() const { return badLines_; }
+
+	/**	@brief	The first TextKeyParser::MaxReportedErrors malformed lines */
+	inline const std::vector<ParseError>& errors() const { return errors_; }
+
+private:
+	/**	@brief	Refills the byte buffer, preserving any unconsumed bytes
+	 *	@return	False if the end of the file has been reached
+	 */
+	bool fill();
+
+	/**	@brief	Parses one text line, recording it if malformed
+	 *	@param	begin	First byte of the line
+	 *	@param	end		One past the last byte, excluding the newline
+	 *	@param	value	Receives the parsed value
+	 *	@return	False if the line is malformed and was skipped
+	 */
+	bool parseLine(const char* begin, const char* end, uint64_t& value);
+
+private:
+	std::string				path_;				/*! Path to the file */
+	KeyFormat					format_;			/*! Format of the file */
+	int								fd_;					/*! File descriptor */
+	std::vector<char>	buffer_;			/*! Read buffer for text files */
+	size_t						begin_;				/*! First unconsumed byte in buffer_ */
+	size_t						end_;					/*! One past the last valid byte in buffer_ */
+	bool							eof_;					/*! True once read() has returned 0 */
+	uint64_t					line_;				/*! Current line number, for diagnostics */
+	uint64_t					remaining_;		/*! Keys left in a binary file */
+	bool							sorted_;			/*! Sorted flag from a binary header */
+	uint64_t					badLines_;		/*! Malformed text lines skipped */
+	std::vector<ParseError>	errors_;	/*! First malformed text lines */
+};
+
+/**	@brief	Sequential, block-buffered writer for a file of keys
+ *	Text output matches the newline-separated format written by Sorter: each
+ *	value is followed by a newline, and an empty sequence is a single newline.
+ *	Binary output must go to a regular file, since the header's key count is
+ *	filled in at close().
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class KeyWriter {
+public:
+	//Default size of the write buffer
+	static const size_t DefaultBufferBytes = 4 << 20;
+
+public:
+	/**	@brief	Creates (or replaces) a file of keys for writing
+	 *	An existing file is replaced only by close() (see openOutputFile()), so
+	 *	it may also be an input that is still being read.
+	 *	@param	path				Path to the file, or "-" for standard output
+	 *	@param	format			Format of the file contents
+	 *	@param	bufferBytes	Size of each sequential write
+	 *	@throws	std::runtime_error	If the file cannot be created
+	 */
+	KeyWriter(const std::string& path, KeyFormat format,
+		size_t bufferBytes = DefaultBufferBytes);
+
+	/**	@brief	Destructor, flushes and closes the file
+	 *	A file that would replace an existing one is discarded instead, so an
+	 *	error that skips close() leaves the existing file as it was.
+	 */
+	virtual ~KeyWriter();
+
+	KeyWriter(const KeyWriter&) = delete;
+	KeyWriter& operator=(const KeyWriter&) = delete;
+
+	/**	@brief	Appends keys to the file
+	 *	@param	keys		Keys to write
+	 *	@param	count		Number of keys
+	 *	@throws	std::runtime_error	On a write error
+	 */
+	void write(const uint64_t* keys, size_t count);
+
+	/**	@brief	Flushes buffered output and closes the file
+	 *	@throws	std::runtime_error	On a write error
+	 */
+	void close();
+
+	/**	@brief	Number of keys written so far */
+	inline uint64_t count() const { return count_; }
+
+	/**	@brief	Marks a binary file as holding keys in ascending order
+	 *	@param	sorted	Value of the header's sorted flag, written at close()
+	 */
+	inline void setSorted(bool sorted) { sorted_ = sorted; }
+
+private:
+	/**	@brief	Writes the buffer contents to the file */
+	void flush();
+
+	/**	@brief	Writes bytes to the file, retrying short writes */
+	void writeBytes(const char* data, size_t length);
+
+private:
+	std::string				path_;				/*! Path to the file */
+	std::string				target_;			/*! File replaced by close(), see openOutputFile() */
+	std::string				temp_;				/*! Temporary file written until close(), or empty */
+	KeyFormat					format_;			/*! Format of the file */
+	int								fd_;					/*! File descriptor */
+	bool							ownFd_;				/*! False when writing to standard output */
+	std::vector<char>	buffer_;			/*! Write buffer */
+	size_t						used_;				/*! Bytes used in buffer_ */
+	uint64_t					count_;				/*! Keys written */
+	bool							sorted_;			/*! Sorted flag for a binary header */
+	TextKeyFormatter	formatter_;		/*! Parallel formatter for large text blocks */
+};
+
+}; //End namespace
+
+#endif //Include once
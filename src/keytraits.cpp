@@ -0,0 +1,58 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <stdexcept>
+//Project includes
+#include "keytraits.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Parses a key type name
+ *	@param	text	u32, u64, i32, i64, f32 or f64
+ *	@return	The key type
+ *	@throws	std::invalid_argument	On any other name
+ */
+KeyType parseKeyType(const std::string& text) {
+	if(text == "u32") return KeyType::UInt32;
+	if(text == "u64") return KeyType::UInt64;
+	if(text == "i32") return KeyType::Int32;
+	if(text == "i64") return KeyType::Int64;
+	if(text == "f32") return KeyType::Float;
+	if(text == "f64") return KeyType::Double;
+	throw std::invalid_argument("Invalid key type '" + text +
+		"' (u32, u64, i32, i64, f32 or f64)");
+}
+
+/**	@brief	Returns the short name of a key type (ie: u64)
+ *	@param	type	The key type
+ */
+const char* keyTypeName(KeyType type) {
+	switch(type) {
+		case KeyType::UInt32:	return "u32";
+		case KeyType::UInt64:	return "u64";
+		case KeyType::Int32:	return "i32";
+		case KeyType::Int64:	return "i64";
+		case KeyType::Float:	return "f32";
+		case KeyType::Double:	return "f64";
+	}
+	return "unknown";
+}
+
+}; //End namespace
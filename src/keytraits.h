@@ -0,0 +1,169 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _KEYTRAITS_INCLUDED
+#define _KEYTRAITS_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace JAC::Integer {
+
+/**	@brief	Key types the sort stack accepts */
+enum class KeyType {
+	UInt32,				/*! uint32_t, sorted natively where a plugin supports it */
+	UInt64,				/*! uint64_t, the native key type of every plugin */
+	Int32,				/*! int32_t, sign bit flipped */
+	Int64,				/*! int64_t, sign bit flipped */
+	Float,				/*! IEEE-754 single precision, sign-dependent bit flip */
+	Double				/*! IEEE-754 double precision, sign-dependent bit flip */
+};
+
+/**	@brief	Parses a key type name
+ *	@param	text	u32, u64, i32, i64, f32 or f64
+ *	@return	The key type
+ *	@throws	std::invalid_argument	On any other name
+ */
+KeyType parseKeyType(const std::string& text);
+
+/**	@brief	Returns the short name of a key type (ie: u64)
+ *	@param	type	The key type
+ */
+const char* keyTypeName(KeyType type);
+
+/**	@brief	Order-preserving mapping of a key type onto unsigned radix keys
+ *	toRadix(a) < toRadix(b) exactly when a sorts before b, so any unsigned
+ *	sort of the mapped values sorts the keys. Signed integers have their sign
+ *	bit flipped. IEEE-754 values have the sign bit flipped when positive and
+ *	every bit inverted when negative, which orders -inf < negatives < -0.0
+ *	< +0.0 < positives < +inf, with NaNs at either end by sign.
+ */
+template<typename Key>
+struct KeyTraits;
+
+/**	@brief	Traits of uint32_t keys */
+template<>
+struct KeyTraits<uint32_t> {
+	typedef uint32_t Radix_t;
+	static constexpr KeyType Type = KeyType::UInt32;
+	static inline Radix_t toRadix(uint32_t key) { return key; }
+	static inline uint32_t fromRadix(Radix_t bits) { return bits; }
+};
+
+/**	@brief	Traits of uint64_t keys */
+template<>
+struct KeyTraits<uint64_t> {
+	typedef uint64_t Radix_t;
+	static constexpr KeyType Type = KeyType::UInt64;
+	static inline Radix_t toRadix(uint64_t key) { return key; }
+	static inline uint64_t fromRadix(Radix_t bits) { return bits; }
+};
+
+/**	@brief	Traits of int32_t keys */
+template<>
+struct KeyTraits<int32_t> {
+	typedef uint32_t Radix_t;
+	static constexpr KeyType Type = KeyType::Int32;
+	static inline Radix_t toRadix(int32_t key) { return (Radix_t) key ^ (1U << 31); }
+	static inline int32_t fromRadix(Radix_t bits) { return (int32_t) (bits ^ (1U << 31)); }
+};
+
+/**	@brief	Traits of int64_t keys */
+template<>
+struct KeyTraits<int64_t> {
+	typedef uint64_t Radix_t;
+	static constexpr KeyType Type = KeyType::Int64;
+	static inline Radix_t toRadix(int64_t key) { return (Radix_t) key ^ (1ULL << 63); }
+	static inline int64_t fromRadix(Radix_t bits) { return (int64_t) (bits ^ (1ULL << 63)); }
+};
+
+/**	@brief	Traits of single precision keys */
+template<>
+struct KeyTraits<float> {
+	typedef uint32_t Radix_t;
+	static constexpr KeyType Type = KeyType::Float;
+	static inline Radix_t toRadix(float key) {
+		Radix_t bits;
+		std::memcpy(&bits, &key, sizeof(bits));
+		return bits ^ ((Radix_t) ((int32_t) bits >> 31) | (1U << 31));
+	}
+	static inline float fromRadix(Radix_t bits) {
+		bits ^= (Radix_t) ((int32_t) ~bits >> 31) | (1U << 31);
+		float key;
+		std::memcpy(&key, &bits, sizeof(key));
+		return key;
+	}
+};
+
+/**	@brief	Traits of double precision keys */
+template<>
+struct KeyTraits<double> {
+	typedef uint64_t Radix_t;
+	static constexpr KeyType Type = KeyType::Double;
+	static inline Radix_t toRadix(double key) {
+		Radix_t bits;
+		std::memcpy(&bits, &key, sizeof(bits));
+		return bits ^ ((Radix_t) ((int64_t) bits >> 63) | (1ULL << 63));
+	}
+	static inline double fromRadix(Radix_t bits) {
+		bits ^= (Radix_t) ((int64_t) ~bits >> 63) | (1ULL << 63);
+		double key;
+		std::memcpy(&key, &bits, sizeof(key));
+		return key;
+	}
+};
+
+/**	@brief	Maps keys in place onto their unsigned radix keys
+ *	@param	keys	Keys to map
+ *	@param	count	Number of keys
+ *	@return	The same memory, viewed as radix keys
+ */
+template<typename Key>
+inline typename KeyTraits<Key>::Radix_t* toRadixKeys(Key* keys, size_t count) {
+	typedef typename KeyTraits<Key>::Radix_t Radix_t;
+	static_assert(sizeof(Radix_t) == sizeof(Key), "Radix keys must be the size of the keys");
+
+	Radix_t* bits = (Radix_t*) (void*) keys;
+	for(size_t idx = 0; idx < count; idx++) {
+		Radix_t mapped = KeyTraits<Key>::toRadix(keys[idx]);
+		std::memcpy(bits + idx, &mapped, sizeof(mapped));
+	}
+	return bits;
+}
+
+/**	@brief	Maps radix keys in place back onto the original keys
+ *	@param	bits	Radix keys from toRadixKeys()
+ *	@param	count	Number of keys
+ *	@return	The same memory, viewed as keys
+ */
+template<typename Key>
+inline Key* fromRadixKeys(typename KeyTraits<Key>::Radix_t* bits, size_t count) {
+	Key* keys = (Key*) (void*) bits;
+	for(size_t idx = 0; idx < count; idx++) {
+		Key key = KeyTraits<Key>::fromRadix(bits[idx]);
+		std::memcpy(keys + idx, &key, sizeof(key));
+	}
+	return keys;
+}
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,135 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _LOSERTREE_INCLUDED
+#define _LOSERTREE_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace JAC::Integer {
+
+/**	@brief	Tournament (loser) tree for k-way merging of sorted sources
+ *	Each internal node holds the source that lost the match played there, and
+ *	the overall winner is kept at the root, so replacing the winner's key costs
+ *	exactly one comparison per level. Ties go to the lower source index, which
+ *	keeps the merge stable with respect to source order.
+ *
+ *	Usage: set() the first key of every non-empty source, build(), then loop
+ *	on winner()/winnerKey() calling replace() with the source's next key or
+ *	pop() once it is exhausted, until empty().
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class LoserTree {
+public:
+	/**	@brief	Construct for a fixed number of sources, all initially exhausted
+	 *	@param	sources	Number of sources to merge (at least 1)
+	 */
+	explicit LoserTree(size_t sources) :
+		sources_(sources > 0 ? sources : 1),
+		tree_(sources_, 0),
+		keys_(sources_, 0),
+		live_(sources_, false) {}
+
+	/**	@brief	Sets the current key of a source before build()
+	 *	@param	source	Source index
+	 *	@param	key			The source's first key
+	 */
+	inline void set(size_t source, uint64_t key) {
+		keys_[source] = key;
+		live_[source] = true;
+	}
+
+	/**	@brief	Plays the initial tournament */
+	void build() {
+		//Winners of each subtree; leaf i lives at sources_ + i
+		std::vector<size_t> winners(sources_ * 2);
+		for(size_t source = 0; source < sources_; source++)
+			winners[sources_ + source] = source;
+
+		for(size_t node = sources_ - 1; node > 0; node--) {
+			size_t left = winners[node * 2];
+			size_t right = winners[node * 2 + 1];
+			if(beats(left, right)) {
+				winners[node] = left;
+				tree_[node] = right;
+			}
+			else {
+				winners[node] = right;
+				tree_[node] = left;
+			}
+		}
+		tree_[0] = (sources_ > 1) ? winners[1] : 0;
+	}
+
+	/**	@brief	True once every source is exhausted */
+	inline bool empty() const { return !live_[tree_[0]]; }
+
+	/**	@brief	Index of the source holding the smallest key */
+	inline size_t winner() const { return tree_[0]; }
+
+	/**	@brief	The smallest key across all sources */
+	inline uint64_t winnerKey() const { return keys_[tree_[0]]; }
+
+	/**	@brief	Replaces the winner's key with the next key from the same source
+	 *	@param	key	The next key; must not be less than the current winner key
+	 */
+	inline void replace(uint64_t key) {
+		size_t source = tree_[0];
+		keys_[source] = key;
+		replay(source);
+	}
+
+	/**	@brief	Marks the winning source as exhausted */
+	inline void pop() {
+		size_t source = tree_[0];
+		live_[source] = false;
+		replay(source);
+	}
+
+private:
+	/**	@brief	True if source a wins a match against source b */
+	inline bool beats(size_t a, size_t b) const {
+		if(live_[a] != live_[b]) return live_[a];
+		return keys_[a] < keys_[b] || (keys_[a] == keys_[b] && a < b);
+	}
+
+	/**	@brief	Replays the matches from a leaf up to the root */
+	inline void replay(size_t source) {
+		size_t winner = source;
+		for(size_t node = (sources_ + source) / 2; node > 0; node /= 2) {
+			if(beats(tree_[node], winner))
+				std::swap(tree_[node], winner);
+		}
+		tree_[0] = winner;
+	}
+
+private:
+	size_t							sources_;		/*! Number of sources */
+	std::vector<size_t>	tree_;			/*! Losers at internal nodes, winner at [0] */
+	std::vector<uint64_t>	keys_;		/*! Current key of each source */
+	std::vector<bool>		live_;			/*! False once a source is exhausted */
+};
+
+}; //End namespace
+
+#endif //Include once
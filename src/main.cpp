@@ -46,16 +46,17 @@ int main(int argc, char** argv) {
 	try {
 		//Timepoints before and after sort
 		auto start = high_resolution_clock::now();
-		IntArray_t sorted = sorter.sort();
+		sorter.sort();
 		auto stop = high_resolution_clock::now();
 
 		//Print sorted array to stdout w/millis
 		auto duration = duration_cast<microseconds>(stop-start);
 		double seconds = ((double)duration.count())/1000000;
 
-		//Output timer
-		std::cout << "Sorted using '" << sorter.algorithm() << "' algorithm in " <<
-			std::to_string(seconds) << " seconds" << std::endl;
+		//Output timer, worded for the mode that ran
+		std::string summary = sorter.summary();
+		if(!summary.empty())
+			std::cout << summary << " in " << std::to_string(seconds) << " seconds" << std::endl;
 	}
 	catch(const std::exception &e) {
 		std::cout << "Exception caught: " << e.what() << std::endl;
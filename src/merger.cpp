@@ -0,0 +1,232 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <stdexcept>
+//Project includes
+#include "merger.h"
+#include "losertree.h"
+
+namespace JAC::Integer {
+
+//Keys added to the delta array per read
+static const size_t DeltaReadKeys = 1 << 20;
+
+/**	@brief	Construct with a memory budget for the read and write buffers
+ *	@param	memoryBudget	Approximate bytes for all buffers, 0 for the default
+ */
+KeyMerger::KeyMerger(uint64_t memoryBudget) :
+	memoryBudget_(memoryBudget),
+	checked_(0),
+	deltaCount_(0),
+	badLines_(0)
+	{}
+
+/**	@brief	Destructor */
+KeyMerger::~KeyMerger() {
+}
+
+/**	@brief	Merges sorted files into one sorted output
+ *	@param	inputs				The sorted files; ties keep the order of the inputs
+ *	@param	outputPath		Path of the merged output, or "-" for standard output
+ *	@param	outputFormat	Format of the output file
+ *	@return	The number of keys written
+ *	@throws	std::runtime_error	On I/O errors or an input that is not sorted
+ */
+uint64_t KeyMerger::merge(const std::vector<KeySource>& inputs, const std::string& outputPath,
+	KeyFormat outputFormat) {
+	checked_ = 0;
+	deltaCount_ = 0;
+	badLines_ = 0;
+	errors_.clear();
+
+	const size_t blockKeys = blockKeysFor(inputs.size() + 1);
+	std::vector<Stream> streams;
+	for(const KeySource& input : inputs) {
+		streams.push_back(openFile(input, blockKeys));
+		if(streams.back().check) checked_++;
+	}
+
+	KeyWriter output(outputPath, outputFormat,
+		std::clamp<uint64_t>(blockKeys * sizeof(uint64_t), 64 << 10, MaxIoBytes));
+	output.setSorted(true);
+	mergeStreams(streams, output, blockKeys);
+	output.close();
+
+	for(const Stream& stream : streams) addBadLines(*stream.reader);
+	return output.count();
+}
+
+/**	@brief	Sorts a delta file in memory and merges it into a sorted base
+ *	@param	base					The sorted base file
+ *	@param	delta					Keys to add, in any order
+ *	@param	algorithm			The algorithm used to sort the delta
+ *	@param	outputPath		Path of the merged output, or "-" for standard output
+ *	@param	outputFormat	Format of the output file
+ *	@return	The number of keys written
+ *	@throws	std::runtime_error	On I/O errors or a base that is not sorted
+ */
+uint64_t KeyMerger::mergeDelta(const KeySource& base, const KeySource& delta,
+	SortAlgorithm& algorithm, const std::string& outputPath, KeyFormat outputFormat) {
+	checked_ = 0;
+	deltaCount_ = 0;
+	badLines_ = 0;
+	errors_.clear();
+
+	//Load the delta and sort it unless its header says it already is
+	SortAlgorithm::IntVector_t keys;
+	{
+		KeyReader reader(delta.path, delta.format);
+		size_t count = 0;
+		for(;;) {
+			keys.resize(count + DeltaReadKeys);
+			size_t got = reader.read(keys.data() + count, DeltaReadKeys);
+			if(got == 0) break;
+			count += got;
+		}
+		keys.resize(count);
+		addBadLines(reader);
+		if(!reader.sorted()) algorithm.sort(keys.data(), keys.size());
+	}
+	deltaCount_ = keys.size();
+
+	//Base first, so ties keep base keys ahead of delta keys
+	const size_t blockKeys = blockKeysFor(2);
+	std::vector<Stream> streams;
+	streams.push_back(openFile(base, blockKeys));
+	if(streams.back().check) checked_++;
+	streams.push_back({ nullptr, std::vector<uint64_t>(), keys.data(), 0, keys.size(), false, 0, 0 });
+
+	KeyWriter output(outputPath, outputFormat,
+		std::clamp<uint64_t>(blockKeys * sizeof(uint64_t), 64 << 10, MaxIoBytes));
+	output.setSorted(true);
+	mergeStreams(streams, output, blockKeys);
+	output.close();
+
+	addBadLines(*streams[0].reader);
+	return output.count();
+}
+
+/**	@brief	Keys per read and write block for a number of buffers
+ *	Half the budget goes to the blocks and half to the readers' own buffers.
+ *	@param	buffers	Read buffers plus the output buffer
+ */
+size_t KeyMerger::blockKeysFor(size_t buffers) const {
+	if(memoryBudget_ == 0) return DefaultBlockKeys;
+	return std::max<uint64_t>(MinBlockKeys, memoryBudget_ / 2 / sizeof(uint64_t) / buffers);
+}
+
+/**	@brief	Opens a file input, reading its first block
+ *	@param	input			The file
+ *	@param	blockKeys	Keys per read block
+ *	@return	The stream, checked unless the file is flagged as sorted
+ */
+KeyMerger::Stream KeyMerger::openFile(const KeySource& input, size_t blockKeys) {
+	Stream stream = { std::unique_ptr<KeyReader>(new KeyReader(input.path, input.format,
+		std::clamp<uint64_t>(blockKeys * sizeof(uint64_t), 64 << 10, MaxIoBytes))),
+		std::vector<uint64_t>(blockKeys), nullptr, 0, 0, false, 0, 0 };
+	stream.check = !stream.reader->sorted();
+	refill(stream);
+	return stream;
+}
+
+/**	@brief	Reads the next block of a stream, checking its order if required
+ *	@return	False once the stream is exhausted
+ */
+bool KeyMerger::refill(Stream& stream) {
+	if(!stream.reader) return false;
+
+	stream.consumed += stream.length;
+	stream.position = 0;
+	stream.block = stream.buffer.data();
+	stream.length = stream.reader->read(stream.buffer.data(), stream.buffer.size());
+	if(stream.length == 0) return false;
+
+	//Unflagged inputs are trusted no further than the keys read so far
+	if(stream.check) {
+		const uint64_t* end = stream.block + stream.length;
+		const uint64_t* bad = (stream.consumed > 0 && stream.block[0] < stream.last) ?
+			stream.block : std::is_sorted_until(stream.block, end);
+		if(bad != end)
+			throw std::runtime_error("'" + stream.reader->path() + "' is not sorted: key " +
+				std::to_string(stream.consumed + (bad - stream.block) + 1) +
+				" is less than the key before it");
+		stream.last = end[-1];
+	}
+	return true;
+}
+
+/**	@brief	Merges open streams into a writer
+ *	@param	streams		The streams, each positioned at its first block
+ *	@param	output		Destination for the merged keys
+ *	@param	blockKeys	Keys per output block
+ */
+void KeyMerger::mergeStreams(std::vector<Stream>& streams, KeyWriter& output,
+	size_t blockKeys) {
+	std::vector<uint64_t> out(blockKeys);
+	size_t outCount = 0;
+
+	LoserTree tree(streams.size());
+	size_t live = 0;
+	for(size_t source = 0; source < streams.size(); source++) {
+		if(streams[source].length == 0) continue;
+		tree.set(source, streams[source].block[0]);
+		live++;
+	}
+	tree.build();
+
+	while(live > 1) {
+		size_t source = tree.winner();
+		out[outCount++] = tree.winnerKey();
+		if(outCount == blockKeys) {
+			output.write(out.data(), outCount);
+			outCount = 0;
+		}
+
+		//Advance the winning stream, refilling its block as needed
+		Stream& stream = streams[source];
+		if(++stream.position == stream.length && !refill(stream)) {
+			tree.pop();
+			live--;
+			continue;
+		}
+		tree.replace(stream.block[stream.position]);
+	}
+	output.write(out.data(), outCount);
+
+	//A single stream left needs no comparisons; copy it through block by block
+	if(live == 1) {
+		Stream& stream = streams[tree.winner()];
+		do {
+			output.write(stream.block + stream.position, stream.length - stream.position);
+		} while(refill(stream));
+	}
+}
+
+/**	@brief	Adds the malformed lines of a finished reader to the totals */
+void KeyMerger::addBadLines(const KeyReader& reader) {
+	badLines_ += reader.badLines();
+	for(const ParseError& error : reader.errors()) {
+		if(errors_.size() < TextKeyParser::MaxReportedErrors)
+			errors_.push_back(error);
+	}
+}
+
+}; //End namespace
@@ -0,0 +1,155 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _MERGER_INCLUDED
+#define _MERGER_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+//Project includes
+#include "sortalgorithm.h"
+#include "keystream.h"
+
+namespace JAC::Integer {
+
+/**	@brief	A file of keys to merge */
+struct KeySource {
+	std::string	path;				/*! Path to the file */
+	KeyFormat		format;			/*! Format of the file */
+};
+
+/**	@brief	Streaming k-way merge of files that are already sorted
+ *	Each input is read in blocks and combined with a buffered loser tree, so
+ *	files of any size are merged in one sequential pass in bounded memory.
+ *	Binary inputs whose header carries the sorted flag are trusted; every
+ *	other input is checked block by block as it is consumed, which costs one
+ *	comparison per key, and a merge of unsorted input fails rather than
+ *	producing unsorted output. Once a single input remains, its keys are
+ *	copied through a block at a time without the tree.
+ *
+ *	mergeDelta() covers the incremental case of a large sorted base plus a
+ *	small unsorted delta: only the delta is loaded and sorted, so the cost is
+ *	one pass over the base plus the sort of the delta.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class KeyMerger {
+public:
+	//Read buffer per input when no memory budget is given, in keys
+	static constexpr size_t DefaultBlockKeys = 1 << 16;
+
+	//Smallest read buffer per input, in keys
+	static constexpr size_t MinBlockKeys = 1024;
+
+public:
+	/**	@brief	Construct with a memory budget for the read and write buffers
+	 *	@param	memoryBudget	Approximate bytes for all buffers, 0 for the default
+	 */
+	explicit KeyMerger(uint64_t memoryBudget = 0);
+
+	/**	@brief	Destructor */
+	virtual ~KeyMerger();
+
+	/**	@brief	Merges sorted files into one sorted output
+	 *	@param	inputs				The sorted files; ties keep the order of the inputs
+	 *	@param	outputPath		Path of the merged output, or "-" for standard output
+	 *	@param	outputFormat	Format of the output file
+	 *	@return	The number of keys written
+	 *	@throws	std::runtime_error	On I/O errors or an input that is not sorted
+	 */
+	uint64_t merge(const std::vector<KeySource>& inputs, const std::string& outputPath,
+		KeyFormat outputFormat);
+
+	/**	@brief	Sorts a delta file in memory and merges it into a sorted base
+	 *	@param	base					The sorted base file
+	 *	@param	delta					Keys to add, in any order
+	 *	@param	algorithm			The algorithm used to sort the delta
+	 *	@param	outputPath		Path of the merged output, or "-" for standard output
+	 *	@param	outputFormat	Format of the output file
+	 *	@return	The number of keys written
+	 *	@throws	std::runtime_error	On I/O errors or a base that is not sorted
+	 */
+	uint64_t mergeDelta(const KeySource& base, const KeySource& delta, SortAlgorithm& algorithm,
+		const std::string& outputPath, KeyFormat outputFormat);
+
+	/**	@brief	Number of inputs of the last merge checked rather than trusted */
+	inline size_t checked() const { return checked_; }
+
+	/**	@brief	Number of keys in the delta of the last mergeDelta() */
+	inline uint64_t deltaCount() const { return deltaCount_; }
+
+	/**	@brief	Number of malformed text lines skipped by the last merge */
+	inline uint64_t badLines() const { return badLines_; }
+
+	/**	@brief	The first malformed text lines skipped by the last merge */
+	inline const std::vector<ParseError>& errors() const { return errors_; }
+
+private:
+	/**	@brief	One sorted input: a file read in blocks, or keys already in memory */
+	struct Stream {
+		std::unique_ptr<KeyReader>	reader;		/*! Reader for a file, null for memory */
+		std::vector<uint64_t>				buffer;		/*! Read block for a file */
+		const uint64_t*							block;		/*! Current block of keys */
+		size_t											position;	/*! Next key in block */
+		size_t											length;		/*! Keys in block */
+		bool												check;		/*! Verify the keys are ascending */
+		uint64_t										last;			/*! Last key of the previous block */
+		uint64_t										consumed;	/*! Keys in earlier blocks */
+	};
+
+	/**	@brief	Keys per read and write block for a number of buffers
+	 *	@param	buffers	Read buffers plus the output buffer
+	 */
+	size_t blockKeysFor(size_t buffers) const;
+
+	/**	@brief	Opens a file input, reading its first block
+	 *	@param	input			The file
+	 *	@param	blockKeys	Keys per read block
+	 *	@return	The stream, checked unless the file is flagged as sorted
+	 */
+	Stream openFile(const KeySource& input, size_t blockKeys);
+
+	/**	@brief	Reads the next block of a stream, checking its order if required
+	 *	@return	False once the stream is exhausted
+	 */
+	bool refill(Stream& stream);
+
+	/**	@brief	Merges open streams into a writer
+	 *	@param	streams		The streams, each positioned at its first block
+	 *	@param	output		Destination for the merged keys
+	 *	@param	blockKeys	Keys per output block
+	 */
+	void mergeStreams(std::vector<Stream>& streams, KeyWriter& output, size_t blockKeys);
+
+	/**	@brief	Adds the malformed lines of a finished reader to the totals */
+	void addBadLines(const KeyReader& reader);
+
+private:
+	uint64_t								memoryBudget_;/*! Bytes for buffers, 0 for the default */
+	size_t									checked_;			/*! Inputs checked in the last merge */
+	uint64_t								deltaCount_;	/*! Delta keys in the last mergeDelta */
+	uint64_t								badLines_;		/*! Malformed lines in the last merge */
+	std::vector<ParseError>	errors_;			/*! First malformed lines in the last merge */
+};
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,188 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+//Project includes
+#include "msdradix.h"
+
+/**	@brief	Create instance of the MSD radix sort class from shared object
+ *	@return	A new instance of MsdRadixSort as Sorter*
+ */
+extern "C" JAC::Integer::SortAlgorithm* create() {
+	return new JAC::Integer::MsdRadixSort();
+}
+
+/**	@brief	Deletes the specified instance of a MsdRadixSort, allocated by this module
+ *	@param	val	Pointer to a MsdRadixSort that was allocated by this module's
+ * 							CreateInstance() function
+ */
+extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
+	if(obj != nullptr) delete obj;
+	obj = nullptr;
+}
+
+/**	@brief	Describes the in-place MSD radix sort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		false,	//Stable
+		true,	//In place
+		false,	//Parallel
+		0.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth64,	//Key widths
+		1 << 10,	//Min keys
+		0,	//Max keys
+		"In-place MSD (American flag) radix sort"
+	};
+	return &caps;
+}
+
+namespace JAC::Integer {
+
+/**	@brief	Default constructor */
+MsdRadixSort::MsdRadixSort() {
+}
+
+/**	@brief	Destructor */
+MsdRadixSort::~MsdRadixSort() {
+}
+
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void MsdRadixSort::sort(uint64_t* keys, size_t count) {
+	//Nothing to do for empty or single-value arrays
+	if(count < 2)
+		return;
+
+	//Start at the most significant byte that is set in any key
+	uint64_t bits = 0;
+	for(size_t idx = 0; idx < count; idx++) bits |= keys[idx];
+	if(bits == 0)
+		return;
+
+	int highest = 63 - __builtin_clzll(bits);
+	sortRange(keys, count, (highest / DigitBits) * DigitBits);
+}
+
+/**	@brief	Sets an MSD radix tuning option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True if the option is recognized, otherwise false
+ *	@throws	std::invalid_argument	On an invalid value for a recognized option
+ */
+bool MsdRadixSort::setOption(const std::string& name, const std::string& value) {
+	if(name != "insertion-threshold")
+		return false;
+
+	try {
+		insertionThreshold_ = std::stoull(value);
+	}
+	catch(const std::exception&) {
+		throw std::invalid_argument("Invalid value for " + name + ": " + value);
+	}
+	return true;
+}
+
+/**	@brief	Sorts a range on the digit at shift and recurses on lower digits
+ *	@param	data		First key of the range
+ *	@param	length	Number of keys in the range
+ *	@param	shift		Bit position of the digit to partition on
+ */
+void MsdRadixSort::sortRange(uint64_t* data, size_t length, int shift) {
+	//Bucket sizes, and bucket boundaries; heads advance as keys are placed
+	size_t counts[Buckets];
+	size_t heads[Buckets];
+	size_t tails[Buckets];
+
+	for(;;) {
+		if(length <= insertionThreshold_) {
+			insertionSort(data, length);
+			return;
+		}
+
+		//Count keys per bucket for this digit
+		std::fill(counts, counts + Buckets, 0);
+		for(size_t idx = 0; idx < length; idx++)
+			counts[(data[idx] >> shift) & (Buckets-1)]++;
+
+		//All keys in one bucket? Move straight to the next digit
+		uint32_t first = 0;
+		while(counts[first] == 0) first++;
+		if(counts[first] < length)
+			break;
+		if(shift == 0)
+			return;
+		shift -= DigitBits;
+	}
+
+	size_t offset = 0;
+	for(uint32_t bucket = 0; bucket < Buckets; bucket++) {
+		heads[bucket] = offset;
+		offset += counts[bucket];
+		tails[bucket] = offset;
+	}
+
+	//Permute keys into their buckets by following swap cycles
+	for(uint32_t bucket = 0; bucket < Buckets; bucket++) {
+		while(heads[bucket] < tails[bucket]) {
+			uint64_t val = data[heads[bucket]];
+			uint32_t target = (val >> shift) & (Buckets-1);
+			while(target != bucket) {
+				std::swap(val, data[heads[target]++]);
+				target = (val >> shift) & (Buckets-1);
+			}
+			data[heads[bucket]++] = val;
+		}
+	}
+
+	//Sort each bucket on the next digit
+	if(shift == 0) return;
+	size_t begin = 0;
+	for(uint32_t bucket = 0; bucket < Buckets; bucket++) {
+		size_t end = tails[bucket];
+		if(end - begin > 1)
+			sortRange(data + begin, end - begin, shift - DigitBits);
+		begin = end;
+	}
+}
+
+/**	@brief	Insertion sort for small ranges
+ *	@param	data		First key of the range
+ *	@param	length	Number of keys in the range
+ */
+void MsdRadixSort::insertionSort(uint64_t* data, size_t length) {
+	for(size_t idx = 1; idx < length; idx++) {
+		uint64_t val = data[idx];
+		size_t pos = idx;
+		while(pos > 0 && data[pos-1] > val) {
+			data[pos] = data[pos-1];
+			pos--;
+		}
+		data[pos] = val;
+	}
+}
+
+}; //End namespace
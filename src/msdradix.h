@@ -0,0 +1,100 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _MSDRADIX_INCLUDED
+#define _MSDRADIX_INCLUDED
+//System includes
+//Library includes
+#include <string>
+#include <vector>
+//Project includes
+#include "sortalgorithm.h"
+
+namespace JAC::Integer {
+
+/**	@brief	In-place MSD radix sort (American flag sort) for sorting library
+ *	Keys are permuted into their byte buckets within the caller's array by
+ *	following swap cycles, then each bucket is sorted on the next byte down.
+ *	Auxiliary memory is three arrays of 256 counters per recursion level
+ *	(bucket sizes, heads and tails; at most eight levels), independent of
+ *	the input size. Buckets at or below the insertion threshold are finished
+ *	with an insertion sort.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class MsdRadixSort : public SortAlgorithm {
+private:
+	//Bits per digit and buckets per level
+	static const uint8_t DigitBits = 8;
+	static const uint32_t Buckets = 1 << DigitBits;
+
+	//Default bucket size at or below which insertion sort is used
+	static const size_t DefaultInsertionThreshold = 64;
+
+private:
+	//The sort type string
+	std::string 			type_ = "msdradix";
+
+	//Bucket size at or below which insertion sort is used
+	size_t						insertionThreshold_ = DefaultInsertionThreshold;
+
+public:
+	/**	@brief	Default constructor */
+	MsdRadixSort();
+
+	/**	@brief	Destructor */
+	virtual ~MsdRadixSort();
+
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	void sort(uint64_t* keys, size_t count) override;
+
+	/**	@brief	Sets an MSD radix tuning option
+	 *	Recognized options:
+	 *		insertion-threshold	Bucket size at or below which insertion sort is used
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized, otherwise false
+	 *	@throws	std::invalid_argument	On an invalid value for a recognized option
+	 */
+	bool setOption(const std::string& name, const std::string& value) override;
+
+private:
+	/**	@brief	Sorts a range on the digit at shift and recurses on lower digits
+	 *	@param	data		First key of the range
+	 *	@param	length	Number of keys in the range
+	 *	@param	shift		Bit position of the digit to partition on
+	 */
+	void sortRange(uint64_t* data, size_t length, int shift);
+
+	/**	@brief	Insertion sort for small ranges
+	 *	@param	data		First key of the range
+	 *	@param	length	Number of keys in the range
+	 */
+	static void insertionSort(uint64_t* data, size_t length);
+};
+
+MsdRadixSort __msdradixsort_instance;
+
+}; //End namespace
+
+#endif //Include once
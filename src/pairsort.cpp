@@ -0,0 +1,156 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+//Project includes
+#include "pairsort.h"
+
+namespace JAC::Integer {
+
+/**	@brief	LSD sort of records through a scratch arena, leaving them in place
+ *	@param	engine		Digit layout
+ *	@param	records		Records to sort
+ *	@param	buffer		Scratch buffer of at least count records
+ *	@param	count			Number of records
+ */
+template<typename Record>
+static void sortInPlace(const RadixEngine& engine, Record* records, Record* buffer,
+	size_t count) {
+	std::vector<uint64_t> counts(engine.histogramSize());
+	Record* result = engine.sort(records, buffer, count, counts.data());
+	if(result != records)
+		std::memcpy((void*) records, result, count * sizeof(Record));
+}
+
+/**	@brief	Parses a pair layout name
+ *	@param	text	"split" or "packed"
+ *	@return	The layout
+ *	@throws	std::invalid_argument	On any other name
+ */
+PairLayout parsePairLayout(const std::string& text) {
+	if(text == "split") return PairLayout::Split;
+	if(text == "packed") return PairLayout::Packed;
+	throw std::invalid_argument("Invalid pair layout '" + text + "' (split or packed)");
+}
+
+/**	@brief	Stable LSD radix sort of keys, moving a payload array with them
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to sort
+ *	@param	values		Payloads, one per key
+ *	@param	count			Number of keys
+ *	@param	layout		Layout used during the passes
+ */
+void radixSortPairs(const RadixEngine& engine, ScratchArena& scratch, uint64_t* keys,
+	uint64_t* values, size_t count, PairLayout layout) {
+	if(count < 2) return;
+
+	if(layout == PairLayout::Packed) {
+		KeyValue* records = scratch.reserve<KeyValue>(2 * count);
+		for(size_t idx = 0; idx < count; idx++)
+			records[idx] = { keys[idx], values[idx] };
+		sortInPlace(engine, records, records + count, count);
+		for(size_t idx = 0; idx < count; idx++) {
+			keys[idx] = records[idx].key;
+			values[idx] = records[idx].value;
+		}
+		return;
+	}
+
+	uint64_t* keyScratch = scratch.reserve<uint64_t>(2 * count);
+	uint64_t* valueScratch = keyScratch + count;
+	std::vector<uint64_t> counts(engine.histogramSize());
+	if(!engine.sortPairs(keys, values, keyScratch, valueScratch, count, counts.data())) {
+		std::memcpy(keys, keyScratch, count * sizeof(uint64_t));
+		std::memcpy(values, valueScratch, count * sizeof(uint64_t));
+	}
+}
+
+/**	@brief	Stable LSD radix sort of key/value records by key
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	records		Records to sort
+ *	@param	count			Number of records
+ */
+void radixSortRecords(const RadixEngine& engine, ScratchArena& scratch, KeyValue* records,
+	size_t count) {
+	if(count < 2) return;
+	sortInPlace(engine, records, scratch.reserve<KeyValue>(count), count);
+}
+
+/**	@brief	Stable LSD radix argsort with 32-bit indices
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to order; not modified
+ *	@param	count			Number of keys, at most UINT32_MAX
+ *	@param	indices		Receives count indices
+ *	@throws	std::invalid_argument	If count does not fit in 32 bits
+ */
+void radixArgsort(const RadixEngine& engine, ScratchArena& scratch, const uint64_t* keys,
+	size_t count, uint32_t* indices) {
+	if(count > UINT32_MAX)
+		throw std::invalid_argument("Too many keys for 32-bit indices: " +
+			std::to_string(count));
+
+	KeyIndex* records = scratch.reserve<KeyIndex>(2 * count);
+	for(size_t idx = 0; idx < count; idx++)
+		records[idx] = { keys[idx], (uint32_t) idx };
+	if(count > 1)
+		sortInPlace(engine, records, records + count, count);
+	for(size_t idx = 0; idx < count; idx++)
+		indices[idx] = records[idx].index;
+}
+
+/**	@brief	Stable LSD radix argsort with 64-bit indices
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to order; not modified
+ *	@param	count			Number of keys
+ *	@param	indices		Receives count indices
+ *	@param	layout		Layout used during the passes
+ */
+void radixArgsort(const RadixEngine& engine, ScratchArena& scratch, const uint64_t* keys,
+	size_t count, uint64_t* indices, PairLayout layout) {
+	if(layout == PairLayout::Packed) {
+		KeyValue* records = scratch.reserve<KeyValue>(2 * count);
+		for(size_t idx = 0; idx < count; idx++)
+			records[idx] = { keys[idx], idx };
+		if(count > 1)
+			sortInPlace(engine, records, records + count, count);
+		for(size_t idx = 0; idx < count; idx++)
+			indices[idx] = records[idx].value;
+		return;
+	}
+
+	//The keys are not ours to reorder, so sort a copy alongside the indices
+	uint64_t* copy = scratch.reserve<uint64_t>(3 * count);
+	uint64_t* keyScratch = copy + count;
+	uint64_t* indexScratch = keyScratch + count;
+	std::memcpy(copy, keys, count * sizeof(uint64_t));
+	for(size_t idx = 0; idx < count; idx++)
+		indices[idx] = idx;
+	std::vector<uint64_t> counts(engine.histogramSize());
+	if(!engine.sortPairs(copy, indices, keyScratch, indexScratch, count, counts.data()))
+		std::memcpy(indices, indexScratch, count * sizeof(uint64_t));
+}
+
+}; //End namespace
@@ -0,0 +1,109 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PAIRSORT_INCLUDED
+#define _PAIRSORT_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+//Project includes
+#include "radixengine.h"
+#include "scratch.h"
+#include "sortalgorithm.h"
+
+namespace JAC::Integer {
+
+/**	@brief	A key and a 32-bit index, packed into 12 bytes for argsort */
+struct __attribute__((packed)) KeyIndex {
+	uint64_t	key;				/*! Sort key */
+	uint32_t	index;			/*! Position of the key in the input */
+};
+static_assert(sizeof(KeyIndex) == 12, "KeyIndex must be packed");
+
+/**	@brief	Sort key of a key/value record */
+inline uint64_t radixKey(const KeyValue& record) { return record.key; }
+
+/**	@brief	Sort key of a key/index record */
+inline uint64_t radixKey(const KeyIndex& record) { return record.key; }
+
+/**	@brief	How keys and payloads are laid out while they are radix sorted */
+enum class PairLayout {
+	Split,				/*! Parallel key and payload arrays, scattered side by side */
+	Packed				/*! Interleaved KeyValue records, one write stream per pass */
+};
+
+/**	@brief	Parses a pair layout name
+ *	@param	text	"split" or "packed"
+ *	@return	The layout
+ *	@throws	std::invalid_argument	On any other name
+ */
+PairLayout parsePairLayout(const std::string& text);
+
+/**	@brief	Stable LSD radix sort of keys, moving a payload array with them
+ *	With PairLayout::Packed the pairs are interleaved into KeyValue records
+ *	first, so each pass reads and writes one stream rather than two; this
+ *	costs a pack and an unpack pass but usually wins once the arrays are well
+ *	beyond the cache.
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to sort
+ *	@param	values		Payloads, one per key
+ *	@param	count			Number of keys
+ *	@param	layout		Layout used during the passes
+ */
+void radixSortPairs(const RadixEngine& engine, ScratchArena& scratch, uint64_t* keys,
+	uint64_t* values, size_t count, PairLayout layout);
+
+/**	@brief	Stable LSD radix sort of key/value records by key
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	records		Records to sort
+ *	@param	count			Number of records
+ */
+void radixSortRecords(const RadixEngine& engine, ScratchArena& scratch, KeyValue* records,
+	size_t count);
+
+/**	@brief	Stable LSD radix argsort with 32-bit indices
+ *	On return keys[indices[0]] <= keys[indices[1]] <= ..., with equal keys in
+ *	input order. Sorted as packed 12-byte KeyIndex records.
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to order; not modified
+ *	@param	count			Number of keys, at most UINT32_MAX
+ *	@param	indices		Receives count indices
+ *	@throws	std::invalid_argument	If count does not fit in 32 bits
+ */
+void radixArgsort(const RadixEngine& engine, ScratchArena& scratch, const uint64_t* keys,
+	size_t count, uint32_t* indices);
+
+/**	@brief	Stable LSD radix argsort with 64-bit indices
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to order; not modified
+ *	@param	count			Number of keys
+ *	@param	indices		Receives count indices
+ *	@param	layout		Layout used during the passes
+ */
+void radixArgsort(const RadixEngine& engine, ScratchArena& scratch, const uint64_t* keys,
+	size_t count, uint64_t* indices, PairLayout layout);
+
+}; //End namespace
+
+#endif //Include once
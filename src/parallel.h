@@ -0,0 +1,137 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PARALLEL_INCLUDED
+#define _PARALLEL_INCLUDED
+//System includes
+#include <time.h>
+//Library includes
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <vector>
+//Project includes
+#include "threadpool.h"
+
+namespace JAC::Integer {
+
+/**	@brief	CPU time consumed by the calling thread, in seconds
+ *	Unlike wall time, this does not count time the thread spent waiting for
+ *	a core, so summed over threads it measures the work actually done.
+ */
+inline double threadCpuSeconds() {
+	struct timespec now;
+	::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**	@brief	Returns the number of hardware threads, at least 1 */
+inline unsigned hardwareThreads() {
+	unsigned count = std::thread::hardware_concurrency();
+	return (count > 0) ? count : 1;
+}
+
+/**	@brief	Default thread count for parallel work started by the calling thread
+ *	The limit of the innermost ConcurrencyScope, else the shared pool size.
+ */
+inline unsigned defaultThreads() {
+	return ConcurrencyScope::threads();
+}
+
+/**	@brief	Most threads parallelFor() runs at once from the calling thread */
+inline unsigned maxConcurrency() {
+	return ThreadPool::shared().concurrency();
+}
+
+/**	@brief	Runs fn(tid) for tid in [0, count), one thread per tid
+ *	The calling thread runs tid 0; the others run concurrently on workers of
+ *	the shared ThreadPool, so they may meet at a Barrier as long as count is
+ *	at most maxConcurrency(). Beyond that each thread runs several tids in
+ *	turn; called from a worker (ie: a nested parallelFor or a sort started by
+ *	a pool task), the calling thread runs them all. Each inherits the caller's
+ *	ConcurrencyScope and is pinned to its CPUs, if any. If any invocation
+ *	throws, the first exception is rethrown once all threads have finished.
+ *	@param	count	Number of threads
+ *	@param	fn		Callable taking the thread index (unsigned)
+ */
+template<typename Function>
+void parallelFor(unsigned count, Function&& fn) {
+	std::vector<std::exception_ptr> errors(count);
+	const unsigned threads = ConcurrencyScope::threads();
+	const std::vector<unsigned> cpus = ConcurrencyScope::cpus();
+	const unsigned width = (count > 1) ? std::min(count, maxConcurrency()) : count;
+	auto run = [&](unsigned first) {
+		ConcurrencyScope scope(threads, cpus);
+		AffinityGuard pin(cpus);
+		for(unsigned tid = first; tid < count; tid += width) {
+			try {
+				fn(tid);
+			}
+			catch(...) {
+				errors[tid] = std::current_exception();
+			}
+		}
+	};
+
+	if(width == 1)
+		run(0);
+	else if(width > 1)
+		ThreadPool::shared().runConcurrently(width, run);
+
+	for(std::exception_ptr& error : errors) {
+		if(error) std::rethrow_exception(error);
+	}
+}
+
+/**	@brief	Reusable barrier for a fixed number of threads
+ *	@author	jcleland@jamescleland.com
+ */
+class Barrier {
+public:
+	/**	@brief	Construct for the specified number of participating threads */
+	explicit Barrier(unsigned count) : count_(count), waiting_(0), generation_(0) {}
+
+	/**	@brief	Blocks until all participating threads have arrived */
+	void wait() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		uint64_t generation = generation_;
+		if(++waiting_ == count_) {
+			waiting_ = 0;
+			generation_++;
+			cond_.notify_all();
+		}
+		else {
+			cond_.wait(lock, [&] { return generation != generation_; });
+		}
+	}
+
+private:
+	std::mutex							mutex_;				/*! Guards the counters */
+	std::condition_variable	cond_;				/*! Signalled when a generation completes */
+	unsigned								count_;				/*! Number of participating threads */
+	unsigned								waiting_;			/*! Threads waiting in this generation */
+	uint64_t								generation_;	/*! Incremented each time the barrier opens */
+};
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,307 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+//Project includes
+#include "parradix.h"
+#include "parallel.h"
+
+/**	@brief	Create instance of the parallel radix sort class from shared object
+ *	@return	A new instance of ParallelRadixSort as Sorter*
+ */
+extern "C" JAC::Integer::SortAlgorithm* create() {
+	return new JAC::Integer::ParallelRadixSort();
+}
+
+/**	@brief	Deletes the specified instance of a ParallelRadixSort, allocated by this module
+ *	@param	val	Pointer to a ParallelRadixSort that was allocated by this module's
+ * 							CreateInstance() function
+ */
+extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
+	if(obj != nullptr) delete obj;
+	obj = nullptr;
+}
+
+/**	@brief	Describes the parallel radix sort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		true,	//Stable
+		false,	//In place
+		true,	//Parallel
+		8.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth64,	//Key widths
+		1 << 20,	//Min keys
+		0,	//Max keys
+		"Multithreaded LSD radix sort"
+	};
+	return &caps;
+}
+
+namespace JAC::Integer {
+
+/**	@brief	Default constructor */
+ParallelRadixSort::ParallelRadixSort() {
+}
+
+/**	@brief	Destructor */
+ParallelRadixSort::~ParallelRadixSort() {
+}
+
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void ParallelRadixSort::sort(uint64_t* keys, size_t count) {
+	//Nothing to do for empty or single-value arrays
+	if(count < 2)
+		return;
+
+	//Odd number of passes leaves the sorted data in the scratch buffer
+	uint64_t* scratch = scratch_.reserve<uint64_t>(count);
+	uint64_t* result = sortWithScratch(keys, scratch, count);
+	if(result != keys)
+		std::memcpy(keys, result, count * sizeof(uint64_t));
+	scratch_.trim();
+}
+
+/**	@brief	Sorts using a caller-provided scratch buffer
+ *	@param	data		Keys to sort
+ *	@param	scratch	Scratch buffer of at least length elements
+ *	@param	length	Number of keys
+ *	@return	Pointer to the sorted keys; either data or scratch
+ */
+uint64_t* ParallelRadixSort::sortWithScratch(uint64_t* data, uint64_t* scratch, size_t length) {
+	//Limit threads so every block is worth the thread, and so all of them
+	//can meet at the barrier
+	size_t threads = (threads_ > 0) ? threads_ : defaultThreads();
+	threads = std::min(threads, length / MinKeysPerThread);
+	if(threads > 1) threads = std::min<size_t>(threads, maxConcurrency());
+
+	if(threads < 2) {
+		count_.resize(engine_.histogramSize());
+		return engine_.sort(data, scratch, length, count_.data());
+	}
+	return parallelSort(data, scratch, length, (unsigned) threads);
+}
+
+/**	@brief	Sets a parallel radix tuning option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True if the option is recognized, otherwise false
+ *	@throws	std::invalid_argument	On an invalid value for a recognized option
+ */
+bool ParallelRadixSort::setOption(const std::string& name, const std::string& value) {
+	if(scratch_.setOption(name, value))
+		return true;
+	if(name == "pair-layout") {
+		layout_ = parsePairLayout(value);
+		return true;
+	}
+	if(name != "digit-bits" && name != "threads")
+		return false;
+
+	unsigned long parsed = 0;
+	try {
+		parsed = std::stoul(value);
+	}
+	catch(const std::exception&) {
+		throw std::invalid_argument("Invalid value for " + name + ": " + value);
+	}
+
+	if(name == "digit-bits")
+		engine_.setDigitBits((uint8_t) std::min(parsed, 255UL));
+	else
+		threads_ = (unsigned) parsed;
+	return true;
+}
+
+/**	@brief	Sorts using a fixed number of threads
+ *	@param	data		Keys to sort
+ *	@param	scratch	Scratch buffer of at least length elements
+ *	@param	length	Number of keys
+ *	@param	threads	Number of threads to use
+ *	@return	Pointer to the sorted keys; either data or scratch
+ */
+uint64_t* ParallelRadixSort::parallelSort(uint64_t* data, uint64_t* scratch,
+	size_t length, unsigned threads) {
+	const size_t histSize = engine_.histogramSize();
+	const uint32_t buckets = engine_.buckets();
+
+	//Write-combining buffers only pay off while they stay cache resident
+	const bool combine = (buckets <= 2048);
+
+	//Everything shared between threads is allocated up front, so nothing in
+	//the thread body can throw while other threads wait at the barrier
+	count_.assign(histSize * threads, 0);
+	RadixCount_t totals(buckets);
+	std::vector<uint8_t> passes;
+	std::vector<uint64_t> combineKeys(combine ? (size_t) threads * buckets * WriteCombineKeys : 0);
+	std::vector<uint8_t> combineFill(combine ? (size_t) threads * buckets : 0);
+	Barrier barrier(threads);
+
+	parallelFor(threads, [&](unsigned tid) {
+		const size_t begin = length * tid / threads;
+		const size_t end = length * (tid+1) / threads;
+		uint64_t* counts = count_.data() + histSize * tid;
+		uint64_t* src = data;
+		uint64_t* dst = scratch;
+
+		//Histograms for every digit of this block in one read
+		engine_.histogram(data + begin, end - begin, counts);
+		barrier.wait();
+
+		//Plan the passes; a digit shared by every key needs no pass
+		if(tid == 0) {
+			for(uint8_t pass = 0; pass < engine_.passes(); pass++) {
+				std::fill(totals.begin(), totals.end(), 0);
+				for(unsigned t = 0; t < threads; t++) {
+					const uint64_t* block = count_.data() + histSize * t + (size_t) pass * buckets;
+					for(uint32_t bucket = 0; bucket < buckets; bucket++)
+						totals[bucket] += block[bucket];
+				}
+				if(!engine_.trivialPass(totals.data(), length))
+					passes.push_back(pass);
+			}
+		}
+		barrier.wait();
+
+		for(size_t step = 0; step < passes.size(); step++) {
+			const uint8_t pass = passes[step];
+			uint64_t* offsets = counts + (size_t) pass * buckets;
+
+			//Counts for the first pass came from the initial read; later passes
+			//see a permuted block and must be recounted
+			if(step > 0) {
+				std::fill(offsets, offsets + buckets, 0);
+				for(size_t idx = begin; idx < end; idx++)
+					offsets[engine_.digit(src[idx], pass)]++;
+			}
+			barrier.wait();
+
+			//Column-wise prefix over threads for this thread's range of buckets
+			const uint32_t bucketBegin = (uint32_t) ((uint64_t) buckets * tid / threads);
+			const uint32_t bucketEnd = (uint32_t) ((uint64_t) buckets * (tid+1) / threads);
+			for(uint32_t bucket = bucketBegin; bucket < bucketEnd; bucket++) {
+				uint64_t run = 0;
+				for(unsigned t = 0; t < threads; t++) {
+					uint64_t& count = count_[histSize * t + (size_t) pass * buckets + bucket];
+					uint64_t value = count;
+					count = run;
+					run += value;
+				}
+				totals[bucket] = run;
+			}
+			barrier.wait();
+
+			//Bucket base offsets across all threads
+			if(tid == 0) engine_.prefixOffsets(totals.data());
+			barrier.wait();
+			for(uint32_t bucket = 0; bucket < buckets; bucket++)
+				offsets[bucket] += totals[bucket];
+
+			//Scatter this block, staging keys a cache line at a time
+			if(combine) {
+				const uint8_t shift = pass * engine_.digitBits();
+				const uint64_t mask = buckets - 1;
+				uint64_t* lines = combineKeys.data() + (size_t) tid * buckets * WriteCombineKeys;
+				uint8_t* fill = combineFill.data() + (size_t) tid * buckets;
+				std::fill(fill, fill + buckets, 0);
+
+				for(size_t idx = begin; idx < end; idx++) {
+					uint64_t key = src[idx];
+					uint32_t bucket = (uint32_t) ((key >> shift) & mask);
+					uint64_t* line = lines + (size_t) bucket * WriteCombineKeys;
+					line[fill[bucket]++] = key;
+					if(fill[bucket] == WriteCombineKeys) {
+						std::memcpy(dst + offsets[bucket], line, sizeof(uint64_t) * WriteCombineKeys);
+						offsets[bucket] += WriteCombineKeys;
+						fill[bucket] = 0;
+					}
+				}
+
+				//Flush partially filled lines
+				for(uint32_t bucket = 0; bucket < buckets; bucket++) {
+					if(fill[bucket] == 0) continue;
+					std::memcpy(dst + offsets[bucket], lines + (size_t) bucket * WriteCombineKeys,
+						sizeof(uint64_t) * fill[bucket]);
+					offsets[bucket] += fill[bucket];
+				}
+			}
+			else {
+				engine_.scatter(src + begin, dst, end - begin, pass, offsets);
+			}
+			barrier.wait();
+
+			//Swap input/output
+			uint64_t* temp = dst;
+			dst = src;
+			src = temp;
+		}
+	});
+
+	return (passes.size() % 2 == 0) ? data : scratch;
+}
+
+/**	@brief	Stable LSD radix sort of keys, moving a payload array with them
+ *	@param	keys		Keys to sort
+ *	@param	values	Payloads, one per key
+ *	@param	count		Number of keys
+ */
+void ParallelRadixSort::sortPairs(uint64_t* keys, uint64_t* values, size_t count) {
+	radixSortPairs(engine_, scratch_, keys, values, count, layout_);
+	scratch_.trim();
+}
+
+/**	@brief	Stable LSD radix sort of packed key/value records by key
+ *	@param	records	Records to sort
+ *	@param	count		Number of records
+ */
+void ParallelRadixSort::sortRecords(KeyValue* records, size_t count) {
+	radixSortRecords(engine_, scratch_, records, count);
+	scratch_.trim();
+}
+
+/**	@brief	Stable LSD radix argsort with 32-bit indices
+ *	@param	keys		Keys to order
+ *	@param	count		Number of keys, at most UINT32_MAX
+ *	@param	indices	Receives count indices
+ *	@throws	std::invalid_argument	If count does not fit in 32 bits
+ */
+void ParallelRadixSort::argsort(const uint64_t* keys, size_t count, uint32_t* indices) {
+	radixArgsort(engine_, scratch_, keys, count, indices);
+	scratch_.trim();
+}
+
+/**	@brief	Stable LSD radix argsort with 64-bit indices
+ *	@param	keys		Keys to order
+ *	@param	count		Number of keys
+ *	@param	indices	Receives count indices
+ */
+void ParallelRadixSort::argsort(const uint64_t* keys, size_t count, uint64_t* indices) {
+	radixArgsort(engine_, scratch_, keys, count, indices, layout_);
+	scratch_.trim();
+}
+
+}; //End namespace
@@ -0,0 +1,152 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PARRADIX_INCLUDED
+#define _PARRADIX_INCLUDED
+//System includes
+//Library includes
+#include <string>
+#include <vector>
+//Project includes
+#include "sortalgorithm.h"
+#include "pairsort.h"
+#include "radixengine.h"
+#include "scratch.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Multithreaded LSD radix sort implementation for sorting library
+ *	The input is split into one contiguous block per thread. Each thread builds
+ *	the histograms of its block, global offsets are computed from the per-thread
+ *	counts, and every thread then scatters its block into the scratch buffer
+ *	through per-bucket write-combining buffers, so each store to the scratch
+ *	buffer is a full cache line rather than a single key.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class ParallelRadixSort : public SortAlgorithm {
+private:
+	//Container of radix counters
+	typedef std::vector<uint64_t>		RadixCount_t;
+
+	//Keys per write-combining buffer (one 64 byte cache line)
+	static const uint32_t WriteCombineKeys = 8;
+
+	//Below this many keys per thread the serial engine is used
+	static const size_t MinKeysPerThread = 1 << 16;
+
+private:
+	//The sort type string
+	std::string 			type_ = "parradix";
+
+	//Digit layout and pass primitives
+	RadixEngine				engine_;
+
+	//Number of threads to use, 0 for the default
+	unsigned					threads_ = 0;
+
+	//Histograms for all digits, one block of histogramSize() per thread
+	RadixCount_t			count_;
+
+	//Scratch buffer reused across sorts
+	ScratchArena			scratch_;
+
+	//Key/payload layout used by sortPairs() and argsort()
+	PairLayout				layout_ = PairLayout::Split;
+
+public:
+	/**	@brief	Default constructor */
+	ParallelRadixSort();
+
+	/**	@brief	Destructor */
+	virtual ~ParallelRadixSort();
+
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	void sort(uint64_t* keys, size_t count) override;
+
+	/**	@brief	Sets a parallel radix tuning option
+	 *	Recognized options:
+	 *		digit-bits	Width of each digit in bits (8, 11 or 16)
+	 *		threads			Number of threads, 0 for the default
+	 *		scratch-retain, huge-pages	See ScratchArena::setOption()
+	 *		pair-layout	Key/payload layout for sortPairs() and argsort(): split or packed
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized, otherwise false
+	 *	@throws	std::invalid_argument	On an invalid value for a recognized option
+	 */
+	bool setOption(const std::string& name, const std::string& value) override;
+
+	/**	@brief	Stable LSD radix sort of keys, moving a payload array with them
+	 *	@param	keys		Keys to sort
+	 *	@param	values	Payloads, one per key
+	 *	@param	count		Number of keys
+	 */
+	void sortPairs(uint64_t* keys, uint64_t* values, size_t count) override;
+
+	/**	@brief	Stable LSD radix sort of packed key/value records by key
+	 *	@param	records	Records to sort
+	 *	@param	count		Number of records
+	 */
+	void sortRecords(KeyValue* records, size_t count) override;
+
+	/**	@brief	Stable LSD radix argsort with 32-bit indices
+	 *	@param	keys		Keys to order
+	 *	@param	count		Number of keys, at most UINT32_MAX
+	 *	@param	indices	Receives count indices
+	 *	@throws	std::invalid_argument	If count does not fit in 32 bits
+	 */
+	void argsort(const uint64_t* keys, size_t count, uint32_t* indices) override;
+
+	/**	@brief	Stable LSD radix argsort with 64-bit indices
+	 *	@param	keys		Keys to order
+	 *	@param	count		Number of keys
+	 *	@param	indices	Receives count indices
+	 */
+	void argsort(const uint64_t* keys, size_t count, uint64_t* indices) override;
+
+private:
+	/**	@brief	Sorts using a caller-provided scratch buffer
+	 *	@param	data		Keys to sort
+	 *	@param	scratch	Scratch buffer of at least length elements
+	 *	@param	length	Number of keys
+	 *	@return	Pointer to the sorted keys; either data or scratch
+	 */
+	uint64_t* sortWithScratch(uint64_t* data, uint64_t* scratch, size_t length);
+
+	/**	@brief	Sorts using a fixed number of threads
+	 *	@param	data		Keys to sort
+	 *	@param	scratch	Scratch buffer of at least length elements
+	 *	@param	length	Number of keys
+	 *	@param	threads	Number of threads to use
+	 *	@return	Pointer to the sorted keys; either data or scratch
+	 */
+	uint64_t* parallelSort(uint64_t* data, uint64_t* scratch, size_t length,
+		unsigned threads);
+};
+
+ParallelRadixSort __parradixsort_instance;
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,394 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+//Project includes
+#include "quantiles.h"
+#include "select.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+//Keys read from a file at a time
+static const size_t BlockKeys = 1 << 20;
+
+//Below this many keys per thread a block is processed on one thread
+static const uint64_t MinKeysPerThread = 1 << 16;
+
+/**	@brief	Number of threads worth using on a block of count keys
+ *	@param	count		Number of keys
+ *	@param	threads	Most threads to use, 0 for the default
+ */
+static unsigned threadsFor(size_t count, unsigned threads) {
+	uint64_t limit = (threads > 0) ? threads : defaultThreads();
+	return (unsigned) std::max<uint64_t>(1, std::min<uint64_t>(limit, count / MinKeysPerThread));
+}
+
+/**	@brief	Parses a number that must make up the whole text
+ *	@param	text	The text
+ *	@param	entry	The list entry, for diagnostics
+ *	@throws	std::invalid_argument	If the text is not a number
+ */
+static double parseNumber(const std::string& text, const std::string& entry) {
+	size_t used = 0;
+	double value = 0;
+	try {
+		value = std::stod(text, &used);
+	}
+	catch(const std::exception&) {
+		used = 0;
+	}
+	if(used == 0 || used != text.size())
+		throw std::invalid_argument("Invalid quantile '" + entry + "'");
+	return value;
+}
+
+/**	@brief	Parses a comma-separated list of quantiles
+ *	@param	list	The list (ie: p50,p90,p99,p999)
+ *	@return	The quantiles, in the order given
+ *	@throws	std::invalid_argument	On a malformed entry
+ */
+std::vector<Quantile> parseQuantiles(const std::string& list) {
+	std::vector<Quantile> quantiles;
+	size_t begin = 0;
+	while(begin <= list.size()) {
+		size_t end = list.find(',', begin);
+		if(end == std::string::npos) end = list.size();
+		std::string entry = list.substr(begin, end - begin);
+		begin = end + 1;
+
+		double fraction = 0;
+		if(entry == "min") {
+			fraction = 0;
+		}
+		else if(entry == "median") {
+			fraction = 0.5;
+		}
+		else if(entry == "max") {
+			fraction = 1;
+		}
+		else if(!entry.empty() && (entry[0] == 'p' || entry[0] == 'P')) {
+			//Percentile; digits beyond the first two are decimals unless a point is given
+			std::string digits = entry.substr(1);
+			size_t point = digits.find('.');
+			if(point != std::string::npos) digits.erase(point, 1);
+			else point = (digits == "100") ? 3 : std::min<size_t>(digits.size(), 2);
+			if(digits.empty() || !std::all_of(digits.begin(), digits.end(),
+				[](char c) { return c >= '0' && c <= '9'; }))
+				throw std::invalid_argument("Invalid quantile '" + entry + "'");
+
+			//Shift the point two places as text, so p999 is exactly 0.999
+			if(point > 2)
+				fraction = parseNumber(digits.substr(0, point - 2) + "." + digits.substr(point - 2),
+					entry);
+			else
+				fraction = parseNumber("0." + std::string(2 - point, '0') + digits, entry);
+		}
+		else {
+			fraction = parseNumber(entry, entry);
+		}
+
+		if(!(fraction >= 0 && fraction <= 1))
+			throw std::invalid_argument("Quantile '" + entry + "' is not between 0 and 1");
+		quantiles.push_back({ entry, fraction });
+	}
+	return quantiles;
+}
+
+/**	@brief	Rank of a quantile by the nearest-rank method
+ *	@param	fraction	Fraction from 0 to 1
+ *	@param	count			Number of keys, at least 1
+ *	@return	The rank counting from 0: ceil(fraction * count) - 1, clamped
+ */
+uint64_t quantileRank(double fraction, uint64_t count) {
+	double rank = std::ceil(fraction * (double) count);
+	if(rank < 1) return 0;
+	if(rank >= (double) count) return count - 1;
+	return (uint64_t) rank - 1;
+}
+
+/**	@brief	Construct an empty sketch
+ *	@param	k			Accuracy parameter; larger is more accurate and larger
+ *	@param	seed	Seed for the choice of kept keys in each compaction
+ *	@throws	std::invalid_argument	If k is less than MinCapacity
+ */
+KllSketch::KllSketch(uint32_t k, uint64_t seed) :
+	k_(k),
+	count_(0),
+	min_(UINT64_MAX),
+	max_(0),
+	random_(seed * 0x9E3779B97F4A7C15ULL + 1) {
+	if(k < MinCapacity)
+		throw std::invalid_argument("Sketch accuracy must be at least " +
+			std::to_string(MinCapacity));
+	grow();
+}
+
+/**	@brief	Destructor */
+KllSketch::~KllSketch() {
+}
+
+/**	@brief	Adds a block of keys
+ *	@param	keys	The keys
+ *	@param	count	Number of keys
+ */
+void KllSketch::update(const uint64_t* keys, size_t count) {
+	for(size_t idx = 0; idx < count; idx++)
+		update(keys[idx]);
+}
+
+/**	@brief	Adds every key summarized by another sketch
+ *	@param	other	A sketch with the same k
+ */
+void KllSketch::merge(const KllSketch& other) {
+	while(levels_.size() < other.levels_.size()) grow();
+	for(size_t level = 0; level < other.levels_.size(); level++)
+		levels_[level].insert(levels_[level].end(), other.levels_[level].begin(),
+			other.levels_[level].end());
+	count_ += other.count_;
+	min_ = std::min(min_, other.min_);
+	max_ = std::max(max_, other.max_);
+	compress();
+}
+
+/**	@brief	Number of keys held by the sketch */
+size_t KllSketch::retained() const {
+	size_t total = 0;
+	for(const std::vector<uint64_t>& level : levels_) total += level.size();
+	return total;
+}
+
+/**	@brief	Estimates quantiles; min and max are exact
+ *	@param	fractions	Fractions from 0 to 1
+ *	@return	One key per fraction
+ *	@throws	std::runtime_error	If no keys have been added
+ */
+std::vector<uint64_t> KllSketch::quantiles(const std::vector<double>& fractions) const {
+	if(count_ == 0)
+		throw std::runtime_error("No keys to compute quantiles from");
+
+	//Every retained key with its weight, in key order
+	std::vector<std::pair<uint64_t, uint64_t>> weighted;
+	weighted.reserve(retained());
+	for(size_t level = 0; level < levels_.size(); level++) {
+		for(uint64_t key : levels_[level]) weighted.emplace_back(key, 1ULL << level);
+	}
+	std::sort(weighted.begin(), weighted.end());
+	std::vector<uint64_t> cumulative(weighted.size());
+	uint64_t total = 0;
+	for(size_t idx = 0; idx < weighted.size(); idx++)
+		cumulative[idx] = total += weighted[idx].second;
+
+	std::vector<uint64_t> values;
+	for(double fraction : fractions) {
+		if(fraction <= 0) {
+			values.push_back(min_);
+		}
+		else if(fraction >= 1) {
+			values.push_back(max_);
+		}
+		else {
+			uint64_t rank = quantileRank(fraction, total);
+			size_t idx = std::upper_bound(cumulative.begin(), cumulative.end(), rank) -
+				cumulative.begin();
+			values.push_back(weighted[std::min(idx, weighted.size() - 1)].first);
+		}
+	}
+	return values;
+}
+
+/**	@brief	Compacts every level that has reached its capacity */
+void KllSketch::compress() {
+	for(size_t level = 0; level < levels_.size(); level++) {
+		if(levels_[level].size() >= capacity_[level]) compact(level);
+	}
+}
+
+/**	@brief	Sorts a level and promotes every other key to the level above
+ *	@param	level	The level to compact
+ */
+void KllSketch::compact(size_t level) {
+	if(level + 1 == levels_.size()) grow();
+	std::vector<uint64_t>& keys = levels_[level];
+	std::vector<uint64_t>& above = levels_[level + 1];
+	std::sort(keys.begin(), keys.end());
+
+	//An odd key out stays behind; of each remaining pair, one is promoted at random
+	random_ ^= random_ << 13;
+	random_ ^= random_ >> 7;
+	random_ ^= random_ << 17;
+	const size_t odd = keys.size() & 1;
+	for(size_t idx = odd + (random_ & 1); idx < keys.size(); idx += 2)
+		above.push_back(keys[idx]);
+	keys.resize(odd);
+}
+
+/**	@brief	Adds a level at the top and recomputes the capacities */
+void KllSketch::grow() {
+	levels_.emplace_back();
+	capacity_.resize(levels_.size());
+	double capacity = k_;
+	for(size_t level = levels_.size(); level-- > 0; ) {
+		capacity_[level] = std::max<size_t>(MinCapacity, (size_t) std::ceil(capacity));
+		capacity *= 2.0 / 3.0;
+	}
+	levels_[0].reserve(capacity_[0]);
+}
+
+/**	@brief	Exact quantiles of keys in memory, without sorting them
+ *	@param	keys			The keys, at least one
+ *	@param	count			Number of keys
+ *	@param	fractions	Fractions from 0 to 1
+ *	@param	threads		Most threads to use, 0 for the default
+ *	@return	One key per fraction
+ *	@throws	std::runtime_error	If there are no keys
+ */
+std::vector<uint64_t> exactQuantiles(const uint64_t* keys, size_t count,
+	const std::vector<double>& fractions, unsigned threads) {
+	if(count == 0)
+		throw std::runtime_error("No keys to compute quantiles from");
+
+	std::vector<uint64_t> ranks;
+	for(double fraction : fractions) ranks.push_back(quantileRank(fraction, count));
+	return selectRanks(keys, count, ranks, threads);
+}
+
+/**	@brief	Exact quantiles of a file too large for memory
+ *	@param	path					The data file
+ *	@param	format				Format of the data file
+ *	@param	fractions			Fractions from 0 to 1
+ *	@param	memoryBudget	Bytes that may be used for candidates
+ *	@param	threads				Most threads to use, 0 for the default
+ *	@return	The quantiles, with the count and passes made
+ *	@throws	std::runtime_error	If the file cannot be read or holds no keys
+ */
+QuantileResult exactQuantiles(const std::string& path, KeyFormat format,
+	const std::vector<double>& fractions, uint64_t memoryBudget, unsigned threads) {
+	QuantileResult result = { 0, std::vector<uint64_t>(), 0, 0, std::vector<ParseError>() };
+	std::vector<uint64_t> block(BlockKeys);
+	size_t length;
+
+	//First pass: the count, which fixes the ranks, and the key range
+	uint64_t minKey = UINT64_MAX;
+	uint64_t maxKey = 0;
+	{
+		KeyReader reader(path, format);
+		while((length = reader.read(block.data(), BlockKeys)) > 0) {
+			uint64_t low, high;
+			keyRange(block.data(), length, low, high, threads);
+			minKey = std::min(minKey, low);
+			maxKey = std::max(maxKey, high);
+			result.count += length;
+		}
+		result.badLines = reader.badLines();
+		result.errors = reader.errors();
+		result.passes++;
+	}
+	if(result.count == 0)
+		throw std::runtime_error("No keys in '" + path + "' to compute quantiles from");
+
+	std::vector<uint64_t> ranks;
+	for(double fraction : fractions) ranks.push_back(quantileRank(fraction, result.count));
+	RadixSelect select(ranks, minKey, maxKey);
+	const uint64_t candidateLimit = memoryBudget / 2 / sizeof(uint64_t);
+	const std::string changed = "'" + path + "' changed while it was being read";
+
+	while(!select.done()) {
+		//Count the next digit of every candidate, each block split across threads
+		std::vector<RadixSelect::Histogram_t> counts(threadsFor(BlockKeys, threads),
+			select.histogram());
+		uint64_t read = 0;
+		KeyReader reader(path, format);
+		while((length = reader.read(block.data(), BlockKeys)) > 0) {
+			select.countParallel(block.data(), length, counts);
+			read += length;
+		}
+		result.passes++;
+		if(read != result.count) throw std::runtime_error(changed);
+
+		RadixSelect::Histogram_t total = counts[0];
+		for(size_t tid = 1; tid < counts.size(); tid++) {
+			for(size_t idx = 0; idx < total.size(); idx++) total[idx] += counts[tid][idx];
+		}
+		select.finishPass(total);
+		if(select.done()) break;
+
+		//Few enough candidates to hold? Gather them and finish in memory
+		uint64_t remaining = select.candidates(total);
+		if(remaining > candidateLimit) continue;
+
+		std::vector<uint64_t> candidates(remaining);
+		std::vector<uint64_t> matched(BlockKeys);
+		size_t gathered = 0;
+		KeyReader gatherer(path, format);
+		while((length = gatherer.read(block.data(), BlockKeys)) > 0) {
+			size_t found = select.gather(block.data(), length, matched.data());
+			if(gathered + found > remaining) throw std::runtime_error(changed);
+			std::copy(matched.begin(), matched.begin() + found, candidates.begin() + gathered);
+			gathered += found;
+		}
+		result.passes++;
+		if(gathered != remaining) throw std::runtime_error(changed);
+		select.resolve(candidates.data(), gathered, threads);
+	}
+
+	result.values = select.values();
+	return result;
+}
+
+/**	@brief	Approximate quantiles of a file in one streaming pass
+ *	@param	path			The data file
+ *	@param	format		Format of the data file
+ *	@param	fractions	Fractions from 0 to 1
+ *	@param	k					Sketch accuracy parameter
+ *	@param	threads		Most threads to use, 0 for the default
+ *	@return	The estimated quantiles, with the count
+ *	@throws	std::runtime_error	If the file cannot be read or holds no keys
+ */
+QuantileResult approxQuantiles(const std::string& path, KeyFormat format,
+	const std::vector<double>& fractions, uint32_t k, unsigned threads) {
+	QuantileResult result = { 0, std::vector<uint64_t>(), 1, 0, std::vector<ParseError>() };
+	const unsigned parts = threadsFor(BlockKeys, threads);
+	std::vector<KllSketch> sketches;
+	for(unsigned tid = 0; tid < parts; tid++) sketches.emplace_back(k, tid + 1);
+
+	std::vector<uint64_t> block(BlockKeys);
+	size_t length;
+	KeyReader reader(path, format);
+	while((length = reader.read(block.data(), BlockKeys)) > 0) {
+		parallelFor(parts, [&](unsigned tid) {
+			size_t begin = length * tid / parts;
+			sketches[tid].update(block.data() + begin, length * (tid + 1) / parts - begin);
+		});
+		result.count += length;
+	}
+	result.badLines = reader.badLines();
+	result.errors = reader.errors();
+	if(result.count == 0)
+		throw std::runtime_error("No keys in '" + path + "' to compute quantiles from");
+
+	for(unsigned tid = 1; tid < parts; tid++) sketches[0].merge(sketches[tid]);
+	result.values = sketches[0].quantiles(fractions);
+	return result;
+}
+
+}; //End namespace
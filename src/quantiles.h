@@ -0,0 +1,197 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _QUANTILES_INCLUDED
+#define _QUANTILES_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+//Project includes
+#include "keystream.h"
+
+namespace JAC::Integer {
+
+/**	@brief	A requested quantile */
+struct Quantile {
+	std::string	label;				/*! The request as given (ie: p99) */
+	double			fraction;			/*! Fraction of the keys at or below it, 0 to 1 */
+};
+
+/**	@brief	Quantiles computed from a data file */
+struct QuantileResult {
+	uint64_t								count;			/*! Keys read */
+	std::vector<uint64_t>		values;			/*! One key per requested fraction */
+	unsigned								passes;			/*! Passes made over the file */
+	uint64_t								badLines;		/*! Malformed text lines skipped */
+	std::vector<ParseError>	errors;			/*! The first malformed text lines */
+};
+
+/**	@brief	Parses a comma-separated list of quantiles
+ *	Each entry is a percentile in p-notation, where digits after the first
+ *	two are decimals (p50, p90, p99, p999 = 99.9%, p99.99), a fraction from
+ *	0 to 1 (0.25), or one of min, median and max.
+ *	@param	list	The list (ie: p50,p90,p99,p999)
+ *	@return	The quantiles, in the order given
+ *	@throws	std::invalid_argument	On a malformed entry
+ */
+std::vector<Quantile> parseQuantiles(const std::string& list);
+
+/**	@brief	Rank of a quantile by the nearest-rank method
+ *	@param	fraction	Fraction from 0 to 1
+ *	@param	count			Number of keys, at least 1
+ *	@return	The rank counting from 0: ceil(fraction * count) - 1, clamped
+ */
+uint64_t quantileRank(double fraction, uint64_t count);
+
+/**	@brief	Mergeable streaming quantile sketch (KLL)
+ *	Keys enter a hierarchy of compactors: level h holds keys standing for
+ *	2^h input keys each, and a full level is sorted and every other key
+ *	(from a random offset) promoted to the level above. Capacities shrink by
+ *	2/3 per level below the top, so memory stays about 3k keys however many
+ *	are added, and the rank error is roughly 1.7/k of the count with high
+ *	probability. Sketches built over separate parts of the data merge into
+ *	the sketch of the whole, so threads each keep their own.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class KllSketch {
+public:
+	//Default accuracy parameter, about 1% rank error
+	static constexpr uint32_t DefaultK = 200;
+
+	//Smallest capacity of any level
+	static constexpr uint32_t MinCapacity = 8;
+
+public:
+	/**	@brief	Construct an empty sketch
+	 *	@param	k			Accuracy parameter; larger is more accurate and larger
+	 *	@param	seed	Seed for the choice of kept keys in each compaction
+	 *	@throws	std::invalid_argument	If k is less than MinCapacity
+	 */
+	explicit KllSketch(uint32_t k = DefaultK, uint64_t seed = 1);
+
+	/**	@brief	Destructor */
+	virtual ~KllSketch();
+
+	/**	@brief	Adds a key
+	 *	@param	key	The key
+	 */
+	inline void update(uint64_t key) {
+		if(key < min_) min_ = key;
+		if(key > max_) max_ = key;
+		count_++;
+		levels_[0].push_back(key);
+		if(levels_[0].size() >= capacity_[0]) compress();
+	}
+
+	/**	@brief	Adds a block of keys
+	 *	@param	keys	The keys
+	 *	@param	count	Number of keys
+	 */
+	void update(const uint64_t* keys, size_t count);
+
+	/**	@brief	Adds every key summarized by another sketch
+	 *	@param	other	A sketch with the same k
+	 */
+	void merge(const KllSketch& other);
+
+	/**	@brief	Number of keys added */
+	inline uint64_t count() const { return count_; }
+
+	/**	@brief	Number of keys held by the sketch */
+	size_t retained() const;
+
+	/**	@brief	Estimates quantiles; min and max are exact
+	 *	@param	fractions	Fractions from 0 to 1
+	 *	@return	One key per fraction
+	 *	@throws	std::runtime_error	If no keys have been added
+	 */
+	std::vector<uint64_t> quantiles(const std::vector<double>& fractions) const;
+
+private:
+	/**	@brief	Compacts every level that has reached its capacity */
+	void compress();
+
+	/**	@brief	Sorts a level and promotes every other key to the level above
+	 *	@param	level	The level to compact
+	 */
+	void compact(size_t level);
+
+	/**	@brief	Adds a level at the top and recomputes the capacities */
+	void grow();
+
+private:
+	std::vector<std::vector<uint64_t>>	levels_;		/*! Keys at each level */
+	std::vector<size_t>									capacity_;	/*! Capacity of each level */
+	uint32_t														k_;					/*! Accuracy parameter */
+	uint64_t														count_;			/*! Keys added */
+	uint64_t														min_;				/*! Smallest key added */
+	uint64_t														max_;				/*! Largest key added */
+	uint64_t														random_;		/*! Xorshift state for compactions */
+};
+
+/**	@brief	Exact quantiles of keys in memory, without sorting them
+ *	@param	keys			The keys, at least one
+ *	@param	count			Number of keys
+ *	@param	fractions	Fractions from 0 to 1
+ *	@param	threads		Most threads to use, 0 for the default
+ *	@return	One key per fraction
+ *	@throws	std::runtime_error	If there are no keys
+ */
+std::vector<uint64_t> exactQuantiles(const uint64_t* keys, size_t count,
+	const std::vector<double>& fractions, unsigned threads = 0);
+
+/**	@brief	Exact quantiles of a file too large for memory
+ *	The file is streamed once for its count and key range, then once per
+ *	radix-select digit (see RadixSelect), counting each block in parallel.
+ *	As soon as the remaining candidates fit in half the memory budget they
+ *	are gathered in one more pass and resolved in memory, so uniform 64-bit
+ *	keys take three passes.
+ *	@param	path					The data file
+ *	@param	format				Format of the data file
+ *	@param	fractions			Fractions from 0 to 1
+ *	@param	memoryBudget	Bytes that may be used for candidates
+ *	@param	threads				Most threads to use, 0 for the default
+ *	@return	The quantiles, with the count and passes made
+ *	@throws	std::runtime_error	If the file cannot be read or holds no keys
+ */
+QuantileResult exactQuantiles(const std::string& path, KeyFormat format,
+	const std::vector<double>& fractions, uint64_t memoryBudget, unsigned threads = 0);
+
+/**	@brief	Approximate quantiles of a file in one streaming pass
+ *	Each thread sketches its share of every block with a KllSketch, and the
+ *	sketches are merged at the end, so memory is bounded by k and the thread
+ *	count rather than by the file.
+ *	@param	path			The data file
+ *	@param	format		Format of the data file
+ *	@param	fractions	Fractions from 0 to 1
+ *	@param	k					Sketch accuracy parameter
+ *	@param	threads		Most threads to use, 0 for the default
+ *	@return	The estimated quantiles, with the count
+ *	@throws	std::runtime_error	If the file cannot be read or holds no keys
+ */
+QuantileResult approxQuantiles(const std::string& path, KeyFormat format,
+	const std::vector<double>& fractions, uint32_t k = KllSketch::DefaultK,
+	unsigned threads = 0);
+
+}; //End namespace
+
+#endif //Include once
@@ -17,11 +17,13 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 //System includes
-#include <math.h>
 //Library includes
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 //Project includes
 #include "radix.h"
+#include "unique.h"
 
 /**	@brief	Create instance of the radix sort class from shared object
  *	@return	A new instance of RadixSort as Sorter*
@@ -39,76 +41,180 @@ extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
 	obj = nullptr;
 }
 
+/**	@brief	Describes the radix sort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		true,	//Stable
+		false,	//In place
+		false,	//Parallel
+		8.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth32 | JAC::Integer::KeyWidth64,	//Key widths
+		1 << 10,	//Min keys
+		0,	//Max keys
+		"LSD radix sort with 8, 11 or 16-bit digits"
+	};
+	return &caps;
+}
+
 namespace JAC::Integer {
 
 /**	@brief	Default constructor */
 RadixSort::RadixSort() {
-	count_.resize(10);
+	count_.resize(engine_.histogramSize());
+}
+
+/**	@brief	Construct for the specified digit width
+ *	@param	digitBits	Width of each digit in bits (8, 11 or 16)
+ *	@throws	std::invalid_argument	On an unsupported digit width
+ */
+RadixSort::RadixSort(uint8_t digitBits) : engine_(digitBits), engine32_(digitBits) {
+	count_.resize(engine_.histogramSize());
 }
 
 /**	@brief	Destructor */
 RadixSort::~RadixSort() {
 }
 
-/** @brief	Implementation-specific sort method for arrays of unsigned LL
- *	@param	arr	A std::vector<uint64_t> of values to be sorted
- *	@return	A std::vector<uint64_t> containing the values from arr in sorted order
- */
-SortAlgorithm::IntVector_t RadixSort::sort(SortAlgorithm::IntVector_t& arr) {
-	//Method-local data declaration
-	uint16_t radix = 1;
-	IntVectorRIterator_t ritr;
-	uint64_t idx;
-	uint64_t maxval = 0;
-
-	//Declare an output vector that matches the array argument
-	SortAlgorithm::IntVector_t sorted(arr.size());
-
-	//Pointers to source and destination arrays
-	SortAlgorithm::IntVector_t* pinput = &arr;
-	SortAlgorithm::IntVector_t* poutput = &sorted;
-
-	//Loop for radix
-	for(uint32_t div = 1; div < pow(10, radix); div *= 10) {
-		//Set all counters to 0 and fill counters for input array
-		count_.assign(10, 0);
-
-		//For each value in the input array
-		for(int arrayidx = 0; arrayidx < arr.size(); arrayidx++) {
-			uint64_t val = (*pinput)[arrayidx];
-
-			//Count digits on first pass through data
-			if(div == 1 && val > maxval)
-				radix = ((maxval = val) > 0) ? (int) log10 ((double) maxval) + 1 : 1;
-
-			uint8_t countidx = (val/div)%10;
-			count_[countidx]++;
-		}
-
-		//Fix up count array
-		for(uint8_t countidx = 1; countidx < 10; countidx++) {
-			count_[countidx] += count_[countidx - 1];
-		}
-
-		//Move elements to output array
-		idx = pinput->size()-1;
-		for(ritr = pinput->rbegin(); ritr != pinput->rend(); ritr++) {
-			uint8_t countidx = ((*pinput)[idx]/div)%10;
-			(*poutput)[count_[countidx] - 1] = (*pinput)[idx];
-			count_[countidx]--; //Decrement output array index
-			idx--; //Decrement source index
-		}
-
-		//Swap input/output
-		SortAlgorithm::IntVector_t* temp = poutput;
-		poutput = pinput;
-		pinput = temp;
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void RadixSort::sort(uint64_t* keys, size_t count) {
+	radixSort(engine_, keys, count);
+}
+
+/** @brief	In-place sort of unsigned 32-bit keys, in half the passes
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void RadixSort::sort(uint32_t* keys, size_t count) {
+	radixSort(engine32_, keys, count);
+}
+
+/**	@brief	LSD sort of keys of either width through the scratch arena
+ *	@param	engine	Engine for the key width
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+template<typename Key, typename Engine>
+void RadixSort::radixSort(const Engine& engine, Key* keys, size_t count) {
+	//Nothing to do for empty or single-value arrays
+	if(count < 2)
+		return;
+
+	//Histogram every digit in one read, then scatter the non-trivial digits
+	count_.resize(engine.histogramSize());
+	Key* scratch = scratch_.reserve<Key>(count);
+	Key* result = engine.sort(keys, scratch, count, count_.data());
+
+	//Odd number of passes leaves the sorted data in the scratch buffer
+	if(result != keys)
+		std::memcpy(keys, result, count * sizeof(Key));
+	scratch_.trim();
+}
+
+/**	@brief	Sets a radix tuning option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True if the option is recognized, otherwise false
+ *	@throws	std::invalid_argument	On an invalid value for a recognized option
+ */
+bool RadixSort::setOption(const std::string& name, const std::string& value) {
+	if(scratch_.setOption(name, value))
+		return true;
+	if(name == "pair-layout") {
+		layout_ = parsePairLayout(value);
+		return true;
+	}
+	if(name != "digit-bits")
+		return false;
+
+	unsigned long bits = 0;
+	try {
+		bits = std::stoul(value);
+	}
+	catch(const std::exception&) {
+		throw std::invalid_argument("Invalid value for digit-bits: " + value);
 	}
+	setDigitBits((uint8_t) std::min(bits, 255UL));
+	return true;
+}
+
+/**	@brief	Changes the digit width used by subsequent sorts
+ *	@param	digitBits	Width of each digit in bits (8, 11 or 16)
+ *	@throws	std::invalid_argument	On an unsupported digit width
+ */
+void RadixSort::setDigitBits(uint8_t digitBits) {
+	engine_.setDigitBits(digitBits);
+	engine32_.setDigitBits(digitBits);
+	count_.resize(engine_.histogramSize());
+}
+
+/**	@brief	Stable LSD radix sort of keys, moving a payload array with them
+ *	@param	keys		Keys to sort
+ *	@param	values	Payloads, one per key
+ *	@param	count		Number of keys
+ */
+void RadixSort::sortPairs(uint64_t* keys, uint64_t* values, size_t count) {
+	radixSortPairs(engine_, scratch_, keys, values, count, layout_);
+	scratch_.trim();
+}
 
-	if(pinput != &arr)
-		arr = std::move(*pinput);
+/**	@brief	Stable LSD radix sort of packed key/value records by key
+ *	@param	records	Records to sort
+ *	@param	count		Number of records
+ */
+void RadixSort::sortRecords(KeyValue* records, size_t count) {
+	radixSortRecords(engine_, scratch_, records, count);
+	scratch_.trim();
+}
 
-	return arr;
+/**	@brief	Stable LSD radix argsort with 32-bit indices
+ *	@param	keys		Keys to order
+ *	@param	count		Number of keys, at most UINT32_MAX
+ *	@param	indices	Receives count indices
+ *	@throws	std::invalid_argument	If count does not fit in 32 bits
+ */
+void RadixSort::argsort(const uint64_t* keys, size_t count, uint32_t* indices) {
+	radixArgsort(engine_, scratch_, keys, count, indices);
+	scratch_.trim();
+}
+
+/**	@brief	Stable LSD radix argsort with 64-bit indices
+ *	@param	keys		Keys to order
+ *	@param	count		Number of keys
+ *	@param	indices	Receives count indices
+ */
+void RadixSort::argsort(const uint64_t* keys, size_t count, uint64_t* indices) {
+	radixArgsort(engine_, scratch_, keys, count, indices, layout_);
+	scratch_.trim();
+}
+
+/**	@brief	LSD radix sort that drops duplicates during the last scatter
+ *	@param	keys		Keys to sort; the distinct keys are left at the front
+ *	@param	count		Number of keys
+ *	@return	The number of distinct keys
+ */
+size_t RadixSort::sortUnique(uint64_t* keys, size_t count) {
+	size_t distinct = radixSortUnique(engine_, scratch_, keys, count, nullptr);
+	scratch_.trim();
+	return distinct;
+}
+
+/**	@brief	LSD radix sort that counts duplicates during the last scatter
+ *	@param	keys		Keys to sort; the distinct keys are left at the front
+ *	@param	count		Number of keys
+ *	@param	counts	Receives the occurrences of each distinct key; at least
+ *									count elements
+ *	@return	The number of distinct keys
+ */
+size_t RadixSort::sortCounted(uint64_t* keys, size_t count, uint64_t* counts) {
+	size_t distinct = radixSortUnique(engine_, scratch_, keys, count, counts);
+	scratch_.trim();
+	return distinct;
 }
 
 }; //End namespace
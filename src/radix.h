@@ -25,6 +25,9 @@
 #include <vector>
 //Project includes
 #include "sortalgorithm.h"
+#include "pairsort.h"
+#include "radixengine.h"
+#include "scratch.h"
 
 namespace JAC::Integer {
 
@@ -33,8 +36,8 @@ namespace JAC::Integer {
  */
 class RadixSort : public SortAlgorithm {
 private:
-	//Container of radix counters
-	typedef std::vector<uint32_t>		RadixCount_t;
+	//Container of radix counters, one block of buckets per digit
+	typedef std::vector<uint64_t>		RadixCount_t;
 
 	//Iterator for radix count vector
 	typedef RadixCount_t::iterator	RadixCountIterator_t;
@@ -43,21 +46,118 @@ private:
 	//The sort type string
 	std::string 			type_ = "radix";
 
+	//Digit layout and pass primitives
+	RadixEngine				engine_;
+
+	//The same digit layout for 32-bit keys
+	RadixEngine32			engine32_;
+
 	//Radix count vector
 	RadixCount_t			count_;
 
+	//Scratch buffer reused across sorts
+	ScratchArena			scratch_;
+
+	//Key/payload layout used by sortPairs() and argsort()
+	PairLayout				layout_ = PairLayout::Split;
+
 public:
 	/**	@brief	Default constructor */
 	RadixSort();
 
+	/**	@brief	Construct for the specified digit width
+	 *	@param	digitBits	Width of each digit in bits (8, 11 or 16)
+	 *	@throws	std::invalid_argument	On an unsupported digit width
+	 */
+	explicit RadixSort(uint8_t digitBits);
+
 	/**	@brief	Destructor */
 	virtual ~RadixSort();
 
-	/** @brief	Implementation-specific sort method for arrays of unsigned LL
-	 *	@param	arr	A std::vector<uint64_t> of values to be sorted
-	 *	@return	A std::vector<uint64_t> containing the values from arr in sorted order
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	void sort(uint64_t* keys, size_t count) override;
+
+	/** @brief	In-place sort of unsigned 32-bit keys, in half the passes
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	void sort(uint32_t* keys, size_t count) override;
+
+	/**	@brief	Sets a radix tuning option
+	 *	Recognized options:
+	 *		digit-bits	Width of each digit in bits (8, 11 or 16)
+	 *		scratch-retain, huge-pages	See ScratchArena::setOption()
+	 *		pair-layout	Key/payload layout for sortPairs() and argsort(): split or packed
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized, otherwise false
+	 *	@throws	std::invalid_argument	On an invalid value for a recognized option
+	 */
+	bool setOption(const std::string& name, const std::string& value) override;
+
+	/**	@brief	Stable LSD radix sort of keys, moving a payload array with them
+	 *	@param	keys		Keys to sort
+	 *	@param	values	Payloads, one per key
+	 *	@param	count		Number of keys
+	 */
+	void sortPairs(uint64_t* keys, uint64_t* values, size_t count) override;
+
+	/**	@brief	Stable LSD radix sort of packed key/value records by key
+	 *	@param	records	Records to sort
+	 *	@param	count		Number of records
+	 */
+	void sortRecords(KeyValue* records, size_t count) override;
+
+	/**	@brief	Stable LSD radix argsort with 32-bit indices
+	 *	@param	keys		Keys to order
+	 *	@param	count		Number of keys, at most UINT32_MAX
+	 *	@param	indices	Receives count indices
+	 *	@throws	std::invalid_argument	If count does not fit in 32 bits
+	 */
+	void argsort(const uint64_t* keys, size_t count, uint32_t* indices) override;
+
+	/**	@brief	Stable LSD radix argsort with 64-bit indices
+	 *	@param	keys		Keys to order
+	 *	@param	count		Number of keys
+	 *	@param	indices	Receives count indices
+	 */
+	void argsort(const uint64_t* keys, size_t count, uint64_t* indices) override;
+
+	/**	@brief	LSD radix sort that drops duplicates during the last scatter
+	 *	@param	keys		Keys to sort; the distinct keys are left at the front
+	 *	@param	count		Number of keys
+	 *	@return	The number of distinct keys
+	 */
+	size_t sortUnique(uint64_t* keys, size_t count) override;
+
+	/**	@brief	LSD radix sort that counts duplicates during the last scatter
+	 *	@param	keys		Keys to sort; the distinct keys are left at the front
+	 *	@param	count		Number of keys
+	 *	@param	counts	Receives the occurrences of each distinct key; at least
+	 *									count elements
+	 *	@return	The number of distinct keys
+	 */
+	size_t sortCounted(uint64_t* keys, size_t count, uint64_t* counts) override;
+
+	/**	@brief	Changes the digit width used by subsequent sorts
+	 *	@param	digitBits	Width of each digit in bits (8, 11 or 16)
+	 *	@throws	std::invalid_argument	On an unsupported digit width
+	 */
+	void setDigitBits(uint8_t digitBits);
+
+private:
+	/**	@brief	LSD sort of keys of either width through the scratch arena
+	 *	@param	engine	Engine for the key width
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
 	 */
-	IntVector_t sort(IntVector_t& arr) override;
+	template<typename Key, typename Engine>
+	void radixSort(const Engine& engine, Key* keys, size_t count);
 };
 
 RadixSort __radixsort_instance;
@@ -0,0 +1,388 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _RADIXENGINE_INCLUDED
+#define _RADIXENGINE_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace JAC::Integer {
+
+/**	@brief	Sort key of a bare key
+ *	The engine sorts any element type with a radixKey() overload found by
+ *	argument-dependent lookup, so records carrying a payload move as a unit.
+ */
+inline uint64_t radixKey(uint64_t key) { return key; }
+
+/**	@brief	Sort key of a bare 32-bit key */
+inline uint64_t radixKey(uint32_t key) { return key; }
+
+/**	@brief	Power-of-two radix digit layout and LSD pass primitives
+ *	Keys are split into digits of 8, 11 or 16 bits. Histograms for every digit
+ *	are built in a single read of the data and stored back to back, one block
+ *	of buckets() counters per pass, so a pass whose digit is identical for all
+ *	keys can be detected (and skipped) before any data is moved.
+ *	Elements are bare keys or records with a radixKey() overload; scatters
+ *	are stable, so records keep their input order among equal keys.
+ *	The key width is a template parameter, so the number of passes for a
+ *	digit width is a compile-time constant and 32-bit keys take half the
+ *	passes of 64-bit ones.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+template<uint8_t Bits>
+class BasicRadixEngine {
+public:
+	//Bits in the key type
+	static const uint8_t KeyBits = Bits;
+
+	//Default digit width
+	static const uint8_t DefaultDigitBits = 8;
+
+public:
+	/**	@brief	Construct for the specified digit width
+	 *	@param	digitBits	Width of each digit in bits (8, 11 or 16)
+	 *	@throws	std::invalid_argument	On an unsupported digit width
+	 */
+	explicit BasicRadixEngine(uint8_t digitBits = DefaultDigitBits) {
+		setDigitBits(digitBits);
+	}
+
+	/**	@brief	Changes the digit width used for subsequent passes
+	 *	@param	digitBits	Width of each digit in bits (8, 11 or 16)
+	 *	@throws	std::invalid_argument	On an unsupported digit width
+	 */
+	void setDigitBits(uint8_t digitBits) {
+		if(digitBits != 8 && digitBits != 11 && digitBits != 16)
+			throw std::invalid_argument("Unsupported radix digit width: "
+				+ std::to_string(digitBits) + " (expected 8, 11 or 16)");
+
+		digitBits_ = digitBits;
+		buckets_ = 1U << digitBits;
+		mask_ = buckets_ - 1;
+		passes_ = passesFor(digitBits);
+	}
+
+	/**	@brief	Number of digits (LSD passes) needed to cover a key
+	 *	@param	digitBits	Width of each digit in bits
+	 */
+	static constexpr uint8_t passesFor(uint8_t digitBits) {
+		return (KeyBits + digitBits - 1) / digitBits;
+	}
+
+	/**	@brief	Width of each digit in bits */
+	inline uint8_t digitBits() const { return digitBits_; }
+
+	/**	@brief	Number of buckets (counters) per digit */
+	inline uint32_t buckets() const { return buckets_; }
+
+	/**	@brief	Number of digits (LSD passes) needed to cover a key */
+	inline uint8_t passes() const { return passes_; }
+
+	/**	@brief	Number of counters needed to hold histograms for all passes */
+	inline size_t histogramSize() const { return (size_t) passes_ * buckets_; }
+
+	/**	@brief	Extracts a digit from a key
+	 *	@param	key		The key value
+	 *	@param	pass	The digit index, 0 being least significant
+	 *	@return	The digit value, in the range [0, buckets())
+	 */
+	inline uint32_t digit(uint64_t key, uint8_t pass) const {
+		return (uint32_t) ((key >> (pass * digitBits_)) & mask_);
+	}
+
+	/**	@brief	Accumulates the histograms of every digit in one read pass
+	 *	Counters are added to, not reset, so per-block histograms may be built
+	 *	into separate arrays and summed, or several blocks accumulated together.
+	 *	@param	data		Keys (or records) to count
+	 *	@param	length	Number of keys
+	 *	@param	counts	histogramSize() counters, one block of buckets() per pass
+	 */
+	template<typename Element>
+	void histogram(const Element* data, size_t length, uint64_t* counts) const {
+		for(size_t idx = 0; idx < length; idx++) {
+			uint64_t key = radixKey(data[idx]);
+			uint64_t* block = counts;
+			for(uint8_t pass = 0; pass < passes_; pass++, block += buckets_) {
+				block[key & mask_]++;
+				key >>= digitBits_;
+			}
+		}
+	}
+
+	/**	@brief	Determines whether a pass would leave the keys where they are
+	 *	@param	counts	Histogram block for the pass (buckets() counters)
+	 *	@param	length	Number of keys counted
+	 *	@return	True if every key has the same digit for this pass
+	 */
+	bool trivialPass(const uint64_t* counts, size_t length) const {
+		for(uint32_t bucket = 0; bucket < buckets_; bucket++) {
+			if(counts[bucket] != 0)
+				return counts[bucket] == length;
+		}
+		return true;
+	}
+
+	/**	@brief	Converts a histogram block to exclusive prefix offsets in place
+	 *	@param	counts	Histogram block for the pass (buckets() counters)
+	 */
+	void prefixOffsets(uint64_t* counts) const {
+		uint64_t sum = 0;
+		for(uint32_t bucket = 0; bucket < buckets_; bucket++) {
+			uint64_t count = counts[bucket];
+			counts[bucket] = sum;
+			sum += count;
+		}
+	}
+
+	/**	@brief	Stable scatter of keys by one digit
+	 *	@param	src			Source keys (or records)
+	 *	@param	dst			Destination buffer, at least length elements
+	 *	@param	length	Number of keys
+	 *	@param	pass		The digit index being scattered
+	 *	@param	offsets	Exclusive prefix offsets for the pass, advanced as keys
+	 *									are written
+	 */
+	template<typename Element>
+	void scatter(const Element* src, Element* dst, size_t length, uint8_t pass,
+		uint64_t* offsets) const {
+		const uint8_t shift = pass * digitBits_;
+		for(size_t idx = 0; idx < length; idx++) {
+			const Element& element = src[idx];
+			dst[offsets[(radixKey(element) >> shift) & mask_]++] = element;
+		}
+	}
+
+	/**	@brief	Stable scatter of keys and a parallel payload array by one digit
+	 *	@param	srcKeys			Source keys
+	 *	@param	srcValues		Source payloads, one per key
+	 *	@param	dstKeys			Destination for the keys, at least length elements
+	 *	@param	dstValues		Destination for the payloads, at least length elements
+	 *	@param	length			Number of keys
+	 *	@param	pass				The digit index being scattered
+	 *	@param	offsets			Exclusive prefix offsets for the pass, advanced as keys
+	 *											are written
+	 */
+	void scatterPairs(const uint64_t* srcKeys, const uint64_t* srcValues, uint64_t* dstKeys,
+		uint64_t* dstValues, size_t length, uint8_t pass, uint64_t* offsets) const {
+		const uint8_t shift = pass * digitBits_;
+		for(size_t idx = 0; idx < length; idx++) {
+			uint64_t key = srcKeys[idx];
+			uint64_t pos = offsets[(key >> shift) & mask_]++;
+			dstKeys[pos] = key;
+			dstValues[pos] = srcValues[idx];
+		}
+	}
+
+	/**	@brief	Stable scatter by one digit that keeps one copy of each key
+	 *	Only valid for the last pass of an LSD sort, where each bucket receives
+	 *	its keys in ascending order: a key equal to the last one written to its
+	 *	bucket is a duplicate, so it is counted rather than written. The gaps
+	 *	the duplicates leave at the end of each bucket are closed afterwards.
+	 *	@param	src						Source keys, sorted by every lower digit
+	 *	@param	dst						Destination buffer, at least length keys
+	 *	@param	multiplicity	Receives the count of each distinct key, at least length
+	 *												elements, or nullptr
+	 *	@param	length				Number of keys
+	 *	@param	pass					The digit index being scattered
+	 *	@param	offsets				Exclusive prefix offsets for the pass, overwritten
+	 *	@return	The number of distinct keys, now at the front of dst
+	 */
+	template<typename Key>
+	size_t scatterUnique(const Key* src, Key* dst, uint64_t* multiplicity, size_t length,
+		uint8_t pass, uint64_t* offsets) const {
+		const std::vector<uint64_t> starts(offsets, offsets + buckets_);
+		const uint8_t shift = pass * digitBits_;
+		if(multiplicity == nullptr) {
+			//Always store, but only advance past keys that differ from the last one
+			for(size_t idx = 0; idx < length; idx++) {
+				const Key key = src[idx];
+				const uint32_t bucket = (radixKey(key) >> shift) & mask_;
+				const uint64_t pos = offsets[bucket];
+				const bool duplicate = pos != starts[bucket] && dst[pos-1] == key;
+				dst[pos] = key;
+				offsets[bucket] = pos + !duplicate;
+			}
+		}
+		else {
+			for(size_t idx = 0; idx < length; idx++) {
+				const Key key = src[idx];
+				const uint32_t bucket = (radixKey(key) >> shift) & mask_;
+				const uint64_t pos = offsets[bucket];
+				if(pos != starts[bucket] && dst[pos-1] == key) {
+					multiplicity[pos-1]++;
+				}
+				else {
+					dst[pos] = key;
+					multiplicity[pos] = 1;
+					offsets[bucket] = pos + 1;
+				}
+			}
+		}
+
+		//Close up the buckets
+		size_t distinct = 0;
+		for(uint32_t bucket = 0; bucket < buckets_; bucket++) {
+			const size_t kept = offsets[bucket] - starts[bucket];
+			if(kept > 0 && starts[bucket] != distinct) {
+				std::memmove(dst + distinct, dst + starts[bucket], kept * sizeof(Key));
+				if(multiplicity != nullptr)
+					std::memmove(multiplicity + distinct, multiplicity + starts[bucket],
+						kept * sizeof(uint64_t));
+			}
+			distinct += kept;
+		}
+		return distinct;
+	}
+
+	/**	@brief	LSD sort of a buffer using a caller-provided scratch buffer
+	 *	@param	data		Keys (or records) to sort
+	 *	@param	scratch	Scratch buffer of at least length elements
+	 *	@param	length	Number of keys
+	 *	@param	counts	histogramSize() counters, overwritten
+	 *	@return	Pointer to the sorted keys; either data or scratch, depending on
+	 *					the number of passes that were not skipped
+	 */
+	template<typename Element>
+	Element* sort(Element* data, Element* scratch, size_t length,
+		uint64_t* counts) const {
+		//Build histograms for every digit in a single read
+		for(size_t idx = 0; idx < histogramSize(); idx++) counts[idx] = 0;
+		histogram(data, length, counts);
+
+		Element* src = data;
+		Element* dst = scratch;
+		for(uint8_t pass = 0; pass < passes_; pass++) {
+			uint64_t* block = counts + (size_t) pass * buckets_;
+
+			//Same digit for every key? The pass would be a straight copy
+			if(trivialPass(block, length)) continue;
+
+			prefixOffsets(block);
+			scatter(src, dst, length, pass, block);
+
+			//Swap input/output
+			Element* temp = dst;
+			dst = src;
+			src = temp;
+		}
+		return src;
+	}
+
+	/**	@brief	LSD sort that keeps one copy of each key, optionally counting them
+	 *	Duplicates are dropped during the scatter of the last digit that is not
+	 *	the same for every key (see scatterUnique()), so no separate pass over
+	 *	the sorted keys is needed.
+	 *	@param	data					Keys to sort
+	 *	@param	scratch				Scratch buffer of at least length keys
+	 *	@param	length				Number of keys
+	 *	@param	counts				histogramSize() counters, overwritten
+	 *	@param	multiplicity	Receives the count of each distinct key, at least length
+	 *												elements, or nullptr
+	 *	@param	distinct			Receives the number of distinct keys
+	 *	@return	Pointer to the distinct keys in ascending order; either data or scratch
+	 */
+	template<typename Key>
+	Key* sortUnique(Key* data, Key* scratch, size_t length, uint64_t* counts,
+		uint64_t* multiplicity, size_t& distinct) const {
+		for(size_t idx = 0; idx < histogramSize(); idx++) counts[idx] = 0;
+		histogram(data, length, counts);
+
+		//The last pass that moves any key is the one that collapses them
+		int last = -1;
+		for(uint8_t pass = 0; pass < passes_; pass++) {
+			if(!trivialPass(counts + (size_t) pass * buckets_, length)) last = pass;
+		}
+		if(last < 0) {
+			//No digit differs: every key is the same
+			distinct = (length > 0) ? 1 : 0;
+			if(multiplicity != nullptr && length > 0) multiplicity[0] = length;
+			return data;
+		}
+
+		Key* src = data;
+		Key* dst = scratch;
+		for(uint8_t pass = 0; pass < last; pass++) {
+			uint64_t* block = counts + (size_t) pass * buckets_;
+			if(trivialPass(block, length)) continue;
+
+			prefixOffsets(block);
+			scatter(src, dst, length, pass, block);
+
+			Key* temp = dst;
+			dst = src;
+			src = temp;
+		}
+
+		uint64_t* block = counts + (size_t) last * buckets_;
+		prefixOffsets(block);
+		distinct = scatterUnique(src, dst, multiplicity, length, (uint8_t) last, block);
+		return dst;
+	}
+
+	/**	@brief	LSD sort of keys and a parallel payload array
+	 *	The payloads end up in the same buffer (values or valueScratch) as the
+	 *	keys do in (keys or keyScratch).
+	 *	@param	keys					Keys to sort
+	 *	@param	values				Payloads, one per key
+	 *	@param	keyScratch		Scratch buffer of at least length keys
+	 *	@param	valueScratch	Scratch buffer of at least length payloads
+	 *	@param	length				Number of keys
+	 *	@param	counts				histogramSize() counters, overwritten
+	 *	@return	True if the sorted data is in keys/values, false if in the scratch buffers
+	 */
+	bool sortPairs(uint64_t* keys, uint64_t* values, uint64_t* keyScratch,
+		uint64_t* valueScratch, size_t length, uint64_t* counts) const {
+		for(size_t idx = 0; idx < histogramSize(); idx++) counts[idx] = 0;
+		histogram(keys, length, counts);
+
+		bool inPlace = true;
+		for(uint8_t pass = 0; pass < passes_; pass++) {
+			uint64_t* block = counts + (size_t) pass * buckets_;
+			if(trivialPass(block, length)) continue;
+
+			prefixOffsets(block);
+			if(inPlace)
+				scatterPairs(keys, values, keyScratch, valueScratch, length, pass, block);
+			else
+				scatterPairs(keyScratch, valueScratch, keys, values, length, pass, block);
+			inPlace = !inPlace;
+		}
+		return inPlace;
+	}
+
+private:
+	uint8_t		digitBits_;		/*! Width of each digit in bits */
+	uint32_t	buckets_;			/*! Number of buckets per digit */
+	uint64_t	mask_;				/*! Mask for a single digit */
+	uint8_t		passes_;			/*! Digits per key */
+};
+
+//Engines for 64-bit and 32-bit keys
+typedef BasicRadixEngine<64>	RadixEngine;
+typedef BasicRadixEngine<32>	RadixEngine32;
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,312 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+//Project includes
+#include "samplesort.h"
+#include "parallel.h"
+
+/**	@brief	Create instance of the sample sort class from shared object
+ *	@return	A new instance of SampleSort as Sorter*
+ */
+extern "C" JAC::Integer::SortAlgorithm* create() {
+	return new JAC::Integer::SampleSort();
+}
+
+/**	@brief	Deletes the specified instance of a SampleSort, allocated by this module
+ *	@param	val	Pointer to a SampleSort that was allocated by this module's
+ * 							CreateInstance() function
+ */
+extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
+	if(obj != nullptr) delete obj;
+	obj = nullptr;
+}
+
+/**	@brief	Describes the sample sort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		false,	//Stable
+		false,	//In place
+		true,	//Parallel
+		10.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth64,	//Key widths
+		1 << 20,	//Min keys
+		0,	//Max keys
+		"Parallel sample sort with bucket tasks on the shared pool"
+	};
+	return &caps;
+}
+
+namespace JAC::Integer {
+
+/**	@brief	Seconds since a start time */
+static inline double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**	@brief	Default constructor */
+SampleSort::SampleSort() {
+}
+
+/**	@brief	Destructor */
+SampleSort::~SampleSort() {
+}
+
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void SampleSort::sort(uint64_t* keys, size_t count) {
+	const size_t length = count;
+	auto start = std::chrono::steady_clock::now();
+	metrics_.clear();
+
+	//Limit threads so every block is worth the thread
+	size_t threads = (threads_ > 0) ? threads_ : defaultThreads();
+	threads = std::max<size_t>(1, std::min(threads, length / MinKeysPerThread));
+	if(threads < 2 || length <= SerialKeys) {
+		std::sort(keys, keys + length);
+		double seconds = secondsSince(start);
+		metrics_ = { { "threads", 1 }, { "work_s", seconds }, { "wall_s", seconds },
+			{ "parallelism", 1 } };
+		return;
+	}
+
+	SplitterTree tree;
+	chooseSplitters(keys, length, std::min(MaxSplitters, threads * BucketsPerThread - 1),
+		tree);
+	const size_t buckets = tree.buckets();
+
+	//Classify each block, remembering every key's bucket for the scatter
+	uint64_t* scratch = scratch_.reserve<uint64_t>(length);
+	uint16_t* oracle = oracle_.reserve<uint16_t>(length);
+	Count_t offsets(buckets * threads, 0);
+	std::vector<double> busy(threads, 0);
+	parallelFor((unsigned) threads, [&](unsigned tid) {
+		double began = threadCpuSeconds();
+		uint64_t* counts = offsets.data() + buckets * tid;
+		const size_t end = length * (tid+1) / threads;
+		for(size_t idx = length * tid / threads; idx < end; idx++) {
+			uint32_t bucket = tree.classify(keys[idx]);
+			oracle[idx] = (uint16_t) bucket;
+			counts[bucket]++;
+		}
+		busy[tid] += threadCpuSeconds() - began;
+	});
+
+	//Bucket b of thread t starts after all earlier buckets and after bucket b
+	//of earlier threads
+	Count_t starts(buckets + 1);
+	uint64_t run = 0;
+	for(size_t bucket = 0; bucket < buckets; bucket++) {
+		starts[bucket] = run;
+		for(size_t tid = 0; tid < threads; tid++) {
+			uint64_t count = offsets[buckets * tid + bucket];
+			offsets[buckets * tid + bucket] = run;
+			run += count;
+		}
+	}
+	starts[buckets] = run;
+
+	parallelFor((unsigned) threads, [&](unsigned tid) {
+		double began = threadCpuSeconds();
+		uint64_t* next = offsets.data() + buckets * tid;
+		const size_t end = length * (tid+1) / threads;
+		for(size_t idx = length * tid / threads; idx < end; idx++)
+			scratch[next[oracle[idx]]++] = keys[idx];
+		busy[tid] += threadCpuSeconds() - began;
+	});
+
+	//Largest buckets first: they are queued first and so taken first
+	std::vector<size_t> order(buckets);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+		return starts[lhs+1] - starts[lhs] > starts[rhs+1] - starts[rhs];
+	});
+
+	tasks_ = 0;
+	taskNanos_ = 0;
+	TaskGroup group(executor(), (unsigned) threads);
+	for(size_t bucket : order) {
+		const size_t begin = starts[bucket];
+		const size_t size = starts[bucket+1] - begin;
+		if(size == 0) continue;
+		uint64_t* source = scratch + begin;
+		uint64_t* spare = keys + begin;
+		if(SplitterTree::equalityBucket(bucket)) {
+			spawn(group, [=]() { std::memcpy(spare, source, size * sizeof(uint64_t)); });
+		}
+		else {
+			spawn(group, [=, &group]() { sortBucket(group, source, spare, size, 1, true); });
+		}
+	}
+	group.wait();
+
+	double work = std::accumulate(busy.begin(), busy.end(), 0.0) + taskNanos_.load() / 1e9;
+	double wall = secondsSince(start);
+	metrics_ = {
+		{ "threads", (double) threads },
+		{ "buckets", (double) buckets },
+		{ "tasks", (double) tasks_.load() },
+		{ "steals", (double) group.steals() },
+		{ "work_s", work },
+		{ "wall_s", wall },
+		{ "parallelism", (wall > 0) ? work / wall : 1 }
+	};
+	scratch_.trim();
+	oracle_.trim();
+}
+
+/**	@brief	Sets a sample sort tuning option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True if the option is recognized, otherwise false
+ *	@throws	std::invalid_argument	On an invalid value for a recognized option
+ */
+bool SampleSort::setOption(const std::string& name, const std::string& value) {
+	if(scratch_.setOption(name, value)) {
+		oracle_.setOption(name, value);
+		return true;
+	}
+	if(name != "threads" && name != "oversampling")
+		return false;
+
+	size_t used = 0;
+	unsigned long parsed = 0;
+	try {
+		parsed = std::stoul(value, &used);
+	}
+	catch(const std::exception&) {
+		used = 0;
+	}
+	if(used == 0 || used != value.size() || (name == "oversampling" && parsed == 0))
+		throw std::invalid_argument("Invalid value for " + name + ": " + value);
+
+	if(name == "threads")
+		threads_ = (unsigned) parsed;
+	else
+		oversampling_ = parsed;
+	return true;
+}
+
+/**	@brief	Chooses splitters from a random sample of keys
+ *	@param	keys			The keys
+ *	@param	length		Number of keys
+ *	@param	splitters	Most splitters wanted
+ *	@param	tree			Receives the splitters
+ */
+void SampleSort::chooseSplitters(const uint64_t* keys, size_t length, size_t splitters,
+	SplitterTree& tree) const {
+	//xorshift64, seeded from the length so results are repeatable
+	uint64_t state = length * 0x9E3779B97F4A7C15ULL + 1;
+	const size_t samples = std::min(length, (splitters + 1) * oversampling_);
+	std::vector<uint64_t> sample(samples);
+	for(uint64_t& key : sample) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		key = keys[state % length];
+	}
+	std::sort(sample.begin(), sample.end());
+
+	//Evenly spaced sample keys, without repeats
+	std::vector<uint64_t> chosen;
+	for(size_t idx = 1; idx <= splitters; idx++) {
+		uint64_t key = sample[idx * samples / (splitters + 1)];
+		if(chosen.empty() || key != chosen.back()) chosen.push_back(key);
+	}
+	tree.build(chosen);
+}
+
+/**	@brief	Adds a bucket task to the group, counting it and its CPU time
+ *	@param	group	The group of the sort
+ *	@param	task	The task
+ */
+void SampleSort::spawn(TaskGroup& group, std::function<void()> task) {
+	group.run([this, task = std::move(task)]() {
+		double began = threadCpuSeconds();
+		task();
+		taskNanos_ += (uint64_t) ((threadCpuSeconds() - began) * 1e9);
+		tasks_++;
+	});
+}
+
+/**	@brief	Sorts one bucket, as a task of the group
+ *	@param	group			The group of the sort, for sub-bucket tasks
+ *	@param	keys			The bucket's keys
+ *	@param	spare			Space for length keys
+ *	@param	length		Number of keys
+ *	@param	depth			Partitioning depth of this bucket
+ *	@param	toSpare		True to leave the sorted keys in spare rather than keys
+ */
+void SampleSort::sortBucket(TaskGroup& group, uint64_t* keys,
+	uint64_t* spare, size_t length, unsigned depth, bool toSpare) {
+	if(length <= SerialKeys || depth >= MaxDepth) {
+		std::sort(keys, keys + length);
+		if(toSpare) std::memcpy(spare, keys, length * sizeof(uint64_t));
+		return;
+	}
+
+	//Partition into spare, which then holds the sub-buckets
+	SplitterTree tree;
+	chooseSplitters(keys, length, RecursiveSplitters, tree);
+	const size_t buckets = tree.buckets();
+	std::vector<uint16_t> oracle(length);
+	Count_t starts(buckets + 1, 0);
+	for(size_t idx = 0; idx < length; idx++) {
+		uint32_t bucket = tree.classify(keys[idx]);
+		oracle[idx] = (uint16_t) bucket;
+		starts[bucket + 1]++;
+	}
+	for(size_t bucket = 0; bucket < buckets; bucket++)
+		starts[bucket + 1] += starts[bucket];
+	Count_t next(starts.begin(), starts.end() - 1);
+	for(size_t idx = 0; idx < length; idx++)
+		spare[next[oracle[idx]]++] = keys[idx];
+
+	//Each sub-bucket now lives in spare; it must end up where this bucket should
+	for(size_t bucket = 0; bucket < buckets; bucket++) {
+		const size_t begin = starts[bucket];
+		const size_t size = starts[bucket+1] - begin;
+		if(size == 0) continue;
+		uint64_t* subKeys = spare + begin;
+		uint64_t* subSpare = keys + begin;
+		if(SplitterTree::equalityBucket(bucket)) {
+			if(!toSpare) std::memcpy(subSpare, subKeys, size * sizeof(uint64_t));
+		}
+		else if(size <= SerialKeys) {
+			sortBucket(group, subKeys, subSpare, size, depth + 1, !toSpare);
+		}
+		else {
+			spawn(group, [=, &group]() {
+				sortBucket(group, subKeys, subSpare, size, depth + 1, !toSpare);
+			});
+		}
+	}
+}
+
+}; //End namespace
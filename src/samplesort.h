@@ -0,0 +1,218 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SAMPLESORT_INCLUDED
+#define _SAMPLESORT_INCLUDED
+//System includes
+//Library includes
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+//Project includes
+#include "sortalgorithm.h"
+#include "scratch.h"
+#include "threadpool.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Classifies keys into the buckets between sorted splitters
+ *	The splitters are stored as an implicit binary search tree (Eytzinger
+ *	layout), padded to a power of two with copies of the largest, so a key
+ *	is classified by a fixed number of data-dependent but branch-free steps.
+ *	Each splitter also gets an equality bucket of its own: with splitters
+ *	s[0] < ... < s[m-1], bucket 2i holds keys in (s[i-1], s[i]) and bucket
+ *	2i+1 holds keys equal to s[i]. Equality buckets never need sorting, so
+ *	heavily repeated keys cost a single pass.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class SplitterTree {
+public:
+	/**	@brief	Builds the tree
+	 *	@param	splitters	Sorted, distinct splitters; at least one
+	 */
+	void build(const std::vector<uint64_t>& splitters) {
+		splitters_ = splitters;
+		leaves_ = 1;
+		while(leaves_ <= splitters_.size()) leaves_ *= 2;
+		tree_.assign(leaves_, 0);
+		size_t next = 0;
+		fill(1, next);
+	}
+
+	/**	@brief	Number of buckets, including equality buckets */
+	inline size_t buckets() const { return 2 * splitters_.size() + 1; }
+
+	/**	@brief	True if every key in a bucket is equal */
+	static inline bool equalityBucket(size_t bucket) { return (bucket & 1) != 0; }
+
+	/**	@brief	Bucket of a key */
+	inline uint32_t classify(uint64_t key) const {
+		size_t node = 1;
+		while(node < leaves_)
+			node = 2 * node + (key > tree_[node]);
+		size_t rank = node - leaves_;
+		if(rank >= splitters_.size()) rank = splitters_.size();
+		else if(key == splitters_[rank]) return (uint32_t) (2 * rank + 1);
+		return (uint32_t) (2 * rank);
+	}
+
+private:
+	/**	@brief	Fills the subtree at node in order from the padded splitters */
+	void fill(size_t node, size_t& next) {
+		if(node >= leaves_) return;
+		fill(2 * node, next);
+		tree_[node] = splitters_[std::min(next++, splitters_.size() - 1)];
+		fill(2 * node + 1, next);
+	}
+
+private:
+	std::vector<uint64_t>	splitters_;		/*! Sorted, distinct splitters */
+	std::vector<uint64_t>	tree_;				/*! Padded splitters, node 1 at the root */
+	size_t								leaves_ = 1;	/*! Power of two above the splitter count */
+};
+
+/**	@brief	Parallel sample sort implementation for sorting library
+ *	A random sample of the keys, oversampled per bucket, is sorted and
+ *	thinned to splitters. All threads then classify their block of keys and
+ *	scatter it into the buckets of a scratch array. Each bucket becomes a
+ *	task of a TaskGroup on the shared pool, largest first: small buckets are
+ *	sorted directly, large ones are sample sorted again and add their own
+ *	buckets to the group, so a skewed distribution is split until every
+ *	worker has work.
+ *
+ *	Being comparison based, the cost does not depend on the width of the
+ *	keys. The parallelism achieved (CPU time in all phases over wall time),
+ *	task count and tasks stolen between workers are reported through
+ *	metrics().
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class SampleSort : public SortAlgorithm {
+private:
+	//Container of bucket counters
+	typedef std::vector<uint64_t>		Count_t;
+
+	//Below this many keys per thread fewer threads are used
+	static constexpr size_t MinKeysPerThread = 1 << 16;
+
+	//Buckets at most this large are sorted directly
+	static constexpr size_t SerialKeys = 1 << 14;
+
+	//Splitters per recursive partition
+	static constexpr size_t RecursiveSplitters = 63;
+
+	//Most splitters at the top level
+	static constexpr size_t MaxSplitters = 255;
+
+	//Top-level buckets wanted per thread, so stealing has work to balance
+	static constexpr size_t BucketsPerThread = 16;
+
+	//Recursion depth after which buckets are sorted directly
+	static constexpr unsigned MaxDepth = 4;
+
+	//Default sample keys per bucket
+	static constexpr size_t DefaultOversampling = 16;
+
+private:
+	//The sort type string
+	std::string 			type_ = "samplesort";
+
+	//Number of threads to use, 0 for the default
+	unsigned					threads_ = 0;
+
+	//Sample keys per bucket
+	size_t						oversampling_ = DefaultOversampling;
+
+	//Scatter buffer and bucket oracle, reused across sorts
+	ScratchArena			scratch_;
+	ScratchArena			oracle_;
+
+	//Measurements of the last sort
+	Metrics_t					metrics_;
+
+	//Bucket tasks run, and CPU time spent in them, during the last sort
+	std::atomic<uint64_t>	tasks_{0};
+	std::atomic<uint64_t>	taskNanos_{0};
+
+public:
+	/**	@brief	Default constructor */
+	SampleSort();
+
+	/**	@brief	Destructor */
+	virtual ~SampleSort();
+
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	void sort(uint64_t* keys, size_t count) override;
+
+	/**	@brief	Sets a sample sort tuning option
+	 *	Recognized options:
+	 *		threads				Number of threads, 0 for the default
+	 *		oversampling	Sample keys per bucket
+	 *		scratch-retain, huge-pages	See ScratchArena::setOption()
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized, otherwise false
+	 *	@throws	std::invalid_argument	On an invalid value for a recognized option
+	 */
+	bool setOption(const std::string& name, const std::string& value) override;
+
+	/**	@brief	Threads, buckets, tasks, steals and parallelism of the last sort */
+	Metrics_t metrics() const override { return metrics_; }
+
+private:
+	/**	@brief	Chooses splitters from a random sample of keys
+	 *	@param	keys			The keys
+	 *	@param	length		Number of keys
+	 *	@param	splitters	Most splitters wanted
+	 *	@param	tree			Receives the splitters
+	 */
+	void chooseSplitters(const uint64_t* keys, size_t length, size_t splitters,
+		SplitterTree& tree) const;
+
+	/**	@brief	Adds a bucket task to the group, counting it and its CPU time
+	 *	@param	group	The group of the sort
+	 *	@param	task	The task
+	 */
+	void spawn(TaskGroup& group, std::function<void()> task);
+
+	/**	@brief	Sorts one bucket, as a task of the group
+	 *	@param	group			The group of the sort, for sub-bucket tasks
+	 *	@param	keys			The bucket's keys
+	 *	@param	spare			Space for length keys
+	 *	@param	length		Number of keys
+	 *	@param	depth			Partitioning depth of this bucket
+	 *	@param	toSpare		True to leave the sorted keys in spare rather than keys
+	 */
+	void sortBucket(TaskGroup& group, uint64_t* keys, uint64_t* spare,
+		size_t length, unsigned depth, bool toSpare);
+};
+
+SampleSort __samplesort_instance;
+
+}; //End namespace
+
+#endif //Include once
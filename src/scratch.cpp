@@ -0,0 +1,138 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <sys/mman.h>
+//Library includes
+#include <new>
+#include <stdexcept>
+//Project includes
+#include "scratch.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Parses a byte size such as 512M
+ *	@param	text	Digits with an optional B, K, M or G suffix
+ *	@return	The number of bytes
+ *	@throws	std::invalid_argument	If the text is not a valid size
+ */
+uint64_t parseByteSize(const std::string& text) {
+	size_t end = 0;
+	uint64_t value = 0;
+	try {
+		value = std::stoull(text, &end);
+	}
+	catch(const std::exception&) {
+		throw std::invalid_argument("Invalid size: " + text);
+	}
+
+	std::string suffix = text.substr(end);
+	if(suffix == "" || suffix == "B") return value;
+	if(suffix == "K" || suffix == "k") return value << 10;
+	if(suffix == "M" || suffix == "m") return value << 20;
+	if(suffix == "G" || suffix == "g") return value << 30;
+	throw std::invalid_argument("Invalid size: " + text);
+}
+
+/**	@brief	Construct without allocating
+ *	@param	retainBytes	Most memory kept between sorts
+ *	@param	hugePages		Huge page backing for the buffer
+ */
+ScratchArena::ScratchArena(size_t retainBytes, HugePages hugePages) :
+	data_(nullptr),
+	bytes_(0),
+	retainBytes_(retainBytes),
+	hugePages_(hugePages)
+	{}
+
+/**	@brief	Destructor, unmaps the buffer */
+ScratchArena::~ScratchArena() {
+	release();
+}
+
+/**	@brief	Returns a buffer of at least bytes bytes
+ *	@param	bytes	Size needed
+ *	@return	The buffer, aligned for any key type
+ *	@throws	std::bad_alloc	If the memory cannot be mapped
+ */
+void* ScratchArena::reserve(size_t bytes) {
+	if(bytes <= bytes_) return data_;
+	release();
+
+	//Whole huge pages for large buffers, so the tail is not left on small pages
+	const size_t pageBytes = (hugePages_ != HugePages::None && bytes >= HugePageBytes) ?
+		HugePageBytes : 4096;
+	const size_t length = (bytes + pageBytes - 1) / pageBytes * pageBytes;
+
+	void* map = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if(hugePages_ == HugePages::Explicit && pageBytes == HugePageBytes)
+		map = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+	if(map == MAP_FAILED) {
+		map = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0);
+		if(map == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+		if(pageBytes == HugePageBytes) ::madvise(map, length, MADV_HUGEPAGE);
+#endif
+	}
+
+	data_ = map;
+	bytes_ = length;
+	return data_;
+}
+
+/**	@brief	Releases the buffer if it is larger than the retention cap */
+void ScratchArena::trim() {
+	if(bytes_ > retainBytes_) release();
+}
+
+/**	@brief	Releases the buffer */
+void ScratchArena::release() {
+	if(data_ != nullptr) ::munmap(data_, bytes_);
+	data_ = nullptr;
+	bytes_ = 0;
+}
+
+/**	@brief	Sets a scratch tuning option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True if the option is recognized, otherwise false
+ *	@throws	std::invalid_argument	On an invalid value for a recognized option
+ */
+bool ScratchArena::setOption(const std::string& name, const std::string& value) {
+	if(name == "scratch-retain") {
+		retainBytes_ = parseByteSize(value);
+		trim();
+	}
+	else if(name == "huge-pages") {
+		if(value == "none") hugePages_ = HugePages::None;
+		else if(value == "thp") hugePages_ = HugePages::Transparent;
+		else if(value == "hugetlb") hugePages_ = HugePages::Explicit;
+		else throw std::invalid_argument("Invalid value for huge-pages: " + value);
+		release();
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+}; //End namespace
@@ -0,0 +1,117 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SCRATCH_INCLUDED
+#define _SCRATCH_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace JAC::Integer {
+
+/**	@brief	How a ScratchArena asks for huge pages */
+enum class HugePages {
+	None,					/*! Ordinary pages */
+	Transparent,	/*! madvise(MADV_HUGEPAGE) on an ordinary mapping */
+	Explicit			/*! MAP_HUGETLB, falling back to Transparent when none are reserved */
+};
+
+/**	@brief	Parses a byte size such as 512M
+ *	@param	text	Digits with an optional B, K, M or G suffix
+ *	@return	The number of bytes
+ *	@throws	std::invalid_argument	If the text is not a valid size
+ */
+uint64_t parseByteSize(const std::string& text);
+
+/**	@brief	Scratch memory reused across the sorts of one algorithm instance
+ *	The buffer is an anonymous mapping that only grows, so sorting batches
+ *	back to back pays for page faults once rather than on every call, and
+ *	the memory is never value-initialized. The mapping can be backed by huge
+ *	pages to cut TLB misses on large buffers. trim() releases it after a
+ *	sort if it is larger than the retention cap.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class ScratchArena {
+public:
+	//Default cap on the memory kept between sorts
+	static constexpr size_t DefaultRetainBytes = 1UL << 30;
+
+	//Buffers at least this large are rounded to, and advised as, huge pages
+	static constexpr size_t HugePageBytes = 2UL << 20;
+
+public:
+	/**	@brief	Construct without allocating
+	 *	@param	retainBytes	Most memory kept between sorts
+	 *	@param	hugePages		Huge page backing for the buffer
+	 */
+	explicit ScratchArena(size_t retainBytes = DefaultRetainBytes,
+		HugePages hugePages = HugePages::Transparent);
+
+	/**	@brief	Destructor, unmaps the buffer */
+	virtual ~ScratchArena();
+
+	ScratchArena(const ScratchArena&) = delete;
+	ScratchArena& operator=(const ScratchArena&) = delete;
+
+	/**	@brief	Returns a buffer of at least bytes bytes
+	 *	Contents are unspecified, and are lost if the buffer has to grow.
+	 *	@param	bytes	Size needed
+	 *	@return	The buffer, aligned for any key type
+	 *	@throws	std::bad_alloc	If the memory cannot be mapped
+	 */
+	void* reserve(size_t bytes);
+
+	/**	@brief	Returns a buffer of at least count elements of type T
+	 *	@param	count	Number of elements needed
+	 */
+	template<typename T>
+	inline T* reserve(size_t count) { return (T*) reserve(count * sizeof(T)); }
+
+	/**	@brief	Releases the buffer if it is larger than the retention cap */
+	void trim();
+
+	/**	@brief	Releases the buffer */
+	void release();
+
+	/**	@brief	Bytes currently mapped */
+	inline size_t capacity() const { return bytes_; }
+
+	/**	@brief	Sets a scratch tuning option
+	 *	Recognized options:
+	 *		scratch-retain	Most bytes kept between sorts (ie: 256M, 0 to always release)
+	 *		huge-pages			none, thp (madvise) or hugetlb (MAP_HUGETLB)
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized, otherwise false
+	 *	@throws	std::invalid_argument	On an invalid value for a recognized option
+	 */
+	bool setOption(const std::string& name, const std::string& value);
+
+private:
+	void*				data_;				/*! Start of the mapping, or nullptr */
+	size_t			bytes_;				/*! Length of the mapping */
+	size_t			retainBytes_;	/*! Most bytes kept by trim() */
+	HugePages		hugePages_;		/*! Huge page backing */
+};
+
+}; //End namespace
+
+#endif //Include once
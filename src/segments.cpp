@@ -0,0 +1,146 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <cstring>
+#include <vector>
+//Project includes
+#include "segments.h"
+#include "radixengine.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+//Below this many keys per thread a batch is sorted on one thread
+static const uint64_t MinKeysPerThread = 1 << 16;
+
+//Optimal 19-comparator network for 8 keys
+static const uint8_t Network8[][2] = {
+	{0,2}, {1,3}, {4,6}, {5,7}, {0,4}, {1,5}, {2,6}, {3,7}, {0,1}, {2,3},
+	{4,5}, {6,7}, {2,4}, {3,5}, {1,4}, {3,6}, {1,2}, {3,4}, {5,6}
+};
+
+//Green's 60-comparator network for 16 keys
+static const uint8_t Network16[][2] = {
+	{0,13}, {1,12}, {2,15}, {3,14}, {4,8}, {5,6}, {7,11}, {9,10},
+	{0,5}, {1,7}, {2,9}, {3,4}, {6,13}, {8,14}, {10,15}, {11,12},
+	{0,1}, {2,3}, {4,5}, {6,8}, {7,9}, {10,11}, {12,13}, {14,15},
+	{0,2}, {1,3}, {4,10}, {5,11}, {6,7}, {8,9}, {12,14}, {13,15},
+	{1,2}, {3,12}, {4,6}, {5,7}, {8,10}, {9,11}, {13,14},
+	{1,4}, {2,6}, {5,8}, {7,10}, {9,13}, {11,14},
+	{2,4}, {3,6}, {9,12}, {11,13},
+	{3,5}, {6,8}, {7,9}, {10,12},
+	{3,4}, {5,6}, {7,8}, {9,10}, {11,12},
+	{6,7}, {8,9}
+};
+
+/**	@brief	Sorts up to Width keys with a network, padding with the largest key
+ *	@param	keys		The keys
+ *	@param	length	Number of keys, at most Width
+ *	@param	network	Comparator pairs
+ */
+template<size_t Width, size_t Comparators>
+static inline void networkSort(uint64_t* keys, size_t length,
+	const uint8_t (&network)[Comparators][2]) {
+	uint64_t lane[Width];
+	std::memcpy(lane, keys, length * sizeof(uint64_t));
+	std::fill(lane + length, lane + Width, UINT64_MAX);
+
+	//Compare-exchange with min/max, which compiles to conditional moves
+	for(size_t idx = 0; idx < Comparators; idx++) {
+		uint64_t lhs = lane[network[idx][0]];
+		uint64_t rhs = lane[network[idx][1]];
+		lane[network[idx][0]] = std::min(lhs, rhs);
+		lane[network[idx][1]] = std::max(lhs, rhs);
+	}
+	std::memcpy(keys, lane, length * sizeof(uint64_t));
+}
+
+/**	@brief	Sorts a run of segments on the calling thread
+ *	@param	keys			The flat buffer of keys
+ *	@param	offsets		Segment boundaries
+ *	@param	first			First segment of the run
+ *	@param	last			One past the last segment of the run
+ */
+static void sortRun(uint64_t* keys, const uint64_t* offsets, size_t first, size_t last) {
+	RadixEngine engine(8);
+	std::vector<uint64_t> count;
+	std::vector<uint64_t> scratch;
+
+	for(size_t segment = first; segment < last; segment++) {
+		uint64_t* begin = keys + offsets[segment];
+		const size_t length = offsets[segment+1] - offsets[segment];
+
+		if(length < 2) {
+			continue;
+		}
+		else if(length <= 8) {
+			networkSort<8>(begin, length, Network8);
+		}
+		else if(length <= SegmentNetworkKeys) {
+			networkSort<16>(begin, length, Network16);
+		}
+		else if(length < SegmentRadixKeys) {
+			std::sort(begin, begin + length);
+		}
+		else {
+			//Scratch and histograms are reused by every large segment of the run
+			if(scratch.size() < length) scratch.resize(length);
+			count.resize(engine.histogramSize());
+			uint64_t* result = engine.sort(begin, scratch.data(), length, count.data());
+			if(result != begin)
+				std::memcpy(begin, result, length * sizeof(uint64_t));
+		}
+	}
+}
+
+/**	@brief	Sorts many independent segments of one flat buffer
+ *	@param	keys			The flat buffer of keys
+ *	@param	offsets		Segment boundaries, segments+1 entries
+ *	@param	segments	Number of segments
+ *	@param	threads		Most threads to use, 0 for the default
+ */
+void segmentedSort(uint64_t* keys, const uint64_t* offsets, size_t segments,
+	unsigned threads) {
+	if(segments == 0) return;
+
+	//Limit threads so every run is worth the thread
+	const uint64_t total = offsets[segments] - offsets[0];
+	uint64_t limit = (threads > 0) ? threads : defaultThreads();
+	limit = std::max<uint64_t>(1, std::min(limit, total / MinKeysPerThread));
+	if(limit < 2) {
+		sortRun(keys, offsets, 0, segments);
+		return;
+	}
+
+	//Thread t takes the segments that start in its share of the keys
+	std::vector<size_t> bounds(limit + 1, segments);
+	bounds[0] = 0;
+	for(uint64_t tid = 1; tid < limit; tid++) {
+		uint64_t start = offsets[0] + total * tid / limit;
+		bounds[tid] = std::lower_bound(offsets, offsets + segments, start) - offsets;
+	}
+
+	parallelFor((unsigned) limit, [&](unsigned tid) {
+		sortRun(keys, offsets, bounds[tid], bounds[tid+1]);
+	});
+}
+
+}; //End namespace
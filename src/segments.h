@@ -0,0 +1,51 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SEGMENTS_INCLUDED
+#define _SEGMENTS_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+
+namespace JAC::Integer {
+
+//Segments of at most this many keys are sorted with a sorting network
+const size_t SegmentNetworkKeys = 16;
+
+//Segments of at least this many keys are radix sorted
+const size_t SegmentRadixKeys = 128;
+
+/**	@brief	Sorts many independent segments of one flat buffer
+ *	Segment s holds keys[offsets[s]] up to, but not including,
+ *	keys[offsets[s+1]], so offsets has segments+1 non-decreasing entries.
+ *	Each segment is sorted on its own: with a branch-free sorting network up
+ *	to SegmentNetworkKeys keys, an introsort below SegmentRadixKeys and an
+ *	LSD radix sort above. Runs of whole segments with about the same number
+ *	of keys are spread across threads.
+ *	@param	keys			The flat buffer of keys
+ *	@param	offsets		Segment boundaries, segments+1 entries
+ *	@param	segments	Number of segments
+ *	@param	threads		Most threads to use, 0 for the default
+ */
+void segmentedSort(uint64_t* keys, const uint64_t* offsets, size_t segments,
+	unsigned threads = 0);
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,437 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+//Project includes
+#include "select.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+//Below this many keys per thread a pass runs on one thread
+static const uint64_t MinKeysPerThread = 1 << 16;
+
+/**	@brief	Shifts right, yielding 0 for a shift of the whole key */
+static inline uint64_t shiftRight(uint64_t key, unsigned bits) {
+	return (bits < 64) ? key >> bits : 0;
+}
+
+/**	@brief	Number of threads worth using on a pass over count keys
+ *	@param	count		Number of keys
+ *	@param	threads	Most threads to use, 0 for the default
+ */
+static unsigned threadsFor(size_t count, unsigned threads) {
+	uint64_t limit = (threads > 0) ? threads : defaultThreads();
+	return (unsigned) std::max<uint64_t>(1, std::min<uint64_t>(limit, count / MinKeysPerThread));
+}
+
+/**	@brief	First key of a thread's share of a pass */
+static inline size_t chunkBegin(size_t count, unsigned parts, unsigned tid) {
+	return (size_t) ((unsigned __int128) count * tid / parts);
+}
+
+/**	@brief	Construct for a set of ranks
+ *	@param	ranks		Ranks to select, counting from 0, in any order
+ *	@param	minKey	Smallest key
+ *	@param	maxKey	Largest key
+ */
+RadixSelect::RadixSelect(const std::vector<uint64_t>& ranks, uint64_t minKey,
+	uint64_t maxKey) :
+	remaining_(ranks),
+	shift_(0),
+	bits_(0),
+	done_(false) {
+	//All keys equal? Nothing to count
+	if(minKey == maxKey || ranks.empty()) {
+		values_.assign(ranks.size(), minKey);
+		done_ = true;
+		return;
+	}
+
+	//Start at the highest bit in which the keys differ
+	uint8_t high = 64 - __builtin_clzll(minKey ^ maxKey);
+	bits_ = std::min(DigitBits, high);
+	shift_ = high - bits_;
+	prefix_.assign(ranks.size(), shiftRight(minKey, high));
+	prefixes_.assign(1, prefix_[0]);
+}
+
+/**	@brief	Counts keys into the histogram of the current pass
+ *	@param	keys		Keys, which need only include those matching an active prefix
+ *	@param	length	Number of keys
+ *	@param	counts	Counters from histogram(), added to
+ */
+void RadixSelect::count(const uint64_t* keys, size_t length, Histogram_t& counts) const {
+	const uint8_t high = shift_ + bits_;
+	const uint64_t mask = (1ULL << bits_) - 1;
+	uint64_t* block = counts.data();
+
+	//First pass over the full key range: every key is counted
+	if(high >= 64) {
+		for(size_t idx = 0; idx < length; idx++)
+			block[(keys[idx] >> shift_) & mask]++;
+		return;
+	}
+
+	if(prefixes_.size() == 1) {
+		const uint64_t prefix = prefixes_[0];
+		for(size_t idx = 0; idx < length; idx++) {
+			uint64_t key = keys[idx];
+			if((key >> high) == prefix) block[(key >> shift_) & mask]++;
+		}
+		return;
+	}
+
+	for(size_t idx = 0; idx < length; idx++) {
+		uint64_t key = keys[idx];
+		size_t index = group(key >> high);
+		if(index < prefixes_.size())
+			block[(index << bits_) + ((key >> shift_) & mask)]++;
+	}
+}
+
+/**	@brief	Resolves one digit of every rank from the summed histogram
+ *	@param	counts	Counts of every key for the current pass
+ */
+void RadixSelect::finishPass(const Histogram_t& counts) {
+	if(done_) return;
+
+	const size_t buckets = (size_t) 1 << bits_;
+	chosen_.clear();
+	for(size_t rank = 0; rank < prefix_.size(); rank++) {
+		size_t index = group(prefix_[rank]);
+		const uint64_t* block = counts.data() + (index << bits_);
+
+		//Bucket holding the rank among keys with this prefix
+		uint64_t below = 0;
+		size_t bucket = 0;
+		while(bucket + 1 < buckets && below + block[bucket] <= remaining_[rank])
+			below += block[bucket++];
+		remaining_[rank] -= below;
+		prefix_[rank] = (prefix_[rank] << bits_) | bucket;
+		chosen_.push_back((index << bits_) + bucket);
+	}
+	std::sort(chosen_.begin(), chosen_.end());
+	chosen_.erase(std::unique(chosen_.begin(), chosen_.end()), chosen_.end());
+
+	//Last digit? The prefixes are now the keys themselves
+	if(shift_ == 0) {
+		values_ = prefix_;
+		done_ = true;
+		return;
+	}
+
+	bits_ = std::min(DigitBits, shift_);
+	shift_ -= bits_;
+	prefixes_ = prefix_;
+	std::sort(prefixes_.begin(), prefixes_.end());
+	prefixes_.erase(std::unique(prefixes_.begin(), prefixes_.end()), prefixes_.end());
+}
+
+/**	@brief	Number of keys in a histogram that remain candidates
+ *	@param	counts	Counters of the last pass
+ */
+uint64_t RadixSelect::candidates(const Histogram_t& counts) const {
+	uint64_t total = 0;
+	for(size_t index : chosen_) total += counts[index];
+	return total;
+}
+
+/**	@brief	Copies the keys that share the prefix found so far for some rank
+ *	@param	keys		Keys to filter
+ *	@param	length	Number of keys
+ *	@param	out			Receives the matching keys, in input order
+ *	@return	The number of keys copied
+ */
+size_t RadixSelect::gather(const uint64_t* keys, size_t length, uint64_t* out) const {
+	const uint8_t high = shift_ + bits_;
+	size_t written = 0;
+	if(prefixes_.size() == 1) {
+		const uint64_t prefix = prefixes_[0];
+		for(size_t idx = 0; idx < length; idx++) {
+			if(shiftRight(keys[idx], high) == prefix) out[written++] = keys[idx];
+		}
+		return written;
+	}
+
+	for(size_t idx = 0; idx < length; idx++) {
+		if(group(shiftRight(keys[idx], high)) < prefixes_.size())
+			out[written++] = keys[idx];
+	}
+	return written;
+}
+
+/**	@brief	Counts keys into per-thread histograms, splitting the keys evenly
+ *	@param	keys		Keys, which need only include those matching an active prefix
+ *	@param	length	Number of keys
+ *	@param	counts	One histogram per thread, from histogram(), added to
+ */
+void RadixSelect::countParallel(const uint64_t* keys, size_t length,
+	std::vector<Histogram_t>& counts) const {
+	const unsigned parts = (unsigned) counts.size();
+	parallelFor(parts, [&](unsigned tid) {
+		size_t begin = chunkBegin(length, parts, tid);
+		count(keys + begin, chunkBegin(length, parts, tid+1) - begin, counts[tid]);
+	});
+}
+
+/**	@brief	Runs the remaining passes over keys that include every candidate
+ *	@param	keys		Keys, which need only include those matching an active prefix
+ *	@param	length	Number of keys
+ *	@param	threads	Most threads to use, 0 for the default
+ */
+void RadixSelect::resolve(const uint64_t* keys, size_t length, unsigned threads) {
+	std::vector<uint64_t> survivors;
+	while(!done_) {
+		const unsigned parts = threadsFor(length, threads);
+		std::vector<Histogram_t> counts(parts, histogram());
+		countParallel(keys, length, counts);
+		Histogram_t total = counts[0];
+		for(unsigned tid = 1; tid < parts; tid++) {
+			for(size_t idx = 0; idx < total.size(); idx++) total[idx] += counts[tid][idx];
+		}
+		finishPass(total);
+		if(done_) break;
+
+		//Gather the candidates once most keys are ruled out; later passes read only them
+		uint64_t remaining = candidates(total);
+		if(remaining > length / 4) continue;
+
+		std::vector<uint64_t> offsets(parts + 1, 0);
+		for(unsigned tid = 0; tid < parts; tid++)
+			offsets[tid+1] = offsets[tid] + candidates(counts[tid]);
+		std::vector<uint64_t> gathered(remaining);
+		parallelFor(parts, [&](unsigned tid) {
+			size_t begin = chunkBegin(length, parts, tid);
+			gather(keys + begin, chunkBegin(length, parts, tid+1) - begin,
+				gathered.data() + offsets[tid]);
+		});
+		survivors.swap(gathered);
+		keys = survivors.data();
+		length = remaining;
+	}
+}
+
+/**	@brief	Index of a prefix in prefixes_, or prefixes_.size() if inactive */
+size_t RadixSelect::group(uint64_t prefix) const {
+	if(prefixes_.size() == 1)
+		return (prefix == prefixes_[0]) ? 0 : 1;
+	std::vector<uint64_t>::const_iterator itr =
+		std::lower_bound(prefixes_.begin(), prefixes_.end(), prefix);
+	return (itr != prefixes_.end() && *itr == prefix) ?
+		itr - prefixes_.begin() : prefixes_.size();
+}
+
+/**	@brief	Finds the smallest and largest keys in one parallel pass
+ *	@param	keys		The keys, at least one
+ *	@param	count		Number of keys
+ *	@param	minKey	Receives the smallest key
+ *	@param	maxKey	Receives the largest key
+ *	@param	threads	Most threads to use, 0 for the default
+ */
+void keyRange(const uint64_t* keys, size_t count, uint64_t& minKey, uint64_t& maxKey,
+	unsigned threads) {
+	const unsigned parts = threadsFor(count, threads);
+	std::vector<uint64_t> mins(parts, UINT64_MAX);
+	std::vector<uint64_t> maxes(parts, 0);
+	parallelFor(parts, [&](unsigned tid) {
+		uint64_t low = UINT64_MAX;
+		uint64_t high = 0;
+		for(size_t idx = chunkBegin(count, parts, tid); idx < chunkBegin(count, parts, tid+1); idx++) {
+			low = std::min(low, keys[idx]);
+			high = std::max(high, keys[idx]);
+		}
+		mins[tid] = low;
+		maxes[tid] = high;
+	});
+	minKey = *std::min_element(mins.begin(), mins.end());
+	maxKey = *std::max_element(maxes.begin(), maxes.end());
+}
+
+/**	@brief	Selects the keys at several ranks without sorting
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	ranks		Ranks to select, counting from 0, each less than count
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The selected keys, in the order of ranks
+ *	@throws	std::out_of_range	If a rank is not less than count
+ */
+std::vector<uint64_t> selectRanks(const uint64_t* keys, size_t count,
+	const std::vector<uint64_t>& ranks, unsigned threads) {
+	for(uint64_t rank : ranks) {
+		if(rank >= count)
+			throw std::out_of_range("Rank " + std::to_string(rank) + " is out of range for " +
+				std::to_string(count) + " keys");
+	}
+	if(ranks.empty()) return std::vector<uint64_t>();
+
+	uint64_t minKey, maxKey;
+	keyRange(keys, count, minKey, maxKey, threads);
+	RadixSelect select(ranks, minKey, maxKey);
+	select.resolve(keys, count, threads);
+	return select.values();
+}
+
+/**	@brief	Selects the key at one rank without sorting
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	rank		Rank to select, counting from 0
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The key that would be keys[rank] once sorted
+ *	@throws	std::out_of_range	If rank is not less than count
+ */
+uint64_t selectRank(const uint64_t* keys, size_t count, uint64_t rank, unsigned threads) {
+	return selectRanks(keys, count, std::vector<uint64_t>(1, rank), threads)[0];
+}
+
+/**	@brief	Keeps the k keys ordered first by comp in a bounded heap per thread
+ *	On random input only about k log(count / k) keys ever enter a heap, so
+ *	this is a single read. Input ordered against comp would push every key
+ *	through the heap, so the heaps give up once replacements pass a small
+ *	fraction of the keys.
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted, less than count
+ *	@param	out			Receives k keys
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@param	comp		Ordering; the first k keys under it are kept
+ *	@return	False if the heaps gave up and out is unchanged
+ */
+template<typename Compare>
+static bool heapSelect(const uint64_t* keys, size_t count, size_t k, uint64_t* out,
+	unsigned threads, Compare comp) {
+	const unsigned parts = threadsFor(count, threads);
+	std::vector<std::vector<uint64_t>> heaps(parts);
+	std::atomic<bool> abandoned(false);
+	parallelFor(parts, [&](unsigned tid) {
+		const size_t begin = chunkBegin(count, parts, tid);
+		const size_t end = chunkBegin(count, parts, tid+1);
+		size_t budget = k + (end - begin) / 64;
+
+		//The heap's front is the worst key kept, so most keys are rejected by one compare
+		std::vector<uint64_t>& heap = heaps[tid];
+		heap.reserve(k);
+		for(size_t idx = begin; idx < end; idx++) {
+			uint64_t key = keys[idx];
+			if(heap.size() < k) {
+				heap.push_back(key);
+				std::push_heap(heap.begin(), heap.end(), comp);
+			}
+			else if(comp(key, heap.front())) {
+				if(--budget == 0 || abandoned.load(std::memory_order_relaxed)) {
+					abandoned = true;
+					return;
+				}
+				std::pop_heap(heap.begin(), heap.end(), comp);
+				heap.back() = key;
+				std::push_heap(heap.begin(), heap.end(), comp);
+			}
+		}
+	});
+	if(abandoned) return false;
+
+	std::vector<uint64_t> merged;
+	for(const std::vector<uint64_t>& heap : heaps)
+		merged.insert(merged.end(), heap.begin(), heap.end());
+	std::nth_element(merged.begin(), merged.begin() + (k - 1), merged.end(), comp);
+	std::copy(merged.begin(), merged.begin() + k, out);
+	return true;
+}
+
+/**	@brief	Gathers every key ordered before pivot, then pads with the pivot
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted; pivot is the k-th under comp
+ *	@param	out			Receives k keys
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@param	pivot		The k-th key under comp
+ *	@param	comp		Ordering; the first k keys under it are gathered
+ */
+template<typename Compare>
+static void gatherBefore(const uint64_t* keys, size_t count, size_t k, uint64_t* out,
+	unsigned threads, uint64_t pivot, Compare comp) {
+	const unsigned parts = threadsFor(count, threads);
+	std::vector<uint64_t> offsets(parts + 1, 0);
+	parallelFor(parts, [&](unsigned tid) {
+		uint64_t before = 0;
+		for(size_t idx = chunkBegin(count, parts, tid); idx < chunkBegin(count, parts, tid+1); idx++)
+			before += comp(keys[idx], pivot);
+		offsets[tid+1] = before;
+	});
+	for(unsigned tid = 0; tid < parts; tid++)
+		offsets[tid+1] += offsets[tid];
+
+	parallelFor(parts, [&](unsigned tid) {
+		uint64_t* dst = out + offsets[tid];
+		for(size_t idx = chunkBegin(count, parts, tid); idx < chunkBegin(count, parts, tid+1); idx++) {
+			if(comp(keys[idx], pivot)) *dst++ = keys[idx];
+		}
+	});
+	std::fill(out + offsets[parts], out + k, pivot);
+}
+
+/**	@brief	Copies the k smallest keys, in no particular order
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted
+ *	@param	out			Receives min(k, count) keys
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The number of keys written
+ */
+size_t selectSmallest(const uint64_t* keys, size_t count, size_t k, uint64_t* out,
+	unsigned threads) {
+	k = std::min(k, count);
+	if(k == 0)
+		return 0;
+	else if(k == count)
+		std::memcpy(out, keys, count * sizeof(uint64_t));
+	else if(k > HeapSelectKeys || !heapSelect(keys, count, k, out, threads, std::less<uint64_t>()))
+		gatherBefore(keys, count, k, out, threads, selectRank(keys, count, k - 1, threads),
+			std::less<uint64_t>());
+	return k;
+}
+
+/**	@brief	Copies the k largest keys, in no particular order
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted
+ *	@param	out			Receives min(k, count) keys
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The number of keys written
+ */
+size_t selectLargest(const uint64_t* keys, size_t count, size_t k, uint64_t* out,
+	unsigned threads) {
+	k = std::min(k, count);
+	if(k == 0)
+		return 0;
+	else if(k == count)
+		std::memcpy(out, keys, count * sizeof(uint64_t));
+	else if(k > HeapSelectKeys || !heapSelect(keys, count, k, out, threads, std::greater<uint64_t>()))
+		gatherBefore(keys, count, k, out, threads, selectRank(keys, count, count - k, threads),
+			std::greater<uint64_t>());
+	return k;
+}
+
+}; //End namespace
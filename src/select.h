@@ -0,0 +1,191 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SELECT_INCLUDED
+#define _SELECT_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace JAC::Integer {
+
+//Requests for at most this many keys try a bounded heap per thread first
+const size_t HeapSelectKeys = 4096;
+
+/**	@brief	Exact selection of keys by rank, one radix digit per pass
+ *	Each pass counts a histogram of the next digit of every key that shares
+ *	the prefix found so far for some requested rank; the bucket holding the
+ *	rank then extends its prefix by that digit. Keys outside every active
+ *	prefix can be discarded between passes. Counting is kept apart from the
+ *	data, so passes may run over an array, a shrinking set of candidates, or
+ *	a file streamed once per pass, and per-thread histograms are summed.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class RadixSelect {
+public:
+	//Width of the digit resolved by each pass
+	static constexpr uint8_t DigitBits = 11;
+
+	//Counters for one pass, one block of buckets per active prefix
+	typedef std::vector<uint64_t>	Histogram_t;
+
+public:
+	/**	@brief	Construct for a set of ranks
+	 *	The key range is usually found with a first pass (see keyRange()), so
+	 *	digits above the highest bit in which the keys differ are skipped.
+	 *	@param	ranks		Ranks to select, counting from 0, in any order
+	 *	@param	minKey	Smallest key
+	 *	@param	maxKey	Largest key
+	 */
+	RadixSelect(const std::vector<uint64_t>& ranks, uint64_t minKey, uint64_t maxKey);
+
+	/**	@brief	True once every rank has been resolved */
+	inline bool done() const { return done_; }
+
+	/**	@brief	Returns zeroed counters for the current pass */
+	inline Histogram_t histogram() const { return Histogram_t(prefixes_.size() << bits_, 0); }
+
+	/**	@brief	Counts keys into the histogram of the current pass
+	 *	@param	keys		Keys, which need only include those matching an active prefix
+	 *	@param	length	Number of keys
+	 *	@param	counts	Counters from histogram(), added to
+	 */
+	void count(const uint64_t* keys, size_t length, Histogram_t& counts) const;
+
+	/**	@brief	Counts keys into per-thread histograms, splitting the keys evenly
+	 *	@param	keys		Keys, which need only include those matching an active prefix
+	 *	@param	length	Number of keys
+	 *	@param	counts	One histogram per thread, from histogram(), added to
+	 */
+	void countParallel(const uint64_t* keys, size_t length, std::vector<Histogram_t>& counts) const;
+
+	/**	@brief	Resolves one digit of every rank from the summed histogram
+	 *	@param	counts	Counts of every key for the current pass
+	 */
+	void finishPass(const Histogram_t& counts);
+
+	/**	@brief	Number of keys in a histogram that remain candidates
+	 *	Valid after finishPass() for that pass's histogram (or a per-thread
+	 *	part of it), so candidates can be gathered into place.
+	 *	@param	counts	Counters of the last pass
+	 */
+	uint64_t candidates(const Histogram_t& counts) const;
+
+	/**	@brief	Copies the keys that share the prefix found so far for some rank
+	 *	@param	keys		Keys to filter
+	 *	@param	length	Number of keys
+	 *	@param	out			Receives the matching keys, in input order
+	 *	@return	The number of keys copied
+	 */
+	size_t gather(const uint64_t* keys, size_t length, uint64_t* out) const;
+
+	/**	@brief	Runs the remaining passes over keys that include every candidate
+	 *	Keys ruled out by earlier passes may be present or not. The candidates
+	 *	are gathered into a smaller array once most keys are ruled out, so
+	 *	only the first pass or two read every key.
+	 *	@param	keys		Keys, which need only include those matching an active prefix
+	 *	@param	length	Number of keys
+	 *	@param	threads	Most threads to use, 0 for the default
+	 */
+	void resolve(const uint64_t* keys, size_t length, unsigned threads = 0);
+
+	/**	@brief	The selected keys, in the order of the requested ranks
+	 *	Valid once done().
+	 */
+	inline const std::vector<uint64_t>& values() const { return values_; }
+
+private:
+	/**	@brief	Index of a prefix in prefixes_, or prefixes_.size() if inactive */
+	size_t group(uint64_t prefix) const;
+
+private:
+	std::vector<uint64_t>	prefixes_;		/*! Active prefixes, sorted and distinct */
+	std::vector<uint64_t>	prefix_;			/*! Prefix found so far for each rank */
+	std::vector<uint64_t>	remaining_;		/*! Rank of each among keys with its prefix */
+	std::vector<size_t>		chosen_;			/*! Histogram counters of the last pass kept */
+	std::vector<uint64_t>	values_;			/*! Selected keys, once done */
+	uint8_t								shift_;				/*! Bits below the current digit */
+	uint8_t								bits_;				/*! Width of the current digit */
+	bool									done_;				/*! True once every rank is resolved */
+};
+
+/**	@brief	Finds the smallest and largest keys in one parallel pass
+ *	@param	keys		The keys, at least one
+ *	@param	count		Number of keys
+ *	@param	minKey	Receives the smallest key
+ *	@param	maxKey	Receives the largest key
+ *	@param	threads	Most threads to use, 0 for the default
+ */
+void keyRange(const uint64_t* keys, size_t count, uint64_t& minKey, uint64_t& maxKey,
+	unsigned threads = 0);
+
+/**	@brief	Selects the keys at several ranks without sorting
+ *	Reads the keys about three times: for the key range, for the first
+ *	histogram and to gather the few candidates left, whose later passes are
+ *	cheap. The keys are not modified.
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	ranks		Ranks to select, counting from 0, each less than count
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The selected keys, in the order of ranks
+ *	@throws	std::out_of_range	If a rank is not less than count
+ */
+std::vector<uint64_t> selectRanks(const uint64_t* keys, size_t count,
+	const std::vector<uint64_t>& ranks, unsigned threads = 0);
+
+/**	@brief	Selects the key at one rank without sorting
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	rank		Rank to select, counting from 0
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The key that would be keys[rank] once sorted
+ *	@throws	std::out_of_range	If rank is not less than count
+ */
+uint64_t selectRank(const uint64_t* keys, size_t count, uint64_t rank, unsigned threads = 0);
+
+/**	@brief	Copies the k smallest keys, in no particular order
+ *	Up to HeapSelectKeys keys are kept in a bounded heap per thread in a
+ *	single read, unless the input order defeats the heap; otherwise the k-th
+ *	key is found with selectRanks() and every key below it gathered.
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted
+ *	@param	out			Receives min(k, count) keys
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The number of keys written
+ */
+size_t selectSmallest(const uint64_t* keys, size_t count, size_t k, uint64_t* out,
+	unsigned threads = 0);
+
+/**	@brief	Copies the k largest keys, in no particular order
+ *	@param	keys		The keys
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted
+ *	@param	out			Receives min(k, count) keys
+ *	@param	threads	Most threads to use, 0 for the default
+ *	@return	The number of keys written
+ */
+size_t selectLargest(const uint64_t* keys, size_t count, size_t k, uint64_t* out,
+	unsigned threads = 0);
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,156 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+//Project includes
+#include "selector.h"
+#include "sortalgorithm.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+//Keys in the duplicate sample
+static const size_t SampleKeys = 1024;
+
+/**	@brief	Profiles a set of keys
+ *	@param	keys	The keys
+ *	@param	count	Number of keys
+ */
+InputProfile profileKeys(const uint64_t* keys, size_t count) {
+	InputProfile profile = { count, 0, 0, 0, 0, true, 0, 0 };
+	if(count == 0) return profile;
+
+	//Range and run boundaries in one pass
+	uint64_t minKey = keys[0], maxKey = keys[0];
+	uint64_t descents = 0, ascents = 0;
+	for(size_t idx = 1; idx < count; idx++) {
+		uint64_t key = keys[idx];
+		minKey = std::min(minKey, key);
+		maxKey = std::max(maxKey, key);
+		descents += (key < keys[idx-1]);
+		ascents += (key > keys[idx-1]);
+	}
+	profile.minKey = minKey;
+	profile.maxKey = maxKey;
+	profile.spreadBits = (minKey == maxKey) ? 0 : 64 - __builtin_clzll(minKey ^ maxKey);
+	profile.runs = descents + 1;
+	profile.nonIncreasing = (ascents == 0);
+
+	//Duplicates among evenly spaced samples
+	size_t samples = std::min(count, SampleKeys);
+	std::vector<uint64_t> sample(samples);
+	for(size_t idx = 0; idx < samples; idx++)
+		sample[idx] = keys[(uint64_t) idx * count / samples];
+	std::sort(sample.begin(), sample.end());
+	size_t repeated = 0;
+	for(size_t idx = 1; idx < samples; idx++)
+		repeated += (sample[idx] == sample[idx-1]);
+	profile.sampled = samples;
+	profile.duplicates = (samples > 1) ? (double) repeated / (samples - 1) : 0;
+
+	return profile;
+}
+
+/**	@brief	Construct a selector
+ *	@param	threads	Threads available to parallel plugins, 0 for the default
+ */
+AlgorithmSelector::AlgorithmSelector(unsigned threads) :
+	threads_(threads)
+	{}
+
+/**	@brief	Destructor */
+AlgorithmSelector::~AlgorithmSelector() {
+}
+
+/**	@brief	Chooses an algorithm for an input
+ *	@param	profile	The input's profile
+ *	@return	The chosen algorithm and the reason for the choice
+ */
+AlgorithmChoice AlgorithmSelector::choose(const InputProfile& profile) {
+	if(profile.keys < 2 || profile.runs == 1)
+		return { AlreadySorted, "input is already sorted" };
+	if(profile.nonIncreasing)
+		return { Reverse, "input is in descending order" };
+	if(profile.runs <= MaxMergeRuns)
+		return { RunMerge, "input is " + std::to_string(profile.runs) + " sorted runs" };
+	if(profile.keys <= SmallKeys)
+		return { Insertion, "input is tiny" };
+
+	//A single histogram pass beats sorting when keys span a small range or repeat
+	const uint64_t range = profile.maxKey - profile.minKey;
+	if(range < profile.keys && range < DenseRange && available("counting"))
+		return { "counting", "keys span " + std::to_string(range + 1) + " values, no more than " +
+			"the number of keys" };
+	if(profile.duplicates >= ManyDuplicates && available("counting"))
+		return { "counting", "keys repeat heavily" };
+
+	//Parallel plugins pay off once every thread has a useful share
+	unsigned threads = (threads_ > 0) ? threads_ : defaultThreads();
+	if(threads > 1 && profile.spreadBits > WideBits && available("samplesort")) {
+		const SortCapabilities* caps = SortAlgorithm::capabilities("samplesort");
+		if(caps == nullptr || profile.keys >= caps->minKeys)
+			return { "samplesort", "large input of wide keys and " + std::to_string(threads) +
+				" threads" };
+	}
+	if(threads > 1 && available("parradix")) {
+		const SortCapabilities* caps = SortAlgorithm::capabilities("parradix");
+		if(caps == nullptr || profile.keys >= caps->minKeys)
+			return { "parradix", "large input and " + std::to_string(threads) + " threads" };
+	}
+
+	if(profile.spreadBits <= NarrowBits && available("radix"))
+		return { "radix", "keys differ only in their low " + std::to_string(profile.spreadBits) +
+			" bits, so LSD radix needs at most two passes" };
+	if(available("simdsort"))
+		return { "simdsort", "wide keys; vectorized quicksort does not pay per key byte" };
+	if(available("msdradix"))
+		return { "msdradix", "general case; in-place MSD radix skips shared leading bytes" };
+	if(available("radix"))
+		return { "radix", "general case" };
+	return { Introsort, "no radix or quicksort plugin is available; using std::sort" };
+}
+
+/**	@brief	Describes a profile in one line, for logging */
+std::string AlgorithmSelector::describe(const InputProfile& profile) {
+	char text[160];
+	snprintf(text, sizeof(text), "%lu keys, %u-bit spread, %.1f%% duplicates, %lu runs",
+		profile.keys, profile.spreadBits, profile.duplicates * 100, profile.runs);
+	return text;
+}
+
+/**	@brief	True if the named plugin can be loaded; cached per selector */
+bool AlgorithmSelector::available(const std::string& name) {
+	auto itr = available_.find(name);
+	if(itr != available_.end()) return itr->second;
+
+	bool loaded = true;
+	try {
+		SortAlgorithm::capabilities(name);
+	}
+	catch(const std::exception&) {
+		loaded = false;
+	}
+	available_[name] = loaded;
+	return loaded;
+}
+
+}; //End namespace
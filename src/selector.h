@@ -0,0 +1,126 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SELECTOR_INCLUDED
+#define _SELECTOR_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace JAC::Integer {
+
+/**	@brief	Cheap summary of a set of keys, used to choose an algorithm */
+struct InputProfile {
+	uint64_t	keys;						/*! Number of keys */
+	uint64_t	minKey;					/*! Smallest key */
+	uint64_t	maxKey;					/*! Largest key */
+	unsigned	spreadBits;			/*! Bits that differ between keys, at most; see profileKeys() */
+	uint64_t	runs;						/*! Maximal non-decreasing runs */
+	bool			nonIncreasing;	/*! True if no key is larger than the one before it */
+	size_t		sampled;				/*! Keys in the duplicate sample */
+	double		duplicates;			/*! Fraction of sampled keys equal to another sampled key */
+};
+
+/**	@brief	Profiles a set of keys
+ *	One sequential pass finds the key range and counts the runs; a sorted,
+ *	evenly spaced sample of up to SampleKeys keys estimates the duplicate
+ *	ratio. spreadBits is the position of the highest bit in which the
+ *	smallest and largest keys differ, which bounds the digits a radix sort
+ *	must actually process.
+ *	@param	keys	The keys
+ *	@param	count	Number of keys
+ */
+InputProfile profileKeys(const uint64_t* keys, size_t count);
+
+/**	@brief	An algorithm chosen for an input, and why */
+struct AlgorithmChoice {
+	std::string	algorithm;		/*! Plugin name, or one of the AlgorithmSelector built-ins */
+	std::string	reason;				/*! Human-readable explanation */
+};
+
+/**	@brief	Chooses the sort algorithm for a profiled input
+ *	Inputs that are already ordered, reversed, made of a few runs or tiny are
+ *	handled by built-in strategies. Narrow or highly repetitive keys are
+ *	counted rather than sorted. Otherwise the choice falls to the best
+ *	plugin available in the registry, so the selector degrades gracefully
+ *	when plugins are missing: with none of them, keys are sorted in process
+ *	with std::sort.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class AlgorithmSelector {
+public:
+	//Built-in strategies
+	static constexpr const char* AlreadySorted = "none";
+	static constexpr const char* Reverse = "reverse";
+	static constexpr const char* RunMerge = "run-merge";
+	static constexpr const char* Insertion = "insertion";
+	static constexpr const char* Introsort = "introsort";
+
+	//Inputs this small use insertion sort
+	static constexpr uint64_t SmallKeys = 32;
+
+	//Inputs with at most this many runs are merged rather than sorted
+	static constexpr uint64_t MaxMergeRuns = 16;
+
+	//Key spread, in bits, that LSD radix covers in two passes
+	static constexpr unsigned NarrowBits = 16;
+
+	//Key spread, in bits, above which parallel radix needs more passes than
+	//a parallel comparison sort needs levels
+	static constexpr unsigned WideBits = 32;
+
+	//Largest key range counted with a dense histogram
+	static constexpr uint64_t DenseRange = 1 << 24;
+
+	//Sampled duplicate ratio at which counting the distinct keys pays off
+	static constexpr double ManyDuplicates = 0.5;
+
+public:
+	/**	@brief	Construct a selector
+	 *	@param	threads	Threads available to parallel plugins, 0 for the default
+	 */
+	explicit AlgorithmSelector(unsigned threads = 0);
+
+	/**	@brief	Destructor */
+	virtual ~AlgorithmSelector();
+
+	/**	@brief	Chooses an algorithm for an input
+	 *	@param	profile	The input's profile
+	 *	@return	The chosen algorithm and the reason for the choice
+	 */
+	AlgorithmChoice choose(const InputProfile& profile);
+
+	/**	@brief	Describes a profile in one line, for logging */
+	static std::string describe(const InputProfile& profile);
+
+private:
+	/**	@brief	True if the named plugin can be loaded; cached per selector */
+	bool available(const std::string& name);
+
+private:
+	unsigned								threads_;		/*! Thread count, 0 for the default */
+	std::map<std::string, bool>	available_;	/*! Plugin availability, by name */
+};
+
+}; //End namespace
+
+#endif //Include once
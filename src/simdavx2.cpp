@@ -0,0 +1,129 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <immintrin.h>
+//Library includes
+//Project includes
+#include "simdkernel.h"
+
+namespace JAC::Integer {
+
+namespace {
+
+/**	@brief	Builds the AVX2 arrangement table
+ *	Entry m holds 32-bit lane indices that move the 64-bit lanes set in m to
+ *	the front, in order, followed by the others.
+ */
+struct ArrangeTable {
+	uint32_t	index[16][8];
+
+	constexpr ArrangeTable() : index() {
+		for(unsigned mask = 0; mask < 16; mask++) {
+			unsigned out = 0;
+			for(unsigned pass = 0; pass < 2; pass++) {
+				for(unsigned lane = 0; lane < 4; lane++) {
+					if(((mask >> lane) & 1) != (pass == 0 ? 1U : 0U)) continue;
+					index[mask][out++] = lane * 2;
+					index[mask][out++] = lane * 2 + 1;
+				}
+			}
+		}
+	}
+};
+
+static constexpr ArrangeTable Arrangements;
+
+/**	@brief	AVX2 primitives for VectorQuickSort, four keys per register
+ *	AVX2 has only signed 64-bit compares, so keys are compared with their
+ *	top bits flipped.
+ */
+struct Avx2Ops {
+	typedef __m256i	Reg;
+	static constexpr size_t Lanes = 4;
+
+	static inline Reg load(const uint64_t* data) { return _mm256_loadu_si256((const Reg*) data); }
+	static inline void store(uint64_t* data, Reg keys) { _mm256_storeu_si256((Reg*) data, keys); }
+	static inline Reg set1(uint64_t key) { return _mm256_set1_epi64x((long long) key); }
+
+	//All-ones lanes where a > b, unsigned
+	static inline Reg greater(Reg a, Reg b) {
+		const Reg flip = set1(1ULL << 63);
+		return _mm256_cmpgt_epi64(_mm256_xor_si256(a, flip), _mm256_xor_si256(b, flip));
+	}
+
+	static inline Reg min(Reg a, Reg b) { return _mm256_blendv_epi8(a, b, greater(a, b)); }
+	static inline Reg max(Reg a, Reg b) { return _mm256_blendv_epi8(b, a, greater(a, b)); }
+
+	//All-ones in the first count lanes
+	static inline Reg firstLanes(size_t count) {
+		return _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long) count),
+			_mm256_setr_epi64x(0, 1, 2, 3));
+	}
+
+	static inline Reg loadPadded(const uint64_t* data, size_t count) {
+		Reg valid = firstLanes(count);
+		return _mm256_blendv_epi8(set1(~0ULL),
+			_mm256_maskload_epi64((const long long*) data, valid), valid);
+	}
+
+	static inline void storePartial(uint64_t* data, Reg keys, size_t count) {
+		_mm256_maskstore_epi64((long long*) data, firstLanes(count), keys);
+	}
+
+	static inline Reg arrange(Reg keys, Reg pivots, size_t& count) {
+		unsigned upper = _mm256_movemask_pd(_mm256_castsi256_pd(greater(keys, pivots)));
+		unsigned lower = ~upper & 0xF;
+		count = __builtin_popcount(lower);
+		return _mm256_permutevar8x32_epi32(keys,
+			_mm256_loadu_si256((const Reg*) Arrangements.index[lower]));
+	}
+
+	//Compare-exchange each lane with its partner; Blend selects the 32-bit
+	//halves of the lanes that keep the larger key
+	template<int Partners, int Blend>
+	static inline Reg exchange(Reg keys) {
+		Reg other = _mm256_permute4x64_epi64(keys, Partners);
+		return _mm256_blend_epi32(min(keys, other), max(keys, other), Blend);
+	}
+
+	static inline Reg reverse(Reg keys) { return _mm256_permute4x64_epi64(keys, 0x1B); }
+
+	static inline Reg merge(Reg keys) {
+		keys = exchange<0x4E, 0xF0>(keys);
+		return exchange<0xB1, 0xCC>(keys);
+	}
+
+	static inline Reg sort(Reg keys) {
+		keys = exchange<0xB1, 0xCC>(keys);
+		keys = exchange<0x1B, 0xF0>(keys);
+		return exchange<0xB1, 0xCC>(keys);
+	}
+};
+
+}; //End anonymous namespace
+
+/**	@brief	Vectorized quicksort using AVX2; only call if the CPU supports it
+ *	@param	data		Keys to sort in place
+ *	@param	length	Number of keys
+ */
+void avx2Sort(uint64_t* data, size_t length) {
+	VectorQuickSort<Avx2Ops>::sort(data, length);
+}
+
+}; //End namespace
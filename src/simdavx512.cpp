@@ -0,0 +1,103 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <immintrin.h>
+//Library includes
+//Project includes
+#include "simdkernel.h"
+
+namespace JAC::Integer {
+
+namespace {
+
+//Every lane. Unmasked min, max and permutexvar pass GCC's _mm512_undefined_epi32()
+//as their source, which -Wall reports as uninitialized; the zero-masked forms
+//with every lane set compile to the same instructions.
+static const __mmask8 AllLanes = 0xFF;
+
+/**	@brief	AVX-512F/VL primitives for VectorQuickSort, eight keys per register */
+struct Avx512Ops {
+	typedef __m512i	Reg;
+	static constexpr size_t Lanes = 8;
+
+	static inline Reg load(const uint64_t* data) { return _mm512_loadu_si512(data); }
+	static inline void store(uint64_t* data, Reg keys) { _mm512_storeu_si512(data, keys); }
+	static inline Reg set1(uint64_t key) { return _mm512_set1_epi64((long long) key); }
+	static inline Reg min(Reg a, Reg b) { return _mm512_maskz_min_epu64(AllLanes, a, b); }
+	static inline Reg max(Reg a, Reg b) { return _mm512_maskz_max_epu64(AllLanes, a, b); }
+
+	static inline Reg loadPadded(const uint64_t* data, size_t count) {
+		return _mm512_mask_loadu_epi64(set1(~0ULL), (__mmask8) ((1U << count) - 1), data);
+	}
+
+	static inline void storePartial(uint64_t* data, Reg keys, size_t count) {
+		_mm512_mask_storeu_epi64(data, (__mmask8) ((1U << count) - 1), keys);
+	}
+
+	static inline Reg arrange(Reg keys, Reg pivots, size_t& count) {
+		__mmask8 lower = _mm512_cmple_epu64_mask(keys, pivots);
+		count = __builtin_popcount(lower);
+		Reg packed = _mm512_maskz_compress_epi64(lower, keys);
+		Reg rest = _mm512_maskz_compress_epi64((__mmask8) ~lower, keys);
+		return _mm512_mask_expand_epi64(packed, (__mmask8) (0xFFU << count), rest);
+	}
+
+	//Lane permutation, lane 0 first
+	static inline Reg lanes(long long l0, long long l1, long long l2, long long l3,
+		long long l4, long long l5, long long l6, long long l7) {
+		return _mm512_set_epi64(l7, l6, l5, l4, l3, l2, l1, l0);
+	}
+
+	//Compare-exchange each lane with its partner; lanes in upper keep the larger key
+	static inline Reg exchange(Reg keys, Reg partners, __mmask8 upper) {
+		Reg other = _mm512_maskz_permutexvar_epi64(AllLanes, partners, keys);
+		return _mm512_mask_mov_epi64(min(keys, other), upper, max(keys, other));
+	}
+
+	static inline Reg reverse(Reg keys) {
+		return _mm512_maskz_permutexvar_epi64(AllLanes, lanes(7, 6, 5, 4, 3, 2, 1, 0), keys);
+	}
+
+	static inline Reg merge(Reg keys) {
+		keys = exchange(keys, lanes(4, 5, 6, 7, 0, 1, 2, 3), 0xF0);
+		keys = exchange(keys, lanes(2, 3, 0, 1, 6, 7, 4, 5), 0xCC);
+		return exchange(keys, lanes(1, 0, 3, 2, 5, 4, 7, 6), 0xAA);
+	}
+
+	static inline Reg sort(Reg keys) {
+		keys = exchange(keys, lanes(1, 0, 3, 2, 5, 4, 7, 6), 0xAA);
+		keys = exchange(keys, lanes(3, 2, 1, 0, 7, 6, 5, 4), 0xCC);
+		keys = exchange(keys, lanes(1, 0, 3, 2, 5, 4, 7, 6), 0xAA);
+		keys = exchange(keys, lanes(7, 6, 5, 4, 3, 2, 1, 0), 0xF0);
+		keys = exchange(keys, lanes(2, 3, 0, 1, 6, 7, 4, 5), 0xCC);
+		return exchange(keys, lanes(1, 0, 3, 2, 5, 4, 7, 6), 0xAA);
+	}
+};
+
+}; //End anonymous namespace
+
+/**	@brief	Vectorized quicksort using AVX-512F/VL; only call if the CPU supports it
+ *	@param	data		Keys to sort in place
+ *	@param	length	Number of keys
+ */
+void avx512Sort(uint64_t* data, size_t length) {
+	VectorQuickSort<Avx512Ops>::sort(data, length);
+}
+
+}; //End namespace
@@ -0,0 +1,291 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SIMDKERNEL_INCLUDED
+#define _SIMDKERNEL_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+
+namespace JAC::Integer {
+
+/**	@brief	Scalar pattern-defeating quicksort
+ *	Used where no vector unit is available, and by the vector kernels when
+ *	their pivots keep going bad.
+ *	@param	data		Keys to sort in place
+ *	@param	length	Number of keys
+ */
+void pdqSort(uint64_t* data, size_t length);
+
+/**	@brief	Vectorized quicksort using AVX2; only call if the CPU supports it
+ *	@param	data		Keys to sort in place
+ *	@param	length	Number of keys
+ */
+void avx2Sort(uint64_t* data, size_t length);
+
+/**	@brief	Vectorized quicksort using AVX-512F/VL; only call if the CPU supports it
+ *	@param	data		Keys to sort in place
+ *	@param	length	Number of keys
+ */
+void avx512Sort(uint64_t* data, size_t length);
+
+//The kernel is instantiated once per instruction set, each in a translation
+//unit built for that instruction set. It has internal linkage and calls
+//nothing from the standard library, so no code built for a wider vector unit
+//can be merged into code that runs on every host.
+namespace {
+
+/**	@brief	In-place vectorized quicksort over an instruction set
+ *	Ops supplies a vector register type holding Ops::Lanes keys and the
+ *	primitives below:
+ *		load/store/loadPadded/storePartial	Full and partial memory access;
+ *			padded lanes hold the largest key so they sort to the end
+ *		set1/min/max												Broadcast and unsigned lane-wise min/max
+ *		arrange(v, pivot, count)						Permutes keys <= pivot to the low lanes,
+ *			in order, and the rest to the high lanes; count receives the number
+ *			of keys <= pivot
+ *		sort/merge/reverse									Sort a register, sort a bitonic
+ *			register, reverse a register
+ *
+ *	Each partition step reads a register from whichever end of the unread
+ *	range has less free space behind it and stores the arranged register at
+ *	both write fronts, so every store is a full, unmasked register. Ranges of
+ *	up to NetworkRegs registers are sorted by a bitonic network in registers.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+template<typename Ops>
+class VectorQuickSort {
+public:
+	typedef typename Ops::Reg	Reg_t;
+
+	//Keys per register
+	static constexpr size_t Lanes = Ops::Lanes;
+
+	//Registers in the largest sorting network
+	static constexpr size_t NetworkRegs = 8;
+
+	//Ranges of at most this many keys are sorted by the network
+	static constexpr size_t NetworkKeys = NetworkRegs * Lanes;
+
+public:
+	/**	@brief	Sorts keys in place
+	 *	@param	data		Keys to sort
+	 *	@param	length	Number of keys
+	 */
+	static void sort(uint64_t* data, size_t length) {
+		unsigned depth = 0;
+		for(size_t size = length; size > 1; size >>= 1) depth += 2;
+		quickSort(data, length, depth);
+	}
+
+private:
+	/**	@brief	Sorts a range, falling back to pdqSort() once depth runs out */
+	static void quickSort(uint64_t* data, size_t length, unsigned depth) {
+		while(length > NetworkKeys) {
+			if(depth-- == 0) {
+				pdqSort(data, length);
+				return;
+			}
+
+			uint64_t lo, hi;
+			size_t split = partition(data, length, choosePivot(data, length), lo, hi);
+			if(lo == hi)
+				return;
+
+			//The pivot was the largest key; split off the keys equal to it,
+			//which are then already in place
+			if(split == length) {
+				length = partition(data, length, hi - 1, lo, hi);
+				continue;
+			}
+
+			//Recurse into the smaller side, loop on the larger
+			if(split < length - split) {
+				quickSort(data, split, depth);
+				data += split;
+				length -= split;
+			}
+			else {
+				quickSort(data + split, length - split, depth);
+				length = split;
+			}
+		}
+		networkSort(data, length);
+	}
+
+	/**	@brief	Median of nine evenly spaced keys */
+	static uint64_t choosePivot(const uint64_t* data, size_t length) {
+		uint64_t sample[9];
+		for(size_t idx = 0; idx < 9; idx++) {
+			uint64_t key = data[length / 9 * idx + length / 18];
+			size_t pos = idx;
+			while(pos > 0 && sample[pos-1] > key) {
+				sample[pos] = sample[pos-1];
+				pos--;
+			}
+			sample[pos] = key;
+		}
+		return sample[4];
+	}
+
+	/**	@brief	Partitions a range of at least two registers around a pivot
+	 *	@param	data		The range
+	 *	@param	length	Number of keys
+	 *	@param	pivot		Keys <= pivot go first
+	 *	@param	lo			Receives the smallest key in the range
+	 *	@param	hi			Receives the largest key in the range
+	 *	@return	Number of keys <= pivot
+	 */
+	static size_t partition(uint64_t* data, size_t length, uint64_t pivot,
+		uint64_t& lo, uint64_t& hi) {
+		const Reg_t pivots = Ops::set1(pivot);
+		Reg_t minKeys = Ops::set1(~0ULL);
+		Reg_t maxKeys = Ops::set1(0);
+		size_t count;
+
+		//Hold one register from each end, leaving a register of space at both
+		const Reg_t first = Ops::load(data);
+		const Reg_t last = Ops::load(data + length - Lanes);
+		size_t readLeft = Lanes, readRight = length - Lanes;
+		size_t writeLeft = 0, writeRight = length;
+
+		while(readRight - readLeft >= Lanes) {
+			Reg_t keys;
+			if(readLeft - writeLeft <= writeRight - readRight) {
+				keys = Ops::load(data + readLeft);
+				readLeft += Lanes;
+			}
+			else {
+				readRight -= Lanes;
+				keys = Ops::load(data + readRight);
+			}
+			minKeys = Ops::min(minKeys, keys);
+			maxKeys = Ops::max(maxKeys, keys);
+
+			Reg_t arranged = Ops::arrange(keys, pivots, count);
+			Ops::store(data + writeLeft, arranged);
+			Ops::store(data + writeRight - Lanes, arranged);
+			writeLeft += count;
+			writeRight -= Lanes - count;
+		}
+
+		//Fewer than a register of keys remain unread; place them one by one
+		uint64_t tail[Lanes];
+		size_t tailKeys = readRight - readLeft;
+		for(size_t idx = 0; idx < tailKeys; idx++)
+			tail[idx] = data[readLeft + idx];
+		for(size_t idx = 0; idx < tailKeys; idx++) {
+			uint64_t key = tail[idx];
+			lo = (idx == 0 || key < lo) ? key : lo;
+			hi = (idx == 0 || key > hi) ? key : hi;
+			if(key <= pivot) data[writeLeft++] = key;
+			else data[--writeRight] = key;
+		}
+
+		//Then the held registers; the two stores of the last one coincide
+		minKeys = Ops::min(minKeys, Ops::min(first, last));
+		maxKeys = Ops::max(maxKeys, Ops::max(first, last));
+		Reg_t arranged = Ops::arrange(first, pivots, count);
+		Ops::store(data + writeLeft, arranged);
+		Ops::store(data + writeRight - Lanes, arranged);
+		writeLeft += count;
+		writeRight -= Lanes - count;
+		arranged = Ops::arrange(last, pivots, count);
+		Ops::store(data + writeLeft, arranged);
+		Ops::store(data + writeRight - Lanes, arranged);
+		writeLeft += count;
+
+		uint64_t lanes[Lanes];
+		Ops::store(lanes, minKeys);
+		if(tailKeys == 0) lo = lanes[0];
+		for(size_t idx = 0; idx < Lanes; idx++) lo = (lanes[idx] < lo) ? lanes[idx] : lo;
+		Ops::store(lanes, maxKeys);
+		if(tailKeys == 0) hi = lanes[0];
+		for(size_t idx = 0; idx < Lanes; idx++) hi = (lanes[idx] > hi) ? lanes[idx] : hi;
+		return writeLeft;
+	}
+
+	/**	@brief	Sorts up to NetworkKeys keys with the smallest network that fits */
+	static void networkSort(uint64_t* data, size_t length) {
+		if(length <= 1) return;
+		if(length <= Lanes) network<1>(data, length);
+		else if(length <= 2 * Lanes) network<2>(data, length);
+		else if(length <= 4 * Lanes) network<4>(data, length);
+		else network<8>(data, length);
+	}
+
+	/**	@brief	Bitonic sorting network over Regs registers
+	 *	Each register is sorted, then sorted blocks of registers are merged
+	 *	pairwise: the second block is reversed so the pair forms a bitonic
+	 *	sequence, a compare-exchange splits it into two bitonic halves, and the
+	 *	halves are cleaned across registers and then within each register.
+	 */
+	template<size_t Regs>
+	static void network(uint64_t* data, size_t length) {
+		Reg_t regs[Regs];
+		for(size_t reg = 0; reg < Regs; reg++) {
+			size_t begin = reg * Lanes;
+			if(begin + Lanes <= length) regs[reg] = Ops::load(data + begin);
+			else if(begin < length) regs[reg] = Ops::loadPadded(data + begin, length - begin);
+			else regs[reg] = Ops::set1(~0ULL);
+			regs[reg] = Ops::sort(regs[reg]);
+		}
+
+		for(size_t width = 1; width < Regs; width *= 2) {
+			for(size_t block = 0; block < Regs; block += 2 * width) {
+				Reg_t* lower = regs + block;
+				Reg_t* upper = regs + block + width;
+				for(size_t idx = 0; idx < width / 2 + width % 2; idx++) {
+					size_t mirror = width - 1 - idx;
+					Reg_t a = lower[idx], b = Ops::reverse(upper[mirror]);
+					Reg_t c = lower[mirror], d = Ops::reverse(upper[idx]);
+					lower[idx] = Ops::min(a, b);
+					upper[idx] = Ops::max(a, b);
+					if(mirror != idx) {
+						lower[mirror] = Ops::min(c, d);
+						upper[mirror] = Ops::max(c, d);
+					}
+				}
+				for(size_t distance = width / 2; distance > 0; distance /= 2) {
+					for(size_t idx = 0; idx < 2 * width; idx++) {
+						if(idx % (2 * distance) >= distance) continue;
+						Reg_t a = regs[block + idx], b = regs[block + idx + distance];
+						regs[block + idx] = Ops::min(a, b);
+						regs[block + idx + distance] = Ops::max(a, b);
+					}
+				}
+				for(size_t idx = 0; idx < 2 * width; idx++)
+					regs[block + idx] = Ops::merge(regs[block + idx]);
+			}
+		}
+
+		for(size_t reg = 0; reg < Regs; reg++) {
+			size_t begin = reg * Lanes;
+			if(begin + Lanes <= length) Ops::store(data + begin, regs[reg]);
+			else if(begin < length) Ops::storePartial(data + begin, regs[reg], length - begin);
+		}
+	}
+};
+
+}; //End anonymous namespace
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,354 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+//Project includes
+#include "simdsort.h"
+#include "simdkernel.h"
+
+/**	@brief	Create instance of the vectorized quicksort class from shared object
+ *	@return	A new instance of SimdSort as Sorter*
+ */
+extern "C" JAC::Integer::SortAlgorithm* create() {
+	return new JAC::Integer::SimdSort();
+}
+
+/**	@brief	Deletes the specified instance of a SimdSort, allocated by this module
+ *	@param	val	Pointer to a SimdSort that was allocated by this module's
+ * 							CreateInstance() function
+ */
+extern "C" void destroy(JAC::Integer::SortAlgorithm*& obj) {
+	if(obj != nullptr) delete obj;
+	obj = nullptr;
+}
+
+/**	@brief	Describes the vectorized quicksort for algorithm selection
+ *	@return	The capability descriptor, valid while this module is loaded
+ */
+extern "C" const JAC::Integer::SortCapabilities* capabilities() {
+	static const JAC::Integer::SortCapabilities caps = {
+		JAC::Integer::CapabilitiesVersion,
+		false,	//Stable
+		true,	//In place
+		false,	//Parallel
+		0.0,	//Extra bytes per key
+		JAC::Integer::KeyWidth64,	//Key widths
+		0,	//Min keys
+		0,	//Max keys
+		"Vectorized quicksort (AVX-512 or AVX2, scalar pdqsort otherwise)"
+	};
+	return &caps;
+}
+
+namespace JAC::Integer {
+
+//Ranges below this size are insertion sorted
+static const size_t InsertionSortKeys = 24;
+
+//Ranges above this size take the pivot from a ninther
+static const size_t NintherKeys = 128;
+
+//Elements partialInsertionSort() may move before giving up
+static const size_t PartialInsertionLimit = 8;
+
+/**	@brief	Insertion sort */
+static inline void insertionSort(uint64_t* begin, uint64_t* end) {
+	if(begin == end) return;
+	for(uint64_t* cur = begin + 1; cur != end; cur++) {
+		uint64_t key = *cur;
+		uint64_t* sift = cur;
+		while(sift != begin && key < sift[-1]) {
+			*sift = sift[-1];
+			sift--;
+		}
+		*sift = key;
+	}
+}
+
+/**	@brief	Insertion sort of a range preceded by a key no larger than any in it */
+static inline void unguardedInsertionSort(uint64_t* begin, uint64_t* end) {
+	for(uint64_t* cur = begin + 1; cur < end; cur++) {
+		uint64_t key = *cur;
+		uint64_t* sift = cur;
+		while(key < sift[-1]) {
+			*sift = sift[-1];
+			sift--;
+		}
+		*sift = key;
+	}
+}
+
+/**	@brief	Insertion sort that gives up once it has moved too many keys
+ *	@return	True if the range was sorted
+ */
+static bool partialInsertionSort(uint64_t* begin, uint64_t* end) {
+	if(begin == end) return true;
+	size_t moved = 0;
+	for(uint64_t* cur = begin + 1; cur != end; cur++) {
+		if(moved > PartialInsertionLimit) return false;
+		uint64_t key = *cur;
+		uint64_t* sift = cur;
+		while(sift != begin && key < sift[-1]) {
+			*sift = sift[-1];
+			sift--;
+		}
+		*sift = key;
+		moved += cur - sift;
+	}
+	return true;
+}
+
+/**	@brief	Orders three keys in place */
+static inline void sort3(uint64_t* a, uint64_t* b, uint64_t* c) {
+	if(*b < *a) std::swap(*a, *b);
+	if(*c < *b) std::swap(*b, *c);
+	if(*b < *a) std::swap(*a, *b);
+}
+
+/**	@brief	Partitions around *begin, keys equal to the pivot going right
+ *	@return	The pivot's final position, and whether the range was already partitioned
+ */
+static std::pair<uint64_t*, bool> partitionRight(uint64_t* begin, uint64_t* end) {
+	uint64_t pivot = *begin;
+	uint64_t* first = begin;
+	uint64_t* last = end;
+
+	//The median of three guarantees a key >= pivot on the right
+	while(*++first < pivot);
+	if(first - 1 == begin) {
+		while(first < last && !(*--last < pivot));
+	}
+	else {
+		while(!(*--last < pivot));
+	}
+
+	bool partitioned = first >= last;
+	while(first < last) {
+		std::swap(*first, *last);
+		while(*++first < pivot);
+		while(!(*--last < pivot));
+	}
+
+	uint64_t* pivotPos = first - 1;
+	*begin = *pivotPos;
+	*pivotPos = pivot;
+	return { pivotPos, partitioned };
+}
+
+/**	@brief	Partitions around *begin, keys equal to the pivot going left
+ *	Used when the pivot equals the key before the range, so every key equal
+ *	to it is already in its final place.
+ *	@return	The pivot's final position
+ */
+static uint64_t* partitionLeft(uint64_t* begin, uint64_t* end) {
+	uint64_t pivot = *begin;
+	uint64_t* first = begin;
+	uint64_t* last = end;
+
+	while(pivot < *--last);
+	if(last + 1 == end) {
+		while(first < last && !(pivot < *++first));
+	}
+	else {
+		while(!(pivot < *++first));
+	}
+
+	while(first < last) {
+		std::swap(*first, *last);
+		while(pivot < *--last);
+		while(!(pivot < *++first));
+	}
+
+	*begin = *last;
+	*last = pivot;
+	return last;
+}
+
+/**	@brief	Pattern-defeating quicksort main loop
+ *	@param	begin				First key
+ *	@param	end					One past the last key
+ *	@param	badAllowed	Unbalanced partitions allowed before switching to heapsort
+ *	@param	leftmost		False if the key before begin is no larger than any in the range
+ */
+static void pdqLoop(uint64_t* begin, uint64_t* end, int badAllowed, bool leftmost) {
+	while(true) {
+		size_t size = end - begin;
+		if(size < InsertionSortKeys) {
+			if(leftmost) insertionSort(begin, end);
+			else unguardedInsertionSort(begin, end);
+			return;
+		}
+
+		//Pivot to the front from a median of three, or a ninther
+		size_t half = size / 2;
+		if(size > NintherKeys) {
+			sort3(begin, begin + half, end - 1);
+			sort3(begin + 1, begin + (half - 1), end - 2);
+			sort3(begin + 2, begin + (half + 1), end - 3);
+			sort3(begin + (half - 1), begin + half, begin + (half + 1));
+			std::swap(*begin, begin[half]);
+		}
+		else {
+			sort3(begin + half, begin, end - 1);
+		}
+
+		//A pivot equal to the key before the range: put every equal key in place
+		if(!leftmost && !(begin[-1] < *begin)) {
+			begin = partitionLeft(begin, end) + 1;
+			continue;
+		}
+
+		std::pair<uint64_t*, bool> split = partitionRight(begin, end);
+		uint64_t* pivotPos = split.first;
+		size_t leftSize = pivotPos - begin;
+		size_t rightSize = end - (pivotPos + 1);
+
+		if(leftSize < size / 8 || rightSize < size / 8) {
+			//Too many bad pivots: fall back to guaranteed O(n log n)
+			if(--badAllowed == 0) {
+				std::make_heap(begin, end);
+				std::sort_heap(begin, end);
+				return;
+			}
+
+			//Break up patterns that defeat the pivot choice
+			if(leftSize >= InsertionSortKeys) {
+				std::swap(begin[0], begin[leftSize / 4]);
+				std::swap(pivotPos[-1], pivotPos[-(ptrdiff_t) (leftSize / 4)]);
+				if(leftSize > NintherKeys) {
+					std::swap(begin[1], begin[leftSize / 4 + 1]);
+					std::swap(begin[2], begin[leftSize / 4 + 2]);
+					std::swap(pivotPos[-2], pivotPos[-(ptrdiff_t) (leftSize / 4 + 1)]);
+					std::swap(pivotPos[-3], pivotPos[-(ptrdiff_t) (leftSize / 4 + 2)]);
+				}
+			}
+			if(rightSize >= InsertionSortKeys) {
+				std::swap(pivotPos[1], pivotPos[1 + rightSize / 4]);
+				std::swap(end[-1], end[-(ptrdiff_t) (rightSize / 4)]);
+				if(rightSize > NintherKeys) {
+					std::swap(pivotPos[2], pivotPos[2 + rightSize / 4]);
+					std::swap(pivotPos[3], pivotPos[3 + rightSize / 4]);
+					std::swap(end[-2], end[-(ptrdiff_t) (1 + rightSize / 4)]);
+					std::swap(end[-3], end[-(ptrdiff_t) (2 + rightSize / 4)]);
+				}
+			}
+		}
+		else if(split.second && partialInsertionSort(begin, pivotPos) &&
+			partialInsertionSort(pivotPos + 1, end)) {
+			//Already partitioned and both sides close to sorted
+			return;
+		}
+
+		pdqLoop(begin, pivotPos, badAllowed, leftmost);
+		begin = pivotPos + 1;
+		leftmost = false;
+	}
+}
+
+/**	@brief	Scalar pattern-defeating quicksort
+ *	@param	data		Keys to sort in place
+ *	@param	length	Number of keys
+ */
+void pdqSort(uint64_t* data, size_t length) {
+	int badAllowed = 1;
+	for(size_t size = length; size > 1; size >>= 1) badAllowed++;
+	pdqLoop(data, data + length, badAllowed, true);
+}
+
+/**	@brief	Default constructor, selects the best supported instruction set */
+SimdSort::SimdSort() :
+	isa_(detectIsa()) {
+}
+
+/**	@brief	Destructor */
+SimdSort::~SimdSort() {
+}
+
+/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void SimdSort::sort(uint64_t* keys, size_t count) {
+	switch(isa_) {
+#ifdef ISORT_SIMD_X86
+		case VectorIsa::Avx512:
+			avx512Sort(keys, count);
+			break;
+		case VectorIsa::Avx2:
+			avx2Sort(keys, count);
+			break;
+#endif
+		default:
+			pdqSort(keys, count);
+			break;
+	}
+}
+
+/**	@brief	Sets a vectorized quicksort option
+ *	@param	name	The option name
+ *	@param	value	The option value as text
+ *	@return	True if the option is recognized, otherwise false
+ *	@throws	std::invalid_argument	On an unknown or unsupported instruction set
+ */
+bool SimdSort::setOption(const std::string& name, const std::string& value) {
+	if(name != "isa")
+		return false;
+
+	VectorIsa best = detectIsa();
+	if(value == "auto") {
+		isa_ = best;
+		return true;
+	}
+	for(VectorIsa isa : { VectorIsa::Scalar, VectorIsa::Avx2, VectorIsa::Avx512 }) {
+		if(value != isaName(isa)) continue;
+		if(isa > best)
+			throw std::invalid_argument(value + " is not supported on this CPU (best: " +
+				isaName(best) + ")");
+		isa_ = isa;
+		return true;
+	}
+	throw std::invalid_argument("Unknown isa: " + value + " (expected auto, avx512, avx2 or scalar)");
+}
+
+/**	@brief	The widest instruction set supported by this CPU and build */
+VectorIsa SimdSort::detectIsa() {
+#ifdef ISORT_SIMD_X86
+	//Also checks that the OS saves the vector state
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+		return VectorIsa::Avx512;
+	if(__builtin_cpu_supports("avx2"))
+		return VectorIsa::Avx2;
+#endif
+	return VectorIsa::Scalar;
+}
+
+/**	@brief	Name of an instruction set, as accepted by the isa option */
+const char* SimdSort::isaName(VectorIsa isa) {
+	switch(isa) {
+		case VectorIsa::Avx512:	return "avx512";
+		case VectorIsa::Avx2:		return "avx2";
+		default:								return "scalar";
+	}
+}
+
+}; //End namespace
@@ -0,0 +1,94 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SIMDSORT_INCLUDED
+#define _SIMDSORT_INCLUDED
+//System includes
+//Library includes
+#include <string>
+//Project includes
+#include "sortalgorithm.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Vector instruction sets the vectorized quicksort can use */
+enum class VectorIsa {
+	Scalar,		/*! No vector unit; pattern-defeating quicksort */
+	Avx2,			/*! AVX2, four keys per register */
+	Avx512		/*! AVX-512F/VL, eight keys per register */
+};
+
+/**	@brief	Vectorized quicksort implementation for sorting library
+ *	Partitions with full-width vector compares and permutes, writing every
+ *	register with unmasked stores, and sorts small partitions with bitonic
+ *	networks held entirely in registers. The widest instruction set the
+ *	CPU supports is detected at run time, so one module runs on every host;
+ *	without AVX2 it sorts with a scalar pattern-defeating quicksort.
+ *	Comparison based, so unlike LSD radix its cost does not grow with the
+ *	width of the keys.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class SimdSort : public SortAlgorithm {
+private:
+	//The sort type string
+	std::string 			type_ = "simdsort";
+
+	//Instruction set in use
+	VectorIsa					isa_;
+
+public:
+	/**	@brief	Default constructor, selects the best supported instruction set */
+	SimdSort();
+
+	/**	@brief	Destructor */
+	virtual ~SimdSort();
+
+	using SortAlgorithm::sort;
+
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	void sort(uint64_t* keys, size_t count) override;
+
+	/**	@brief	Sets a vectorized quicksort option
+	 *	Recognized options:
+	 *		isa		Instruction set: auto (default), avx512, avx2 or scalar
+	 *	@param	name	The option name
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized, otherwise false
+	 *	@throws	std::invalid_argument	On an unknown or unsupported instruction set
+	 */
+	bool setOption(const std::string& name, const std::string& value) override;
+
+	/**	@brief	The instruction set in use */
+	inline VectorIsa isa() const { return isa_; }
+
+	/**	@brief	The widest instruction set supported by this CPU and build */
+	static VectorIsa detectIsa();
+
+	/**	@brief	Name of an instruction set, as accepted by the isa option */
+	static const char* isaName(VectorIsa isa);
+};
+
+SimdSort __simdsort_instance;
+
+}; //End namespace
+
+#endif //Include once
@@ -18,14 +18,36 @@
  */
 //System includes
 #include <dlfcn.h>
+#include <dirent.h>
 //Library includes
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
 //Project includes
 #include "sortalgorithm.h"
+#include "threadpool.h"
+#include "segments.h"
+#include "pairsort.h"
+#include "select.h"
+#include "unique.h"
 
 namespace JAC::Integer {
 
 //Static init
 SortAlgorithm::AlgoFunctionMap_t SortAlgorithm::functionMap_;
+std::mutex SortAlgorithm::mutex_;
+std::string SortAlgorithm::pluginDir_;
+
+/**	@brief	Returns the directory holding this library */
+static std::string libraryDirectory() {
+	Dl_info info;
+	if(::dladdr((void*) &libraryDirectory, &info) != 0 && info.dli_fname != nullptr) {
+		std::string path(info.dli_fname);
+		size_t slash = path.rfind('/');
+		if(slash != std::string::npos) return path.substr(0, slash);
+	}
+	return ".";
+}
 
 /**	@brief	Creates an instance of the sort object with the specified name
  *	@param	name	The well-known name of the sorter to create (ie: radix)
@@ -49,34 +71,293 @@ void SortAlgorithm::destroy(SortAlgorithm*& obj) {
 	(*functions.destroy_)(obj);
 }
 
+/**	@brief	Returns the capability descriptor of an algorithm, loading it if needed
+ *	@param	name	The well-known algorithm name
+ *	@return	The descriptor, or nullptr if the plugin does not export one
+ *	@throws	std::runtime_error	If the plugin cannot be loaded
+ */
+const SortCapabilities* SortAlgorithm::capabilities(const std::string& name) {
+	LibFunctions functions = SortAlgorithm::instanceApiFor(name);
+	if(functions.capabilities_ == nullptr) return nullptr;
+
+	//Ignore descriptors laid out for a different version of this header
+	const SortCapabilities* caps = (*functions.capabilities_)();
+	return (caps != nullptr && caps->version == CapabilitiesVersion) ? caps : nullptr;
+}
+
+/**	@brief	Loads every plugin in a directory and searches it first from now on
+ *	@param	dir	The plugin directory
+ *	@return	The number of plugins registered from the directory
+ */
+size_t SortAlgorithm::loadPlugins(const std::string& dir) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	pluginDir_ = dir;
+
+	DIR* handle = ::opendir(dir.c_str());
+	if(handle == nullptr) return 0;
+
+	//Collect candidates first; dlopen() may run arbitrary constructors
+	const std::string prefix = LIBPREFIX, suffix = LIBSUFFIX;
+	std::vector<std::string> names;
+	while(struct dirent* entry = ::readdir(handle)) {
+		std::string file(entry->d_name);
+		if(file.size() > prefix.size() + suffix.size() &&
+			file.compare(0, prefix.size(), prefix) == 0 &&
+			file.compare(file.size() - suffix.size(), suffix.size(), suffix) == 0)
+			names.push_back(file.substr(prefix.size(), file.size() - prefix.size() - suffix.size()));
+	}
+	::closedir(handle);
+
+	size_t loaded = 0;
+	for(const std::string& name : names) {
+		if(functionMap_.count(name) > 0) {
+			loaded++;
+			continue;
+		}
+		LibFunctions functions;
+		if(openLibrary(dir + "/" + prefix + name + suffix, functions)) {
+			functionMap_.insert(AlgoFunctionMapPair_t(name, functions));
+			loaded++;
+		}
+	}
+	return loaded;
+}
+
+/**	@brief	Returns the names of all loaded plugins, in order */
+std::vector<std::string> SortAlgorithm::algorithms() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::vector<std::string> names;
+	for(const AlgoFunctionMap_t::value_type& entry : functionMap_)
+		names.push_back(entry.first);
+	return names;
+}
+
+/**	@brief	Returns the directory searched first for plugins
+ *	This is the directory last passed to loadPlugins(), otherwise the
+ *	directory holding the sort library itself, where the plugins are built
+ *	and installed.
+ */
+std::string SortAlgorithm::pluginDirectory() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pluginDir_.empty() ? libraryDirectory() : pluginDir_;
+}
+
+/**	@brief	Returns the process-wide executor shared by all plugins */
+ThreadPool& SortAlgorithm::executor() {
+	return ThreadPool::shared();
+}
+
+/** @brief	Sorts keys in place within per-call thread and CPU limits
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ *	@param	options	Limits for this call
+ */
+void SortAlgorithm::sort(uint64_t* keys, size_t count, const SortOptions& options) {
+	ConcurrencyScope scope(options.threads, options.cpus);
+	sort(keys, count);
+}
+
+/** @brief	Sorts 32-bit keys in place within per-call thread and CPU limits
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ *	@param	options	Limits for this call
+ */
+void SortAlgorithm::sort(uint32_t* keys, size_t count, const SortOptions& options) {
+	ConcurrencyScope scope(options.threads, options.cpus);
+	sort(keys, count);
+}
+
+/** @brief	In-place sort of unsigned 32-bit keys
+ *	@param	keys		First key
+ *	@param	count		Number of keys
+ */
+void SortAlgorithm::sort(uint32_t* keys, size_t count) {
+	IntVector_t wide(keys, keys + count);
+	sort(wide.data(), count);
+	std::copy(wide.begin(), wide.end(), keys);
+}
+
+/** @brief	Sorts a vector in place within per-call thread and CPU limits
+ *	@param	arr			A std::vector<uint64_t> of values to be sorted
+ *	@param	options	Limits for this call
+ *	@return	arr, now in sorted order
+ */
+SortAlgorithm::IntVector_t& SortAlgorithm::sort(IntVector_t& arr, const SortOptions& options) {
+	ConcurrencyScope scope(options.threads, options.cpus);
+	return sort(arr);
+}
+
+/**	@brief	Sorts many independent segments of one flat buffer in place
+ *	@param	keys			The flat buffer of keys
+ *	@param	offsets		Segment boundaries, segments+1 non-decreasing entries
+ *	@param	segments	Number of segments
+ */
+void SortAlgorithm::sortSegments(uint64_t* keys, const uint64_t* offsets, size_t segments) {
+	segmentedSort(keys, offsets, segments);
+}
+
+/**	@brief	Stable sort of keys, moving a payload array with them
+ *	@param	keys		Keys to sort
+ *	@param	values	Payloads (ie: record IDs), one per key
+ *	@param	count		Number of keys
+ */
+void SortAlgorithm::sortPairs(uint64_t* keys, uint64_t* values, size_t count) {
+	ScratchArena scratch(0);
+	radixSortPairs(RadixEngine(), scratch, keys, values, count, PairLayout::Split);
+}
+
+/**	@brief	Stable sort of packed key/value records by key
+ *	@param	records	Records to sort
+ *	@param	count		Number of records
+ */
+void SortAlgorithm::sortRecords(KeyValue* records, size_t count) {
+	ScratchArena scratch(0);
+	radixSortRecords(RadixEngine(), scratch, records, count);
+}
+
+/**	@brief	Stable argsort with 32-bit indices
+ *	@param	keys		Keys to order
+ *	@param	count		Number of keys, at most UINT32_MAX
+ *	@param	indices	Receives count indices
+ *	@throws	std::invalid_argument	If count does not fit in 32 bits
+ */
+void SortAlgorithm::argsort(const uint64_t* keys, size_t count, uint32_t* indices) {
+	ScratchArena scratch(0);
+	radixArgsort(RadixEngine(), scratch, keys, count, indices);
+}
+
+/**	@brief	Stable argsort with 64-bit indices
+ *	@param	keys		Keys to order
+ *	@param	count		Number of keys
+ *	@param	indices	Receives count indices
+ */
+void SortAlgorithm::argsort(const uint64_t* keys, size_t count, uint64_t* indices) {
+	ScratchArena scratch(0);
+	radixArgsort(RadixEngine(), scratch, keys, count, indices, PairLayout::Split);
+}
+
+/**	@brief	Copies the k smallest keys in ascending order
+ *	@param	keys		The keys; not modified
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted
+ *	@param	out			Receives min(k, count) keys
+ *	@return	The number of keys written
+ */
+size_t SortAlgorithm::partialSort(const uint64_t* keys, size_t count, size_t k, uint64_t* out) {
+	k = selectSmallest(keys, count, k, out);
+	sort(out, k);
+	return k;
+}
+
+/**	@brief	Copies the k largest keys in descending order
+ *	@param	keys		The keys; not modified
+ *	@param	count		Number of keys
+ *	@param	k				Number of keys wanted
+ *	@param	out			Receives min(k, count) keys
+ *	@return	The number of keys written
+ */
+size_t SortAlgorithm::topK(const uint64_t* keys, size_t count, size_t k, uint64_t* out) {
+	k = selectLargest(keys, count, k, out);
+	sort(out, k);
+	std::reverse(out, out + k);
+	return k;
+}
+
+/**	@brief	Returns the key at a rank without sorting
+ *	@param	keys		The keys; not modified
+ *	@param	count		Number of keys
+ *	@param	rank		Rank counting from 0, so 0 is the smallest key
+ *	@return	The key that would be at position rank once sorted
+ *	@throws	std::out_of_range	If rank is not less than count
+ */
+uint64_t SortAlgorithm::nthElement(const uint64_t* keys, size_t count, size_t rank) {
+	return selectRank(keys, count, rank);
+}
+
+/**	@brief	Sorts keys in place and keeps one copy of each
+ *	@param	keys		Keys to sort; the distinct keys are left at the front
+ *	@param	count		Number of keys
+ *	@return	The number of distinct keys
+ */
+size_t SortAlgorithm::sortUnique(uint64_t* keys, size_t count) {
+	sort(keys, count);
+	return collapseRuns(keys, count, nullptr);
+}
+
+/**	@brief	Sorts keys in place, keeping one copy of each with its count
+ *	@param	keys		Keys to sort; the distinct keys are left at the front
+ *	@param	count		Number of keys
+ *	@param	counts	Receives the occurrences of each distinct key; at least
+ *									count elements
+ *	@return	The number of distinct keys
+ */
+size_t SortAlgorithm::sortCounted(uint64_t* keys, size_t count, uint64_t* counts) {
+	sort(keys, count);
+	return collapseRuns(keys, count, counts);
+}
 
 /**	@brief	Returns create/destroy functions for the appropriate sort algorithm
  *	@param	val	The well-known algorithm name
  *	@return	A std::pair instance creating create/destroy functions for the algo library
  */
 LibFunctions SortAlgorithm::instanceApiFor(const std::string& name) {
-	LibFunctions functions;
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	//Loaded already?
+	AlgoFunctionMap_t::const_iterator itr = functionMap_.find(name);
+	if(itr != functionMap_.end())
+		return itr->second;
 
 	//Create a library name from the sorter simple name
 	std::string libname = std::string(LIBPREFIX)+name+LIBSUFFIX;
 
-	//Load library and get pointers to export functions
-	void* handle = ::dlopen(libname.c_str(), RTLD_NOW);
+	//Plugin directory first, then the loader's search path
+	std::string dir = pluginDir_.empty() ? libraryDirectory() : pluginDir_;
+	LibFunctions functions;
+	if(!openLibrary(dir + "/" + libname, functions) && !openLibrary(libname, functions)) {
+		const char* error = ::dlerror();
+		throw std::runtime_error("Unable to load algorithm '" + name + "' from " + libname +
+			((error != nullptr) ? std::string(": ") + error : std::string()));
+	}
 
-	//handle = dlopen("/lib/libchm.so.1.0.0", RTLD_NOW);
-	//TODO: valid handle to loaded shared object
-	if(handle == 0)
-		throw std::exception();
+	functionMap_.insert(AlgoFunctionMapPair_t(name, functions));
+	return functions;
+}
+
+/**	@brief	Opens a plugin module and resolves its exports
+ *	@param	path	Path or file name passed to dlopen()
+ *	@param	functions	Receives the exports and handle
+ *	@return	False if the module cannot be opened or is not a plugin
+ */
+bool SortAlgorithm::openLibrary(const std::string& path, LibFunctions& functions) {
+	//Load library and get pointers to export functions
+	void* handle = ::dlopen(path.c_str(), RTLD_NOW);
+	if(handle == nullptr)
+		return false;
 
 	functions.create_ = (CreatePtr_t)dlsym(handle, "create");
 	functions.destroy_ = (DestroyPtr_t)dlsym(handle, "destroy");
+	functions.capabilities_ = (CapabilitiesPtr_t)dlsym(handle, "capabilities");
+	functions.handle_ = handle;
 
-	//TODO: Valid function pointers
-	if(functions.create_ == NULL || functions.destroy_ == NULL)
-		throw std::exception();
+	if(functions.create_ == nullptr || functions.destroy_ == nullptr) {
+		::dlclose(handle);
+		functions = LibFunctions();
+		return false;
+	}
 
-	//Return the pair of create/destroy functions
-	return functions;
+	//Close everything at exit, after any instances have been destroyed
+	static std::once_flag registered;
+	std::call_once(registered, [] { std::atexit(&SortAlgorithm::unloadPlugins); });
+	return true;
+}
+
+/**	@brief	Closes every loaded plugin; registered with atexit() */
+void SortAlgorithm::unloadPlugins() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	for(const AlgoFunctionMap_t::value_type& entry : functionMap_)
+		::dlclose(entry.second.handle_);
+	functionMap_.clear();
 }
 
 }; //End namespace
@@ -20,10 +20,16 @@
 #define _SORTALGORITHM_INCLUDED
 //System includes
 //Library includes
+#include <cstdint>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <utility>
+#include <type_traits>
+//Project includes
+#include "keytraits.h"
 
 //TODO: Platform-specific library prefix and extension
 #ifdef __gnu_linux__
@@ -38,21 +44,69 @@ namespace JAC::Integer {
 
 //Forward decl
 class SortAlgorithm;
+class ThreadPool;
+
+/**	@brief	Key widths a plugin can sort, combined as a bit mask */
+enum KeyWidth : uint32_t {
+	KeyWidth8		= 1U << 0,
+	KeyWidth16	= 1U << 1,
+	KeyWidth32	= 1U << 2,
+	KeyWidth64	= 1U << 3
+};
+
+//Layout version of SortCapabilities
+const uint32_t CapabilitiesVersion = 1;
+
+/**	@brief	Capability descriptor exported by a plugin
+ *	Returned by the optional "capabilities" export of a plugin module so that
+ *	callers can choose an algorithm without trial and error. Plain data, so
+ *	it crosses the C plugin interface unchanged.
+ */
+struct SortCapabilities {
+	uint32_t		version;						/*! Layout version, CapabilitiesVersion */
+	bool				stable;							/*! Equal keys keep their input order */
+	bool				inPlace;						/*! Sorts without a second array of keys */
+	bool				parallel;						/*! Uses more than one thread */
+	double			extraBytesPerKey;		/*! Additional memory per key, approximately */
+	uint32_t		keyWidths;					/*! Supported key widths, KeyWidth bits */
+	uint64_t		minKeys;						/*! Smallest input the algorithm is suited to */
+	uint64_t		maxKeys;						/*! Largest input it is suited to, 0 for no limit */
+	const char*	description;				/*! One-line description */
+};
+
+/**	@brief	A key and its 64-bit payload, sorted as one 16-byte record */
+struct KeyValue {
+	uint64_t	key;				/*! Sort key */
+	uint64_t	value;			/*! Payload (ie: a record ID) */
+};
+
+/**	@brief	Per-call limits on the resources a sort may use
+ *	Applied with a ConcurrencyScope for the duration of the call, so they
+ *	bound every parallel phase of the plugin (and of plugins it delegates to)
+ *	without each plugin handling them.
+ */
+struct SortOptions {
+	unsigned							threads = 0;	/*! Most threads, 0 for the default */
+	std::vector<unsigned>	cpus;					/*! CPUs to run on, empty for any */
+};
 
 //Built-in vector types and other typedefs
 typedef SortAlgorithm* (*CreatePtr_t)();
 typedef void (*DestroyPtr_t)(SortAlgorithm*&);
+typedef const SortCapabilities* (*CapabilitiesPtr_t)();
 
 /**	@brief	Object used to hold create/destroy function pointers
  *	@author	jcleland@jamescleland.com
  */
 class LibFunctions {
 public:
-	LibFunctions() : create_(nullptr), destroy_(nullptr) {};
+	LibFunctions() : create_(nullptr), destroy_(nullptr), capabilities_(nullptr), handle_(nullptr) {};
 	LibFunctions(CreatePtr_t c, DestroyPtr_t d) :
-		create_(c), destroy_(d) {};
+		create_(c), destroy_(d), capabilities_(nullptr), handle_(nullptr) {};
 	CreatePtr_t create_;
 	DestroyPtr_t destroy_;
+	CapabilitiesPtr_t capabilities_;	/*! Optional, nullptr if not exported */
+	void* handle_;										/*! Handle from dlopen() */
 };
 
 /**	@brief	Integer sort using dynamically loaded sorting algorithms
@@ -65,6 +119,9 @@ public:
 	typedef IntVector_t::iterator 				IntVectorIterator_t;
 	typedef IntVector_t::reverse_iterator IntVectorRIterator_t;
 
+	//Named measurements from the last sort, in report order
+	typedef std::vector<std::pair<std::string, double>>	Metrics_t;
+
 private:
 	//Pair type for function map
 	typedef std::pair<std::string, LibFunctions>	AlgoFunctionMapPair_t;
@@ -73,10 +130,16 @@ private:
 	typedef std::map<std::string,LibFunctions> 		AlgoFunctionMap_t;
 
 	/**	@brief	Map instance containing well-known agorithm name to create/destroy functions
-	 *	TODO: Not thread-safe
+	 *	Each plugin is loaded once and stays loaded until exit. Guarded by mutex_.
 	 */
 	static AlgoFunctionMap_t	functionMap_;
 
+	//Guards functionMap_ and pluginDir_
+	static std::mutex					mutex_;
+
+	//Directory passed to loadPlugins(), empty if none
+	static std::string				pluginDir_;
+
 	//The type name of the derived sorter instance
 	std::string typeName_;
 
@@ -100,6 +163,38 @@ public:
 	 */
 	static void destroy(SortAlgorithm*& obj);
 
+	/**	@brief	Returns the capability descriptor of an algorithm, loading it if needed
+	 *	@param	name	The well-known algorithm name
+	 *	@return	The descriptor, or nullptr if the plugin does not export one
+	 *	@throws	std::runtime_error	If the plugin cannot be loaded
+	 */
+	static const SortCapabilities* capabilities(const std::string& name);
+
+	/**	@brief	Loads every plugin in a directory and searches it first from now on
+	 *	Files named lib<name>.so that export create() and destroy() are
+	 *	registered as algorithm <name>; other libraries are closed again.
+	 *	@param	dir	The plugin directory
+	 *	@return	The number of plugins registered from the directory
+	 */
+	static size_t loadPlugins(const std::string& dir);
+
+	/**	@brief	Returns the names of all loaded plugins, in order */
+	static std::vector<std::string> algorithms();
+
+	/**	@brief	Returns the directory searched first for plugins
+	 *	This is the directory last passed to loadPlugins(), otherwise the
+	 *	directory holding the sort library itself, where the plugins are built
+	 *	and installed.
+	 */
+	static std::string pluginDirectory();
+
+	/**	@brief	Returns the process-wide executor shared by all plugins
+	 *	Plugins submit work here (directly, through a TaskGroup or through
+	 *	parallelFor()) rather than starting threads of their own, so that
+	 *	concurrent sorts share one fixed set of threads.
+	 */
+	static ThreadPool& executor();
+
 	/**
 	 */
 	void setTypeName(const std::string& typeName) {
@@ -113,11 +208,203 @@ public:
 		return typeName_;
 	}
 
-	/** @brief	Implementation-specific sort method for arrays of unsigned LL
+	/** @brief	Implementation-specific in-place sort of unsigned 64-bit keys
+	 *	The keys may be any writable memory: a std::vector's buffer, a slice of
+	 *	a larger buffer or a mapped file.
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	virtual void sort(uint64_t* keys, size_t count) = 0;
+
+	/** @brief	In-place sort of unsigned 32-bit keys
+	 *	The default widens the keys into a temporary array, sorts them with
+	 *	sort(uint64_t*, size_t) and narrows them back. Algorithms with a native
+	 *	32-bit path override it and report KeyWidth32 in their capabilities.
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	virtual void sort(uint32_t* keys, size_t count);
+
+	/** @brief	Sorts a vector of unsigned LL in place
+	 *	Forwards to sort(keys, count), so the vector keeps its own storage;
+	 *	algorithms that finish in a scratch buffer copy the keys back once.
 	 *	@param	arr	A std::vector<uint64_t> of values to be sorted
-	 *	@return	A std::vector<uint64_t> containing the values from arr in sorted order
+	 *	@return	arr, now in sorted order
 	 */
-	virtual IntVector_t sort(IntVector_t& arr) = 0;
+	virtual IntVector_t& sort(IntVector_t& arr) {
+		sort(arr.data(), arr.size());
+		return arr;
+	}
+
+	/** @brief	Sorts keys in place within per-call thread and CPU limits
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 *	@param	options	Limits for this call
+	 */
+	void sort(uint64_t* keys, size_t count, const SortOptions& options);
+
+	/** @brief	Sorts 32-bit keys in place within per-call thread and CPU limits
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 *	@param	options	Limits for this call
+	 */
+	void sort(uint32_t* keys, size_t count, const SortOptions& options);
+
+	/** @brief	Sorts a vector in place within per-call thread and CPU limits
+	 *	@param	arr			A std::vector<uint64_t> of values to be sorted
+	 *	@param	options	Limits for this call
+	 *	@return	arr, now in sorted order
+	 */
+	IntVector_t& sort(IntVector_t& arr, const SortOptions& options);
+
+	/** @brief	Sorts keys of any supported type in place
+	 *	Signed and floating-point keys are mapped in place onto unsigned keys
+	 *	of the same width with an order-preserving transform (see KeyTraits),
+	 *	sorted with the matching sort() overload and mapped back, so every
+	 *	algorithm sorts u32, u64, i32, i64, f32 and f64 keys.
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 */
+	template<typename Key>
+	void sortKeys(Key* keys, size_t count) {
+		typedef typename KeyTraits<Key>::Radix_t Radix_t;
+		if constexpr(std::is_same<Key, Radix_t>::value) {
+			sort(keys, count);
+		}
+		else {
+			Radix_t* bits = toRadixKeys(keys, count);
+			sort(bits, count);
+			fromRadixKeys<Key>(bits, count);
+		}
+	}
+
+	/** @brief	Sorts keys of any supported type within per-call limits
+	 *	@param	keys		First key
+	 *	@param	count		Number of keys
+	 *	@param	options	Limits for this call
+	 */
+	template<typename Key>
+	void sortKeys(Key* keys, size_t count, const SortOptions& options) {
+		typedef typename KeyTraits<Key>::Radix_t Radix_t;
+		if constexpr(std::is_same<Key, Radix_t>::value) {
+			sort(keys, count, options);
+		}
+		else {
+			Radix_t* bits = toRadixKeys(keys, count);
+			sort(bits, count, options);
+			fromRadixKeys<Key>(bits, count);
+		}
+	}
+
+	/**	@brief	Sorts many independent segments of one flat buffer in place
+	 *	Segment s holds keys[offsets[s]] up to keys[offsets[s+1]]. The default
+	 *	sorts tiny segments with sorting networks and large ones by radix,
+	 *	spreading segments across threads (see segmentedSort()), which avoids
+	 *	a call per segment; algorithms may override it.
+	 *	@param	keys			The flat buffer of keys
+	 *	@param	offsets		Segment boundaries, segments+1 non-decreasing entries
+	 *	@param	segments	Number of segments
+	 */
+	virtual void sortSegments(uint64_t* keys, const uint64_t* offsets, size_t segments);
+
+	/**	@brief	Stable sort of keys, moving a payload array with them
+	 *	Equal keys keep the input order of their payloads. The default is an
+	 *	LSD radix sort with split key and payload arrays (see radixSortPairs()).
+	 *	@param	keys		Keys to sort
+	 *	@param	values	Payloads (ie: record IDs), one per key
+	 *	@param	count		Number of keys
+	 */
+	virtual void sortPairs(uint64_t* keys, uint64_t* values, size_t count);
+
+	/**	@brief	Stable sort of packed key/value records by key
+	 *	@param	records	Records to sort
+	 *	@param	count		Number of records
+	 */
+	virtual void sortRecords(KeyValue* records, size_t count);
+
+	/**	@brief	Stable argsort with 32-bit indices
+	 *	Fills indices with the permutation that sorts keys, leaving keys as
+	 *	they are: keys[indices[0]] <= keys[indices[1]] <= ...
+	 *	@param	keys		Keys to order
+	 *	@param	count		Number of keys, at most UINT32_MAX
+	 *	@param	indices	Receives count indices
+	 *	@throws	std::invalid_argument	If count does not fit in 32 bits
+	 */
+	virtual void argsort(const uint64_t* keys, size_t count, uint32_t* indices);
+
+	/**	@brief	Stable argsort with 64-bit indices
+	 *	@param	keys		Keys to order
+	 *	@param	count		Number of keys
+	 *	@param	indices	Receives count indices
+	 */
+	virtual void argsort(const uint64_t* keys, size_t count, uint64_t* indices);
+
+	/**	@brief	Copies the k smallest keys in ascending order
+	 *	The default selects them without sorting (see selectSmallest()), then
+	 *	sorts only those k keys with sort(), so the cost is O(count) reads.
+	 *	@param	keys		The keys; not modified
+	 *	@param	count		Number of keys
+	 *	@param	k				Number of keys wanted
+	 *	@param	out			Receives min(k, count) keys
+	 *	@return	The number of keys written
+	 */
+	virtual size_t partialSort(const uint64_t* keys, size_t count, size_t k, uint64_t* out);
+
+	/**	@brief	Copies the k largest keys in descending order
+	 *	@param	keys		The keys; not modified
+	 *	@param	count		Number of keys
+	 *	@param	k				Number of keys wanted
+	 *	@param	out			Receives min(k, count) keys
+	 *	@return	The number of keys written
+	 */
+	virtual size_t topK(const uint64_t* keys, size_t count, size_t k, uint64_t* out);
+
+	/**	@brief	Returns the key at a rank without sorting
+	 *	The default is a radix select (see selectRank()).
+	 *	@param	keys		The keys; not modified
+	 *	@param	count		Number of keys
+	 *	@param	rank		Rank counting from 0, so 0 is the smallest key
+	 *	@return	The key that would be at position rank once sorted
+	 *	@throws	std::out_of_range	If rank is not less than count
+	 */
+	virtual uint64_t nthElement(const uint64_t* keys, size_t count, size_t rank);
+
+	/**	@brief	Sorts keys in place and keeps one copy of each
+	 *	The default sorts with sort() and then collapses the runs of equal keys
+	 *	(see collapseRuns()); algorithms that can drop duplicates while they
+	 *	place keys override it to save that pass.
+	 *	@param	keys		Keys to sort; the distinct keys are left at the front
+	 *	@param	count		Number of keys
+	 *	@return	The number of distinct keys
+	 */
+	virtual size_t sortUnique(uint64_t* keys, size_t count);
+
+	/**	@brief	Sorts keys in place, keeping one copy of each with its count
+	 *	@param	keys		Keys to sort; the distinct keys are left at the front
+	 *	@param	count		Number of keys
+	 *	@param	counts	Receives the occurrences of each distinct key; at least
+	 *									count elements
+	 *	@return	The number of distinct keys
+	 */
+	virtual size_t sortCounted(uint64_t* keys, size_t count, uint64_t* counts);
+
+	/**	@brief	Sets an implementation-specific tuning option
+	 *	@param	name	The option name (ie: digit-bits)
+	 *	@param	value	The option value as text
+	 *	@return	True if the option is recognized by this algorithm, otherwise false
+	 *	@throws	std::invalid_argument	If the option is recognized but the value is not
+	 */
+	virtual bool setOption(const std::string&, const std::string&) {
+		return false;
+	}
+
+	/**	@brief	Returns implementation-specific measurements of the last sort
+	 *	Reported with the -v statistics (ie: buckets, parallelism).
+	 *	@return	Name/value pairs, empty by default
+	 */
+	virtual Metrics_t metrics() const {
+		return Metrics_t();
+	}
 
 private:
 	/**	@brief	Returns create/destroy functions for the appropriate sort algorithm
@@ -125,6 +412,16 @@ private:
 	 *	@return	A std::pair instance creating create/destroy functions for the algo library
 	 */
 	static LibFunctions instanceApiFor(const std::string& name);
+
+	/**	@brief	Opens a plugin module and resolves its exports
+	 *	@param	path	Path or file name passed to dlopen()
+	 *	@param	functions	Receives the exports and handle
+	 *	@return	False if the module cannot be opened or is not a plugin
+	 */
+	static bool openLibrary(const std::string& path, LibFunctions& functions);
+
+	/**	@brief	Closes every loaded plugin; registered with atexit() */
+	static void unloadPlugins();
 };
 
 }; //End namespace
@@ -18,13 +18,29 @@
  */
 //System includes
 #include <getopt.h>
+#include <sys/stat.h>
 //Library includes
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <iterator>
 #include <exception>
 #include <algorithm>
 #include <memory>
+#include <stdexcept>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <cstring>
 //Project includes
 #include "sorter.h"
+#include "externalsort.h"
+#include "merger.h"
+#include "binaryfile.h"
+#include "textparser.h"
+#include "threadpool.h"
+#include "scratch.h"
+#include "unique.h"
 
 //Extern variables for command line processign using getopt
 extern char*	optarg;
@@ -32,6 +48,93 @@ extern int 		optind, opterr, optopt;
 
 namespace JAC::Integer {
 
+/**	@brief	Returns $TMPDIR if set, otherwise /tmp */
+static std::string defaultTempDir() {
+	const char* dir = getenv("TMPDIR");
+	return (dir != nullptr && *dir != '\0') ? dir : "/tmp";
+}
+
+/**	@brief	Returns the size of a file, or 0 if it cannot be read
+ *	@param	path	The file path
+ */
+static uint64_t fileBytes(const std::string& path) {
+	struct stat st;
+	return (::stat(path.c_str(), &st) == 0) ? (uint64_t) st.st_size : 0;
+}
+
+/**	@brief	Writes typed keys as text, one per line
+ *	Floating-point keys are written in their shortest round-trip form.
+ *	@param	path	The file to write, or "-" for standard output
+ *	@param	keys	The keys to write
+ *	@param	count	Number of keys
+ *	@throws	std::runtime_error	On I/O errors
+ */
+template<typename Key>
+static void writeTypedKeys(const std::string& path, const Key* keys, size_t count) {
+	FILE* out = (path == "-") ? stdout : fopen(path.c_str(), "w");
+	if(out == nullptr)
+		throw std::runtime_error("Unable to open output file '" + path + "': " +
+			strerror(errno));
+
+	std::vector<char> buffer(1 << 20);
+	size_t used = 0;
+	bool ok = true;
+	for(size_t idx = 0; idx < count && ok; idx++) {
+		//Longest value is a double's 24 characters, plus the newline
+		if(buffer.size() - used < 32) {
+			ok = fwrite(buffer.data(), 1, used, out) == used;
+			used = 0;
+		}
+		std::to_chars_result result = std::to_chars(buffer.data() + used,
+			buffer.data() + buffer.size(), keys[idx]);
+		used = result.ptr - buffer.data();
+		buffer[used++] = '\n';
+	}
+	if(count == 0) buffer[used++] = '\n';
+	ok = ok && fwrite(buffer.data(), 1, used, out) == used;
+	ok = (fflush(out) == 0) && ok;
+	if(out != stdout) ok = (fclose(out) == 0) && ok;
+	if(!ok)
+		throw std::runtime_error("Error writing '" + path + "': " + strerror(errno));
+}
+
+/**	@brief	Writes distinct keys and their counts as "key count" text lines
+ *	@param	path		The file to create or truncate, or "-" for standard output
+ *	@param	keys		Distinct keys
+ *	@param	counts	Occurrences of each key
+ *	@param	count		Number of distinct keys
+ *	@throws	std::runtime_error	On I/O errors
+ */
+static void writeKeyCounts(const std::string& path, const uint64_t* keys,
+	const uint64_t* counts, size_t count) {
+	FILE* out = (path == "-") ? stdout : fopen(path.c_str(), "w");
+	if(out == nullptr)
+		throw std::runtime_error("Unable to open output file '" + path + "': " +
+			strerror(errno));
+
+	std::vector<char> buffer(1 << 20);
+	size_t used = 0;
+	bool ok = true;
+	for(size_t idx = 0; idx < count && ok; idx++) {
+		//Two 20 digit values, a space and the newline
+		if(buffer.size() - used < 48) {
+			ok = fwrite(buffer.data(), 1, used, out) == used;
+			used = 0;
+		}
+		char* pos = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(),
+			keys[idx]).ptr;
+		*pos++ = ' ';
+		pos = std::to_chars(pos, buffer.data() + buffer.size(), counts[idx]).ptr;
+		*pos++ = '\n';
+		used = pos - buffer.data();
+	}
+	ok = ok && fwrite(buffer.data(), 1, used, out) == used;
+	ok = (fflush(out) == 0) && ok;
+	if(out != stdout) ok = (fclose(out) == 0) && ok;
+	if(!ok)
+		throw std::runtime_error("Error writing '" + path + "': " + strerror(errno));
+}
+
 /**	@brief	Default constructor */
 Sorter::Sorter() :
 	argc_(0),
@@ -42,7 +145,24 @@ Sorter::Sorter() :
 	createData_(false),
 	dataMax_(DefaultDataMax),
 	numValues_(DefaultNumValues),
-	console_(true)
+	console_(true),
+	memoryBudget_(0),
+	tempDir_(defaultTempDir()),
+	binary_(false),
+	inputFormat_(KeyFormat::Text),
+	outputFormat_(KeyFormat::Text),
+	inputSorted_(false),
+	distribution_({ Distribution::Uniform, 0 }),
+	seed_(DefaultSeed),
+	verbose_(false),
+	listAlgorithms_(false),
+	keyType_(KeyType::UInt64),
+	selectMode_(SelectMode::None),
+	selectCount_(0),
+	sketchK_(0),
+	merge_(false),
+	unique_(false),
+	countKeys_(false)
 	{}
 
 /**	@brief	Construct with command line arguments
@@ -58,50 +178,595 @@ Sorter::Sorter(int argc, char** argv) :
 	createData_(false),
 	dataMax_(DefaultDataMax),
 	numValues_(DefaultNumValues),
-	console_(true)
+	console_(true),
+	memoryBudget_(0),
+	tempDir_(defaultTempDir()),
+	binary_(false),
+	inputFormat_(KeyFormat::Text),
+	outputFormat_(KeyFormat::Text),
+	inputSorted_(false),
+	distribution_({ Distribution::Uniform, 0 }),
+	seed_(DefaultSeed),
+	verbose_(false),
+	listAlgorithms_(false),
+	keyType_(KeyType::UInt64),
+	selectMode_(SelectMode::None),
+	selectCount_(0),
+	sketchK_(0),
+	merge_(false),
+	unique_(false),
+	countKeys_(false)
 	{}
 
 /**	@brief	Destructor */
 Sorter::~Sorter() {
-	//Close input and output streams as needed
-	if(ifs_.is_open()) ifs_.close();
-	if(ofs_.is_open()) ofs_.close();
+}
+
+/**	@brief	Describes what the last sort() did, for reporting its time
+ *	@return	A phrase such as "Sorted using 'radix' algorithm", empty when
+ *		only the algorithms were listed
+ */
+std::string Sorter::summary() const {
+	const std::string by = " using '" + algorithm_ + "' algorithm";
+	if(listAlgorithms_)
+		return "";
+	if(merge_)
+		return "Merged " + std::to_string(mergeFileNames_.size()) + " sorted files";
+	if(!deltaFileName_.empty())
+		return "Merged delta into sorted base" + by;
+	if(!quantiles_.empty())
+		return (sketchK_ > 0) ? "Estimated quantiles" : "Selected quantiles";
+	switch(selectMode_) {
+		case SelectMode::Smallest:
+			return "Selected " + std::to_string(selectCount_) + " smallest keys" + by;
+		case SelectMode::Largest:
+			return "Selected " + std::to_string(selectCount_) + " largest keys" + by;
+		case SelectMode::Nth:
+			return "Selected key at rank " + std::to_string(selectCount_) + by;
+		default:
+			break;
+	}
+	if(unique_)
+		return (countKeys_ ? "Counted distinct keys" : "Sorted distinct keys") + by;
+	return "Sorted" + by;
 }
 
 /**	@brief	Sort values in array. Array data is overwritten.
- *	@return An array containing sorted values
+ *	Keys are sorted where they were loaded, without further copies: binary
+ *	files in their private mapping, text files in the parsed array.
+ *	@return The number of keys sorted
  *	@throws	exception On error initializing driver or performing sort.
  */
-IntArray_t Sorter::sort() {
+uint64_t Sorter::sort() {
 	//Declare locals
 	IntArray_t array;
+	std::unique_ptr<MappedKeyFile> mapped;
+	uint64_t* keys = nullptr;
+	size_t count = 0;
 
 	try {
 		//Handle command line args
 		parseCommandLine(argc_, argv_);
 
+		//Every phase stays within the -j and --cpus limits
+		ConcurrencyScope scope(sortOptions_.threads, sortOptions_.cpus);
+
+		//Just describing the plugins?
+		if(listAlgorithms_) {
+			printAlgorithms();
+			return 0;
+		}
+
+		if(verbose_) stats_.counters().open();
+
 		//New data?
-		if(createData_) generateData();
+		if(createData_) {
+			stats_.begin("generate");
+			generateData();
+			stats_.end(numValues_, fileBytes(dataFileName_));
+		}
 
-		//Load data
-		array = readData();
+		//Already sorted inputs? Merge them rather than sort again
+		if(merge_ || !deltaFileName_.empty()) {
+			stats_.begin("merge");
+			count = mergeFiles();
+			stats_.end(count, count * sizeof(uint64_t));
+			reportStats();
+			return count;
+		}
 
-		//Sort
-		std::cout << "Using Algorithm '" << algorithm_.c_str() << "'..." << std::endl;
-		SortAlgorithm* psorter = SortAlgorithm::create(algorithm_);
-		psorter->sort(array);
+		//Quantiles of a file too large to load, or estimated? Stream it
+		if(!quantiles_.empty() && (sketchK_ > 0 || memoryBudget_ > 0)) {
+			count = streamQuantiles();
+			reportStats();
+			return count;
+		}
+
+		//Keys other than u64 are text only and sorted through their transform
+		if(keyType_ != KeyType::UInt64) {
+			count = sortTyped();
+			reportStats();
+			return count;
+		}
+
+		//Larger than memory? Sort file to file without loading it
+		if(memoryBudget_ > 0) {
+			stats_.begin("external");
+			count = sortExternal();
+			stats_.end(count, fileBytes(dataFileName_));
+			reportStats();
+			return count;
+		}
+
+		//Load data; binary keys are sorted in place in a private mapping
+		stats_.begin("read");
+		if(inputFormat_ == KeyFormat::Binary) {
+			mapped.reset(new MappedKeyFile(dataFileName_));
+			inputSorted_ = mapped->sorted();
+			keys = mapped->data();
+			count = mapped->count();
+		}
+		else {
+			array = readData();
+			keys = array.data();
+			count = array.size();
+		}
+		stats_.end(count, fileBytes(dataFileName_));
+
+		//Only part of the order wanted? Select it without sorting everything
+		if(selectMode_ != SelectMode::None) {
+			count = select(keys, count);
+			reportStats();
+			return count;
+		}
+		if(!quantiles_.empty()) {
+			count = selectQuantiles(keys, count);
+			reportStats();
+			return count;
+		}
+
+		//Distinct keys only? Duplicates are dropped as the keys are placed
+		if(unique_) {
+			count = sortDistinct(keys, count);
+			reportStats();
+			return count;
+		}
+
+		//Sort, unless the file header says there is nothing to do
+		if(inputSorted_) {
+			std::cout << "Input is marked as sorted, skipping sort" << std::endl;
+		}
+		else {
+			std::cout << "Using Algorithm '" << algorithm_.c_str() << "'..." << std::endl;
+			SortAlgorithm* psorter = createAlgorithm();
+			try {
+				stats_.begin("sort");
+				stats_.startCounters();
+				psorter->sort(keys, count, sortOptions_);
+				stats_.stopCounters();
+				stats_.end(count, count * sizeof(uint64_t));
+				stats_.setMetrics(psorter->metrics());
+			}
+			catch(...) {
+				SortAlgorithm::destroy(psorter);
+				throw;
+			}
+			SortAlgorithm::destroy(psorter);
+		}
 
 		//Output?
-		if(console_) printArrayToConsole("Sorted array: ", array);
+		if(console_) {
+			stats_.begin("print");
+			printArrayToConsole(keys, count);
+			stats_.end(count, 0);
+		}
 
 		//Write file if we have a filename for output
-		if(outputFileName_.length() > 0) writeArrayToFile(array);
+		if(outputFileName_.length() > 0 && !console_) {
+			stats_.begin("write");
+			writeArrayToFile(keys, count);
+			stats_.end(count, fileBytes(outputFileName_));
+		}
+
+		reportStats();
 	}
 	catch(const char* e) {
 		std::cout << "Exception caught during sort: " << e << std::endl;
 	}
 
-	return array;
+	return count;
+}
+
+/**	@brief	Creates the selected algorithm and applies tuning options
+ *	@return	A sorter instance, to be released with SortAlgorithm::destroy()
+ *	@throws	exception On error loading the algorithm or an unsupported option
+ */
+SortAlgorithm* Sorter::createAlgorithm() {
+	SortAlgorithm* psorter = SortAlgorithm::create(algorithm_);
+	try {
+		//-v asks plugins that can explain their choices (ie: auto) to do so
+		if(verbose_) psorter->setOption("log", "1");
+		for(const auto& option : algoOptions_) {
+			if(!psorter->setOption(option.first, option.second))
+				throw std::invalid_argument("Option '" + option.first +
+					"' is not supported by algorithm '" + algorithm_ + "'");
+		}
+	}
+	catch(...) {
+		SortAlgorithm::destroy(psorter);
+		throw;
+	}
+	return psorter;
+}
+
+/**	@brief	Sorts the data file out of core within the memory budget
+ *	@throws	exception On error sorting or on I/O errors
+ */
+uint64_t Sorter::sortExternal() {
+	std::cout << "Using Algorithm '" << algorithm_.c_str() << "' with a memory budget of " <<
+		memoryBudget_ << " bytes..." << std::endl;
+
+	SortAlgorithm* psorter = createAlgorithm();
+	uint64_t keys;
+	try {
+		ExternalSorter external(*psorter, memoryBudget_, tempDir_);
+		stats_.startCounters();
+		keys = external.sort(dataFileName_, inputFormat_,
+			console_ ? "-" : outputFileName_, console_ ? KeyFormat::Text : outputFormat_);
+		stats_.stopCounters();
+		stats_.setMetrics(psorter->metrics());
+		reportBadLines(external.badLines(), external.errors());
+		if(external.runCount() > 0)
+			std::cout << "Merged " << external.runCount() << " sorted runs" << std::endl;
+	}
+	catch(...) {
+		SortAlgorithm::destroy(psorter);
+		throw;
+	}
+	SortAlgorithm::destroy(psorter);
+	return keys;
+}
+
+/**	@brief	Merges sorted files (--merge), or a delta into a sorted base (--delta)
+ *	Inputs are streamed through a buffered loser tree, within the -m budget
+ *	if one is given. Only the delta is sorted, with the selected algorithm.
+ *	@return	The number of keys written
+ *	@throws	exception On error sorting the delta, unsorted input or I/O errors
+ */
+uint64_t Sorter::mergeFiles() {
+	KeyMerger merger(memoryBudget_);
+	const std::string output = console_ ? "-" : outputFileName_;
+	const KeyFormat format = console_ ? KeyFormat::Text : outputFormat_;
+	uint64_t keys;
+
+	if(merge_) {
+		std::vector<KeySource> inputs;
+		for(const std::string& path : mergeFileNames_)
+			inputs.push_back({ path, keyFormatFor(path, binary_, true) });
+		std::cout << "Merging " << inputs.size() << " sorted files..." << std::endl;
+		keys = merger.merge(inputs, output, format);
+	}
+	else {
+		std::cout << "Using Algorithm '" << algorithm_.c_str() << "' to sort the delta..." <<
+			std::endl;
+		SortAlgorithm* psorter = createAlgorithm();
+		try {
+			stats_.startCounters();
+			keys = merger.mergeDelta({ dataFileName_, inputFormat_ },
+				{ deltaFileName_, keyFormatFor(deltaFileName_, binary_, true) }, *psorter,
+				output, format);
+			stats_.stopCounters();
+			stats_.setMetrics(psorter->metrics());
+		}
+		catch(...) {
+			SortAlgorithm::destroy(psorter);
+			throw;
+		}
+		SortAlgorithm::destroy(psorter);
+		std::cout << "Merged " << merger.deltaCount() << " delta keys" << std::endl;
+	}
+
+	reportBadLines(merger.badLines(), merger.errors());
+	if(merger.checked() > 0)
+		std::cout << "Checked the order of " << merger.checked() <<
+			" inputs not marked as sorted" << std::endl;
+	return keys;
+}
+
+/**	@brief	Sorts a text data file of --key-type keys in memory
+ *	@return	The number of keys sorted
+ *	@throws	exception On error sorting or on I/O errors
+ */
+uint64_t Sorter::sortTyped() {
+	switch(keyType_) {
+		case KeyType::UInt32:	return sortKeysAs<uint32_t>();
+		case KeyType::Int32:	return sortKeysAs<int32_t>();
+		case KeyType::Int64:	return sortKeysAs<int64_t>();
+		case KeyType::Float:	return sortKeysAs<float>();
+		case KeyType::Double:	return sortKeysAs<double>();
+		default:							return sortKeysAs<uint64_t>();
+	}
+}
+
+/**	@brief	Reads, sorts and writes keys of one type
+ *	@return	The number of keys sorted
+ *	@throws	exception On error sorting or on I/O errors
+ */
+template<typename Key>
+uint64_t Sorter::sortKeysAs() {
+	std::vector<Key> keys;
+	TextKeyParser parser;
+	stats_.begin("read");
+	parser.parseFile(dataFileName_, keys);
+	stats_.end(keys.size(), fileBytes(dataFileName_));
+	reportBadLines(parser.badLines(), parser.errors());
+
+	std::cout << "Using Algorithm '" << algorithm_.c_str() << "' on " <<
+		keyTypeName(keyType_) << " keys..." << std::endl;
+	SortAlgorithm* psorter = createAlgorithm();
+	try {
+		stats_.begin("sort");
+		stats_.startCounters();
+		psorter->sortKeys(keys.data(), keys.size(), sortOptions_);
+		stats_.stopCounters();
+		stats_.end(keys.size(), keys.size() * sizeof(Key));
+		stats_.setMetrics(psorter->metrics());
+	}
+	catch(...) {
+		SortAlgorithm::destroy(psorter);
+		throw;
+	}
+	SortAlgorithm::destroy(psorter);
+
+	if(console_) {
+		std::cout.flush();
+		stats_.begin("print");
+		writeTypedKeys("-", keys.data(), keys.size());
+		stats_.end(keys.size(), 0);
+	}
+	else if(outputFileName_.length() > 0) {
+		stats_.begin("write");
+		writeTypedKeys(outputFileName_, keys.data(), keys.size());
+		stats_.end(keys.size(), fileBytes(outputFileName_));
+	}
+	return keys.size();
+}
+
+/**	@brief	Outputs the -k, --top or --nth selection from loaded keys
+ *	Sorted binary input is simply indexed; otherwise the algorithm selects
+ *	the keys in O(count) reads and sorts only those it returns.
+ *	@param	keys	The keys; not modified
+ *	@param	count	Number of keys
+ *	@return	The number of keys output
+ *	@throws	exception On error selecting or on I/O errors
+ */
+uint64_t Sorter::select(const uint64_t* keys, size_t count) {
+	if(selectMode_ == SelectMode::Nth && selectCount_ >= count)
+		throw std::out_of_range("Rank " + std::to_string(selectCount_) + " is out of range for " +
+			std::to_string(count) + " keys");
+	std::vector<uint64_t> result((selectMode_ == SelectMode::Nth) ? 1 :
+		std::min<uint64_t>(selectCount_, count));
+
+	stats_.begin("select");
+	if(inputSorted_) {
+		if(selectMode_ == SelectMode::Smallest)
+			std::copy(keys, keys + result.size(), result.begin());
+		else if(selectMode_ == SelectMode::Largest)
+			std::reverse_copy(keys + count - result.size(), keys + count, result.begin());
+		else
+			result[0] = keys[selectCount_];
+	}
+	else {
+		std::cout << "Using Algorithm '" << algorithm_.c_str() << "'..." << std::endl;
+		SortAlgorithm* psorter = createAlgorithm();
+		try {
+			stats_.startCounters();
+			if(selectMode_ == SelectMode::Smallest)
+				psorter->partialSort(keys, count, result.size(), result.data());
+			else if(selectMode_ == SelectMode::Largest)
+				psorter->topK(keys, count, result.size(), result.data());
+			else
+				result[0] = psorter->nthElement(keys, count, selectCount_);
+			stats_.stopCounters();
+			stats_.setMetrics(psorter->metrics());
+		}
+		catch(...) {
+			SortAlgorithm::destroy(psorter);
+			throw;
+		}
+		SortAlgorithm::destroy(psorter);
+	}
+	stats_.end(count, count * sizeof(uint64_t));
+
+	if(console_) {
+		stats_.begin("print");
+		printArrayToConsole(result.data(), result.size());
+		stats_.end(result.size(), 0);
+	}
+	else if(outputFileName_.length() > 0) {
+		stats_.begin("write");
+		writeArrayToFile(result.data(), result.size(), selectMode_ != SelectMode::Largest);
+		stats_.end(result.size(), fileBytes(outputFileName_));
+	}
+	return result.size();
+}
+
+/**	@brief	Sorts loaded keys and outputs each distinct key once (--unique, --count)
+ *	The algorithm drops (or counts) duplicates while it places the keys, so
+ *	only the distinct keys are written back and output; sorted binary input
+ *	just has its runs collapsed.
+ *	@param	keys	The keys; the distinct keys are left at the front
+ *	@param	count	Number of keys
+ *	@return	The number of distinct keys
+ *	@throws	exception On error sorting or on I/O errors
+ */
+uint64_t Sorter::sortDistinct(uint64_t* keys, size_t count) {
+	IntArray_t counts(countKeys_ ? count : 0);
+	uint64_t* multiplicity = countKeys_ ? counts.data() : nullptr;
+	size_t distinct = 0;
+
+	if(inputSorted_) {
+		std::cout << "Input is marked as sorted, skipping sort" << std::endl;
+		stats_.begin("unique");
+		distinct = collapseRuns(keys, count, multiplicity);
+		stats_.end(count, count * sizeof(uint64_t));
+	}
+	else {
+		std::cout << "Using Algorithm '" << algorithm_.c_str() << "'..." << std::endl;
+		SortAlgorithm* psorter = createAlgorithm();
+		try {
+			stats_.begin("sort");
+			stats_.startCounters();
+			distinct = countKeys_ ? psorter->sortCounted(keys, count, multiplicity) :
+				psorter->sortUnique(keys, count);
+			stats_.stopCounters();
+			stats_.end(count, count * sizeof(uint64_t));
+			stats_.setMetrics(psorter->metrics());
+		}
+		catch(...) {
+			SortAlgorithm::destroy(psorter);
+			throw;
+		}
+		SortAlgorithm::destroy(psorter);
+	}
+	std::cout << "Kept " << distinct << " distinct keys of " << count << std::endl;
+
+	if(console_) {
+		stats_.begin("print");
+		if(countKeys_) {
+			std::cout.flush();
+			writeKeyCounts("-", keys, multiplicity, distinct);
+		}
+		else {
+			printArrayToConsole(keys, distinct);
+		}
+		stats_.end(distinct, 0);
+	}
+	else if(outputFileName_.length() > 0) {
+		stats_.begin("write");
+		if(countKeys_)
+			writeKeyCounts(outputFileName_, keys, multiplicity, distinct);
+		else
+			writeArrayToFile(keys, distinct);
+		stats_.end(distinct, fileBytes(outputFileName_));
+	}
+	return distinct;
+}
+
+/**	@brief	Outputs the --quantiles of loaded keys, selected exactly
+ *	Sorted binary input is simply indexed; otherwise every rank is found in
+ *	one shared radix select rather than a sort.
+ *	@param	keys	The keys; not modified
+ *	@param	count	Number of keys
+ *	@return	The number of keys the quantiles describe
+ *	@throws	exception On error selecting or on I/O errors
+ */
+uint64_t Sorter::selectQuantiles(const uint64_t* keys, size_t count) {
+	if(count == 0)
+		throw std::runtime_error("No keys in '" + dataFileName_ + "' to compute quantiles from");
+	std::vector<double> fractions;
+	for(const Quantile& quantile : quantiles_) fractions.push_back(quantile.fraction);
+
+	stats_.begin("quantiles");
+	std::vector<uint64_t> values;
+	if(inputSorted_) {
+		for(double fraction : fractions) values.push_back(keys[quantileRank(fraction, count)]);
+	}
+	else {
+		stats_.startCounters();
+		values = exactQuantiles(keys, count, fractions, sortOptions_.threads);
+		stats_.stopCounters();
+	}
+	stats_.end(count, count * sizeof(uint64_t));
+
+	outputQuantiles(values);
+	return count;
+}
+
+/**	@brief	Outputs the --quantiles of the data file, streamed in bounded memory
+ *	With --approx every key is read once into per-thread sketches. Otherwise
+ *	the file is read once per digit of a radix select until the remaining
+ *	candidates fit in half the -m budget, then once more to gather them.
+ *	@return	The number of keys the quantiles describe
+ *	@throws	exception On error reading the file or on I/O errors
+ */
+uint64_t Sorter::streamQuantiles() {
+	std::vector<double> fractions;
+	for(const Quantile& quantile : quantiles_) fractions.push_back(quantile.fraction);
+
+	stats_.begin("quantiles");
+	stats_.startCounters();
+	QuantileResult result = (sketchK_ > 0) ?
+		approxQuantiles(dataFileName_, inputFormat_, fractions, sketchK_, sortOptions_.threads) :
+		exactQuantiles(dataFileName_, inputFormat_, fractions, memoryBudget_,
+			sortOptions_.threads);
+	stats_.stopCounters();
+	stats_.end(result.count, fileBytes(dataFileName_) * result.passes);
+
+	reportBadLines(result.badLines, result.errors);
+	if(sketchK_ > 0)
+		std::cout << "Estimated quantiles of " << result.count << " keys with a sketch of size " <<
+			sketchK_ << std::endl;
+	else
+		std::cout << "Selected quantiles of " << result.count << " keys in " << result.passes <<
+			" passes over the data file" << std::endl;
+	outputQuantiles(result.values);
+	return result.count;
+}
+
+/**	@brief	Prints or writes one "label value" line per quantile
+ *	@param	values	One key per entry of quantiles_
+ *	@throws	exception On I/O errors
+ */
+void Sorter::outputQuantiles(const std::vector<uint64_t>& values) {
+	std::ostringstream text;
+	for(size_t idx = 0; idx < quantiles_.size(); idx++)
+		text << quantiles_[idx].label << " " << values[idx] << std::endl;
+
+	if(console_) {
+		std::cout << text.str();
+	}
+	else if(outputFileName_.length() > 0) {
+		stats_.begin("write");
+		std::ofstream ofs(outputFileName_, std::ofstream::out | std::ofstream::trunc);
+		ofs << text.str();
+		ofs.close();
+		if(!ofs)
+			throw std::runtime_error("Error writing '" + outputFileName_ + "'");
+		stats_.end(values.size(), fileBytes(outputFileName_));
+	}
+}
+
+/**	@brief	Prints the available algorithms and their capabilities */
+void Sorter::printAlgorithms() {
+	SortAlgorithm::loadPlugins(SortAlgorithm::pluginDirectory());
+
+	char line[256];
+	snprintf(line, sizeof(line), "%-12s %-7s %-9s %-9s %-11s %-14s  %s\n", "Algorithm",
+		"Stable", "In place", "Parallel", "Extra B/key", "Best size", "Description");
+	std::cout << line;
+	for(const std::string& name : SortAlgorithm::algorithms()) {
+		const SortCapabilities* caps = SortAlgorithm::capabilities(name);
+		if(caps == nullptr) {
+			snprintf(line, sizeof(line), "%-12s (no capability descriptor)\n", name.c_str());
+		}
+		else {
+			std::string range = std::to_string(caps->minKeys) + "-" +
+				(caps->maxKeys > 0 ? std::to_string(caps->maxKeys) : std::string("any"));
+			snprintf(line, sizeof(line), "%-12s %-7s %-9s %-9s %-11.1f %-14s  %s\n", name.c_str(),
+				caps->stable ? "yes" : "no", caps->inPlace ? "yes" : "no",
+				caps->parallel ? "yes" : "no", caps->extraBytesPerKey, range.c_str(),
+				caps->description);
+		}
+		std::cout << line;
+	}
+}
+
+/**	@brief	Prints per-phase statistics if -v was specified */
+void Sorter::reportStats() {
+	if(!verbose_) return;
+	stats_.print(std::cerr);
+	stats_.printSummary(std::cerr, algorithm_);
 }
 
 /**	@brief	Parse command line arguments from argc/argv
@@ -114,7 +779,26 @@ void Sorter::parseCommandLine(int argc, char** argv) {
 	//Local decl
 	int opt;
 
-	while ((opt = getopt(argc, argv, "a:f:o:cs:n:")) != -1) {
+	//Long-only options
+	enum { OptSeed = 256, OptCpus, OptKeyType, OptTop, OptNth, OptQuantiles, OptApprox, OptMerge, OptDelta, OptUnique, OptCount };
+	static const struct option longOptions[] = {
+		{ "distribution",	required_argument,	nullptr,	'd' },
+		{ "seed",					required_argument,	nullptr,	OptSeed },
+		{ "cpus",					required_argument,	nullptr,	OptCpus },
+		{ "key-type",			required_argument,	nullptr,	OptKeyType },
+		{ "top",					required_argument,	nullptr,	OptTop },
+		{ "nth",					required_argument,	nullptr,	OptNth },
+		{ "quantiles",		required_argument,	nullptr,	OptQuantiles },
+		{ "approx",				optional_argument,	nullptr,	OptApprox },
+		{ "merge",				no_argument,				nullptr,	OptMerge },
+		{ "delta",				required_argument,	nullptr,	OptDelta },
+		{ "unique",				no_argument,				nullptr,	OptUnique },
+		{ "count",				no_argument,				nullptr,	OptCount },
+		{ "help",					no_argument,				nullptr,	'h' },
+		{ nullptr,				0,									nullptr,	0 }
+	};
+
+	while ((opt = getopt_long(argc, argv, "a:f:o:cs:n:O:m:T:bd:P:j:k:lvh", longOptions, nullptr)) != -1) {
 		switch (opt) {
 			case 'a': //Parse sort algorithm to use
 				algorithm_ = std::string(optarg);
@@ -135,6 +819,79 @@ void Sorter::parseCommandLine(int argc, char** argv) {
 			case 'n': //Number of random values to generate
 				numValues_ = atol(optarg);
 				break;
+			case 'm': //Memory budget for out-of-core sort
+				memoryBudget_ = parseByteSize(optarg);
+				break;
+			case 'T': //Directory for temporary run files
+				tempDir_ = std::string(optarg);
+				break;
+			case 'b': //Binary key format for all files
+				binary_ = true;
+				break;
+			case 'd': //Distribution of generated values
+				distribution_ = parseDistribution(optarg);
+				break;
+			case 'P': //Plugin directory
+				pluginDir_ = std::string(optarg);
+				break;
+			case 'l': //List plugins and their capabilities
+				listAlgorithms_ = true;
+				break;
+			case 'v': //Per-phase statistics
+				verbose_ = true;
+				break;
+			case OptSeed: //Seed for generated values
+				seed_ = std::stoull(optarg);
+				break;
+			case 'j': //Thread limit, which also sizes the shared pool
+				sortOptions_.threads = (unsigned) std::stoul(optarg);
+				ThreadPool::setSharedThreads(sortOptions_.threads);
+				break;
+			case OptCpus: //CPUs to run on
+				sortOptions_.cpus = parseCpuList(optarg);
+				break;
+			case OptKeyType: //Type of the keys in text files
+				keyType_ = parseKeyType(optarg);
+				break;
+			case 'k': //Smallest keys only
+				selectMode_ = SelectMode::Smallest;
+				selectCount_ = std::stoull(optarg);
+				break;
+			case OptTop: //Largest keys only
+				selectMode_ = SelectMode::Largest;
+				selectCount_ = std::stoull(optarg);
+				break;
+			case OptNth: //Key at one rank only
+				selectMode_ = SelectMode::Nth;
+				selectCount_ = std::stoull(optarg);
+				break;
+			case OptQuantiles: //Quantiles only
+				quantiles_ = parseQuantiles(optarg);
+				break;
+			case OptApprox: //Estimate quantiles with a sketch
+				sketchK_ = (optarg != nullptr) ? (uint32_t) std::stoul(optarg) : KllSketch::DefaultK;
+				break;
+			case OptMerge: //Merge the sorted files given as operands
+				merge_ = true;
+				break;
+			case OptDelta: //Sort a delta and merge it into the data file
+				deltaFileName_ = std::string(optarg);
+				break;
+			case OptUnique: //Distinct keys only
+				unique_ = true;
+				break;
+			case OptCount: //Distinct keys with their counts
+				unique_ = true;
+				countKeys_ = true;
+				break;
+			case 'O': { //Algorithm tuning option, name=value
+				std::string option(optarg);
+				size_t eq = option.find('=');
+				if(eq == std::string::npos || eq == 0)
+					throw std::invalid_argument("Expected -O name=value, got: " + option);
+				algoOptions_.emplace_back(option.substr(0, eq), option.substr(eq+1));
+				break;
+			}
 			case 'h': //Print usage string to stderr
 			default:
 				std::cout << "Generate and sort an array of unsigned 64-bit integer values." << std::endl;
@@ -142,7 +899,8 @@ void Sorter::parseCommandLine(int argc, char** argv) {
 				std::cout << "   isort [OPTION]..." << std::endl << std::endl;
 				std::cout << "Options: " << std::endl;
 				std::cout << "  -a <algorithm>  The sort algorithm name - Creates an instance of the" << std::endl;
-				std::cout << "                  sorter implemented by lib<algorithm>.so." << std::endl;
+				std::cout << "                  sorter implemented by lib<algorithm>.so. 'auto' profiles the" << std::endl;
+				std::cout << "                  input and picks the algorithm that suits it." << std::endl;
 				std::cout << "  -f <file>       Specify the file that contains the unsorted data. " << std::endl;
 				std::cout << "                  If the -c argument is specified, a new dataset will be" << std::endl;
 				std::cout << "                  created and this file will be overwritten if it exists." << std::endl;
@@ -150,7 +908,50 @@ void Sorter::parseCommandLine(int argc, char** argv) {
 				std::cout << "  -c              Create a new unsorted dataset" << std::endl;
 				std::cout << "  -n <count>      The number of random values to generate when -c is specified." << std::endl;
 				std::cout << "  -s <max>        The maximum random value to generate." << std::endl;
-				std::cout << "  -v              Output additional information during processing." << std::endl;
+				std::cout << "  -O <name=value> Pass a tuning option to the algorithm (ie: digit-bits=11" << std::endl;
+				std::cout << "                  for radix). May be repeated." << std::endl;
+				std::cout << "  -m <size>       Sort out of core using at most about <size> bytes of memory" << std::endl;
+				std::cout << "                  (ie: 512M, 4G). Sorted runs are spilled to temporary files." << std::endl;
+				std::cout << "  -T <dir>        Directory for temporary files with -m (default $TMPDIR or /tmp)." << std::endl;
+				std::cout << "  -b              Read and write binary key files (little-endian uint64_t with" << std::endl;
+				std::cout << "                  a header). Implied for files ending in .bin, and for input" << std::endl;
+				std::cout << "                  files that start with the binary header." << std::endl;
+				std::cout << "  -d <dist>       Distribution of values created with -c: uniform (default)," << std::endl;
+				std::cout << "                  zipf[:skew], normal[:stddev], sorted, reverse, nearly[:swaps]," << std::endl;
+				std::cout << "                  few[:distinct], sawtooth[:run length]. -s 0 uses the full range." << std::endl;
+				std::cout << "  --seed <n>      Seed for values created with -c (default 1)." << std::endl;
+				std::cout << "  -P <dir>        Load every plugin in <dir> and search it first (default" << std::endl;
+				std::cout << "                  $ISORT_PLUGIN_DIR, else the sort library's directory)." << std::endl;
+				std::cout << "  -l              List the available algorithms and their capabilities." << std::endl;
+				std::cout << "  -j <threads>    Use at most <threads> threads for each parallel phase (default" << std::endl;
+				std::cout << "                  one per hardware thread, or per CPU given with --cpus)." << std::endl;
+				std::cout << "  --cpus <list>   Run parallel work on these CPUs only (ie: 0-3,8)." << std::endl;
+				std::cout << "  -k <count>      Output only the <count> smallest keys, in ascending order." << std::endl;
+				std::cout << "  --top <count>   Output only the <count> largest keys, largest first." << std::endl;
+				std::cout << "  --nth <rank>    Output only the key at <rank> (0 is the smallest). These modes" << std::endl;
+				std::cout << "                  select keys in a few passes rather than sorting all of them." << std::endl;
+				std::cout << "  --quantiles <l> Output only the quantiles in list <l> (ie: p50,p90,p99,p999,max)," << std::endl;
+				std::cout << "                  one 'label value' line each, by nearest rank. With -m the file" << std::endl;
+				std::cout << "                  is streamed a few times instead of loaded." << std::endl;
+				std::cout << "  --approx[=<k>]  Estimate the --quantiles in a single pass with a sketch of" << std::endl;
+				std::cout << "                  about 3*<k> keys (default 200); min and max stay exact." << std::endl;
+				std::cout << "  --merge <files> Merge already sorted files into one sorted output in a single" << std::endl;
+				std::cout << "                  streaming pass. Binary files flagged as sorted are trusted;" << std::endl;
+				std::cout << "                  others are checked as they are read." << std::endl;
+				std::cout << "  --delta <file>  Sort <file> in memory and merge it into the sorted -f file," << std::endl;
+				std::cout << "                  rather than sorting both again." << std::endl;
+				std::cout << "  --unique        Output each distinct key once. Duplicates are dropped by the" << std::endl;
+				std::cout << "                  algorithm as it places the keys (radix and counting), not by" << std::endl;
+				std::cout << "                  a separate pass." << std::endl;
+				std::cout << "  --count         As --unique, but output 'key count' lines with the number of" << std::endl;
+				std::cout << "                  occurrences of each key." << std::endl;
+				std::cout << "  --key-type <t>  Type of the keys in the text data file: u64 (default), u32," << std::endl;
+				std::cout << "                  i32, i64, f32 or f64. Signed and floating-point keys are" << std::endl;
+				std::cout << "                  sorted through an order-preserving unsigned transform." << std::endl;
+				std::cout << "  -v              Report time, keys, bytes and throughput for each phase, and" << std::endl;
+				std::cout << "                  hardware counters for the sort where the kernel allows, on" << std::endl;
+				std::cout << "                  stderr, with the choice made by the auto algorithm. Ends" << std::endl;
+				std::cout << "                  with one 'isort-stats key=value ...' line." << std::endl;
 				std::cout << "  -h              Displays this help information." << std::endl << std::endl;
 				std::cout << "Examples: " << std::endl << std::endl;
 				std::cout << "      isort -c -s 100000 -n 1000 -a radix" << std::endl << std::endl;
@@ -166,10 +967,49 @@ void Sorter::parseCommandLine(int argc, char** argv) {
 		} //switch
 	} //while
 
-	//Open input and output (if requested in args)
-	ifs_.open(dataFileName_.c_str(), std::ifstream::in);
-	if(!console_)
-		ofs_.open(outputFileName_.c_str(), std::ifstream::out);
+	//Operands are the files for --merge
+	for(int arg = optind; arg < argc; arg++) mergeFileNames_.push_back(argv[arg]);
+
+	//An explicitly configured plugin directory is scanned up front
+	const char* pluginEnv = getenv("ISORT_PLUGIN_DIR");
+	if(pluginDir_.empty() && pluginEnv != nullptr) pluginDir_ = pluginEnv;
+	if(!pluginDir_.empty()) SortAlgorithm::loadPlugins(pluginDir_);
+
+	//Data file is sniffed for the binary header unless it is about to be created
+	inputFormat_ = keyFormatFor(dataFileName_, binary_, !createData_);
+	outputFormat_ = keyFormatFor(outputFileName_, binary_, false);
+
+	//The binary format and the external sort hold u64 keys only
+	if(keyType_ != KeyType::UInt64 && (memoryBudget_ > 0 ||
+		inputFormat_ == KeyFormat::Binary || (!console_ && outputFormat_ == KeyFormat::Binary)))
+		throw std::invalid_argument(std::string("Key type ") + keyTypeName(keyType_) +
+			" is only supported for in-memory sorts of text files");
+	if(selectMode_ != SelectMode::None && (memoryBudget_ > 0 || keyType_ != KeyType::UInt64))
+		throw std::invalid_argument("-k, --top and --nth need u64 keys and an in-memory sort");
+	if(sketchK_ > 0 && quantiles_.empty())
+		throw std::invalid_argument("--approx needs --quantiles");
+	if(sketchK_ > 0 && sketchK_ < KllSketch::MinCapacity)
+		throw std::invalid_argument("--approx needs a sketch size of at least " +
+			std::to_string(KllSketch::MinCapacity));
+	if(!quantiles_.empty() && (selectMode_ != SelectMode::None || keyType_ != KeyType::UInt64))
+		throw std::invalid_argument("--quantiles needs u64 keys and cannot be combined with "
+			"-k, --top or --nth");
+	if(!quantiles_.empty() && !console_ && outputFormat_ == KeyFormat::Binary)
+		throw std::invalid_argument("--quantiles writes text output only");
+	if(merge_ && mergeFileNames_.empty())
+		throw std::invalid_argument("--merge needs the sorted files to merge");
+	if(merge_ && !deltaFileName_.empty())
+		throw std::invalid_argument("--merge and --delta cannot be combined");
+	if((merge_ || !deltaFileName_.empty()) && (createData_ || keyType_ != KeyType::UInt64 ||
+		selectMode_ != SelectMode::None || !quantiles_.empty()))
+		throw std::invalid_argument("--merge and --delta need u64 keys and cannot be combined "
+			"with -c, -k, --top, --nth or --quantiles");
+	if(unique_ && (memoryBudget_ > 0 || keyType_ != KeyType::UInt64 || merge_ ||
+		!deltaFileName_.empty() || selectMode_ != SelectMode::None || !quantiles_.empty()))
+		throw std::invalid_argument("--unique and --count need u64 keys and an in-memory sort, "
+			"and cannot be combined with other output modes");
+	if(countKeys_ && !console_ && outputFormat_ == KeyFormat::Binary)
+		throw std::invalid_argument("--count writes text output only");
 
 	return;
 }
@@ -179,103 +1019,78 @@ void Sorter::parseCommandLine(int argc, char** argv) {
 	*	TODO: Bounds checking for data array
 	*/
 void Sorter::generateData() {
-	//Locals
-	IntArrayConstIterator_t itr;
-
 	//Output
-	std::cout << "Generating array data of " << numValues_ << " values between 0 and " <<
-		dataMax_ << std::endl;
-
-	//Open file for writing data
-	FILE* fp = fopen(dataFileName_.c_str(), "w+");
-	if(!fp) {
-		//Everything is fatal here really...
-		//TODO: ... Still, we can do better than const char* exception?
-		std::string msg = std::string("Unable to open output file: ")
-			+ dataFileName_;
-		throw msg;
-	}
-
-	//Declare unsorted array of integer values
-	IntArray_t array(numValues_);
-
-	//Lambda function def for generate()ing random values
-	auto f = [=]() -> uint64_t {
-		return rand() % dataMax_;
-	};
+	std::cout << "Generating array data of " << numValues_ << " " <<
+		distributionName(distribution_.type) << " values between 0 and " << dataMax_ <<
+		" (seed " << seed_ << ")" << std::endl;
 
-	//Populate array
-	//TODO: Batch this rather than storing the whole thing in ram? Probably
-	//	need a reasonable MAX_VALUE for numValues_ in the meantime...
-	array.resize(numValues_);
-	std::generate(array.begin(), array.end(), f);
-
-	//Write data to file
-	for(itr = array.begin(); itr != array.end(); itr++) {
-		fprintf(fp, "%lu\n", *itr);
-	}
-
-	//Close
-	fflush(fp);
-	fclose(fp);
+	//Stream blocks straight to the file; the dataset is never held in memory
+	DataGenerator generator(distribution_, numValues_, dataMax_, seed_);
+	KeyWriter writer(dataFileName_, inputFormat_);
+	generator.generate(writer);
+	writer.close();
 }
 
-/**	@brief	Reads integer data from the input/output file
+/**	@brief	Reads integer data from a text data file
  *	@returns	An array (std::vector<uint64_t>) of values as read from file.
  *	@throws	exception On error reading data.
  */
 IntArray_t Sorter::readData() {
-	//Declare input stream for data file
-	//std::ifstream ifs(dataFileName_.c_str(), std::ifstream::in);
-
-	//Populate array data from file using line reader and close
-	IntArray_t array(std::istream_iterator<FileLine>{ifs_},
-		std::istream_iterator<FileLine>{});
-	ifs_.close();
+	//Parse text in parallel straight into a presized array
+	IntArray_t array;
+	TextKeyParser parser;
+	parser.parseFile(dataFileName_, array);
+	reportBadLines(parser.badLines(), parser.errors());
 
 	//Return array data
 	return array;
 }
 
-/**	@brief	Print the contents of the array
- *	@param	label	Text to print before the array
- *	@param	array	The array to output
+/**	@brief	Warns about malformed lines skipped while reading the data file
+ *	@param	badLines	Number of lines skipped
+ *	@param	errors		The first few malformed lines
  */
-void Sorter::printArrayToConsole(const std::string& label, const IntArray_t& array) {
-	bool first = true;
-	IntArrayConstIterator_t itr;
-	//std::cout << label;
-	for(itr = array.begin(); itr != array.end(); itr++) {
-		//Output CR/LF or LF if not first value
-		if(first)
-			first = false;
-		else
-			std::cout << std::endl;
+void Sorter::reportBadLines(uint64_t badLines, const std::vector<ParseError>& errors) {
+	if(badLines == 0) return;
 
-		//Output value
-		std::cout << *(itr);
-	}
-	std::cout << std::endl;
+	std::cerr << "Skipped " << badLines << " malformed line(s) in '" <<
+		dataFileName_ << "'" << std::endl;
+	for(const ParseError& error : errors)
+		std::cerr << "  line " << error.line << ": '" << error.text << "'" << std::endl;
+	if(badLines > errors.size())
+		std::cerr << "  ..." << std::endl;
 }
 
-/**
- *
+/**	@brief	Print the contents of the array, one key per line
+ *	@param	keys	The keys to output
+ *	@param	count	Number of keys
  */
-void Sorter::writeArrayToFile(const IntArray_t& array) {
-	bool first = true;
-	IntArrayConstIterator_t itr;
-
-	for(itr = array.begin(); ofs_.is_open() && itr != array.end(); itr++) {
-		//Output CR/LF or LF if not first value
-		if(first)
-			first = false;
-		else
-			ofs_ << std::endl;
+void Sorter::printArrayToConsole(const uint64_t* keys, size_t count) {
+	//Keep earlier messages ahead of the values
+	std::cout.flush();
 
-		//Output value
-		ofs_ << *(itr);
+	KeyWriter writer("-", KeyFormat::Text);
+	writer.write(keys, count);
+	writer.close();
+}
+
+/** @brief	Writes The contents of the array specified to a file.
+ *	@param	keys		The keys to write to an output file
+ *	@param	count		Number of keys
+ *	@param	sorted	True if the keys are in ascending order
+ */
+void Sorter::writeArrayToFile(const uint64_t* keys, size_t count, bool sorted) {
+	if(console_) return;
+
+	//Binary output is a single large write
+	if(outputFormat_ == KeyFormat::Binary) {
+		writeBinaryKeys(outputFileName_, keys, count, sorted);
+		return;
 	}
-	ofs_ << std::endl;
+
+	KeyWriter writer(outputFileName_, KeyFormat::Text);
+	writer.write(keys, count);
+	writer.close();
 }
 
 }; //End namespace
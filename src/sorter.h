@@ -23,33 +23,33 @@
 #include <string>
 #include <vector>
 #include <iostream>
-#include <sstream>
-#include <fstream>
 //Project includes
 #include "sortalgorithm.h"
+#include "keystream.h"
+#include "generator.h"
+#include "stats.h"
+#include "keytraits.h"
+#include "quantiles.h"
 
 namespace JAC::Integer {
 
-/**	@brief	Line reader class for data file */
-class FileLine {
-private:
-	std::string data_;
-public:
-	operator uint64_t() const {
-		if(data_.length() > 0) return std::stoull(data_);
-		else return 0UL;
-	}
-	friend std::istream& operator>>(std::istream& strm, FileLine& fileline) {
-		return std::getline(strm, fileline.data_);
-	}
-};
-
 /**	@brief	Typedefs for vector of unsigned ints
  *	Type definitions used by API
  */
 typedef std::vector<uint64_t> IntArray_t;
 typedef IntArray_t::const_iterator IntArrayConstIterator_t;
 
+/**	@brief	Partial results produced instead of a full sort */
+enum class SelectMode {
+	None,					/*! Sort and output every key */
+	Smallest,			/*! The k smallest keys, ascending (-k) */
+	Largest,			/*! The k largest keys, descending (--top) */
+	Nth						/*! The key at one rank (--nth) */
+};
+
+/**	@brief	Algorithm tuning options as name/value pairs */
+typedef std::vector<std::pair<std::string, std::string>> AlgoOptions_t;
+
 /**	@brief	64-bit integer sort driver class
  *	Sorts an arbitrary-length array (std::vector<uint64_t>) of values,
  *	optionally generated. Sorting is accomplished using a specified algorithm,
@@ -71,11 +71,33 @@ typedef IntArray_t::const_iterator IntArrayConstIterator_t;
  *		num values:		1000
  *
  *	Arguments:
- *		-a						Sort algorithm to use (ie: radix, bubble, etc).
+ *		-a						Sort algorithm to use (ie: radix, bubble, auto, etc).
  *		-f						Data file to read/write. -c will cause the file to be created.
  *		-c						Crate the data file, overwriting the existing file if it exists.
  *		-s						The max size for random values created (only value for -c).
  *		-n						The number of values to create (only valid for -c).
+ *		-O						Algorithm tuning option as name=value (ie: digit-bits=11).
+ *		-m						Memory budget (ie: 512M, 4G). Sorts out of core within the budget.
+ *		-T						Directory for temporary run files when -m is specified.
+ *		-b						Read and write the binary key format. Files ending in .bin, and
+ *									input files starting with the binary magic, use it regardless.
+ *		-d						Distribution of created values (ie: zipf:1.2, nearly:100).
+ *		--seed				Seed for created values; the same seed recreates the same data.
+ *		-v						Per-phase timing and hardware counters, reported on stderr.
+ *		-P						Plugin directory, scanned at startup (or $ISORT_PLUGIN_DIR).
+ *		-l						List the available algorithms and their capabilities.
+ *		-j						Most threads for each parallel phase; also sizes the shared pool.
+ *		--cpus				CPUs to run on (ie: 0-3,8).
+ *		--key-type		Type of the keys in text files (u32, u64, i32, i64, f32, f64).
+ *		-k						Output only the k smallest keys, without a full sort.
+ *		--top					Output only the k largest keys, largest first.
+ *		--nth					Output only the key at a rank, counting from 0.
+ *		--quantiles		Output only the listed quantiles (ie: p50,p99,p999), exactly.
+ *		--approx			Estimate --quantiles in one pass with a sketch of the given size.
+ *		--merge				Merge the sorted files named as operands instead of sorting.
+ *		--delta				Sort this file and merge it into the sorted -f file.
+ *		--unique			Output each distinct key once, dropping duplicates during the sort.
+ *		--count				As --unique, with the number of occurrences of each key.
  *
  */
 class Sorter {
@@ -85,6 +107,7 @@ class Sorter {
 	const std::string DefaultAlgo							= "radix";
 	const uint64_t 		DefaultDataMax 					= 1000;
 	const uint64_t 		DefaultNumValues 				= 1000;
+	const uint64_t		DefaultSeed							= 1;
 
 public:
 	/**	@brief	Default constructor */
@@ -104,11 +127,17 @@ public:
 	 */
 	inline const std::string& algorithm() const { return algorithm_; }
 
+	/**	@brief	Describes what the last sort() did, for reporting its time
+	 *	@return	A phrase such as "Sorted using 'radix' algorithm", empty when
+	 *		only the algorithms were listed
+	 */
+	std::string summary() const;
+
 	/**	@brief	Sort values in array. Array data is overwritten.
-	 *	@return An array containing sorted values
+	 *	@return The number of keys sorted
 	 *	@throws	exception On error initializing driver or performing sort.
 	 */
-	virtual IntArray_t sort();
+	virtual uint64_t sort();
 
 protected:
 	/**	@brief	Parse command line arguments from argc/argv
@@ -119,27 +148,108 @@ protected:
 	virtual void parseCommandLine(int argc, char** argv);
 
 private:
+	/**	@brief	Creates the selected algorithm and applies tuning options
+	 *	@return	A sorter instance, to be released with SortAlgorithm::destroy()
+	 *	@throws	exception On error loading the algorithm or an unsupported option
+	 */
+	SortAlgorithm* createAlgorithm();
+
+	/**	@brief	Sorts the data file out of core within the memory budget
+	 *	@return	The number of keys sorted
+	 *	@throws	exception On error sorting or on I/O errors
+	 */
+	uint64_t sortExternal();
+
+	/**	@brief	Merges sorted files (--merge), or a delta into a sorted base (--delta)
+	 *	@return	The number of keys written
+	 *	@throws	exception On error sorting the delta, unsorted input or I/O errors
+	 */
+	uint64_t mergeFiles();
+
+	/**	@brief	Sorts a text data file of --key-type keys in memory
+	 *	@return	The number of keys sorted
+	 *	@throws	exception On error sorting or on I/O errors
+	 */
+	uint64_t sortTyped();
+
+	/**	@brief	Outputs the -k, --top or --nth selection from loaded keys
+	 *	@param	keys	The keys; not modified
+	 *	@param	count	Number of keys
+	 *	@return	The number of keys output
+	 *	@throws	exception On error selecting or on I/O errors
+	 */
+	uint64_t select(const uint64_t* keys, size_t count);
+
+	/**	@brief	Sorts loaded keys and outputs each distinct key once (--unique, --count)
+	 *	@param	keys	The keys; the distinct keys are left at the front
+	 *	@param	count	Number of keys
+	 *	@return	The number of distinct keys
+	 *	@throws	exception On error sorting or on I/O errors
+	 */
+	uint64_t sortDistinct(uint64_t* keys, size_t count);
+
+	/**	@brief	Outputs the --quantiles of loaded keys, selected exactly
+	 *	@param	keys	The keys; not modified
+	 *	@param	count	Number of keys
+	 *	@return	The number of keys the quantiles describe
+	 *	@throws	exception On error selecting or on I/O errors
+	 */
+	uint64_t selectQuantiles(const uint64_t* keys, size_t count);
+
+	/**	@brief	Outputs the --quantiles of the data file, streamed in bounded memory
+	 *	@return	The number of keys the quantiles describe
+	 *	@throws	exception On error reading the file or on I/O errors
+	 */
+	uint64_t streamQuantiles();
+
+	/**	@brief	Prints or writes one "label value" line per quantile
+	 *	@param	values	One key per entry of quantiles_
+	 *	@throws	exception On I/O errors
+	 */
+	void outputQuantiles(const std::vector<uint64_t>& values);
+
+	/**	@brief	Reads, sorts and writes keys of one type
+	 *	@return	The number of keys sorted
+	 *	@throws	exception On error sorting or on I/O errors
+	 */
+	template<typename Key>
+	uint64_t sortKeysAs();
+
+	/**	@brief	Prints per-phase statistics if -v was specified */
+	void reportStats();
+
+	/**	@brief	Prints the available algorithms and their capabilities */
+	void printAlgorithms();
+
+	/**	@brief	Warns about malformed lines skipped while reading the data file
+	 *	@param	badLines	Number of lines skipped
+	 *	@param	errors		The first few malformed lines
+	 */
+	void reportBadLines(uint64_t badLines, const std::vector<ParseError>& errors);
+
 	/**	@brief	Writes data to file according to data max and num values
 	 *	@throws exception On error generating data or writing file
 	 */
 	void generateData();
 
-	/**	@brief	Reads integer data from the input/output file
+	/**	@brief	Reads integer data from a text data file
 	 *	@returns	An array (std::vector<uint64_t>) of values as read from file.
 	 *	@throws	exception On error reading data.
 	 */
 	IntArray_t readData();
 
-	/**	@brief	Print the contents of the array
-	 *	@param	label	Text to print before the array
-	 *	@param	array	The array to output
+	/**	@brief	Print the contents of the array, one key per line
+	 *	@param	keys	The keys to output
+	 *	@param	count	Number of keys
 	 */
-	void printArrayToConsole(const std::string& label, const IntArray_t& array);
+	void printArrayToConsole(const uint64_t* keys, size_t count);
 
 	/** @brief	Writes The contents of the array specified to a file.
-	 *	@param	array  The array to write to an output file
+	 *	@param	keys		The keys to write to an output file
+	 *	@param	count		Number of keys
+	 *	@param	sorted	True if the keys are in ascending order
 	 */
-	void writeArrayToFile(const IntArray_t& array);
+	void writeArrayToFile(const uint64_t* keys, size_t count, bool sorted = true);
 
 	/** @brief  Prints the specified array to the output stream
 	 *  @param  out The output stream to which the array will be written
@@ -155,12 +265,34 @@ private:
 	std::string 	algorithm_;			/*! Sort algorithm to use */
 	std::string		dataFileName_;	/*! Name of the input/output file for data */
 	std::string		outputFileName_;/*! The name of the file to which we write sorted values */
-	std::ifstream ifs_;						/*! The input file stream for data */
-	std::ofstream ofs_;						/*! The output file stream if writing sorted data to file */
 	bool					createData_;		/*! True if generating new data */
 	uint64_t			dataMax_;				/*! Maximum random value to gen */
 	uint64_t			numValues_;			/*! Number of values to generate */
 	bool					console_;				/*!	Print output to console? */
+	AlgoOptions_t	algoOptions_;		/*! Tuning options passed to the algorithm */
+	uint64_t			memoryBudget_;	/*! Memory budget for external sort, 0 for in-memory */
+	std::string		tempDir_;				/*! Directory for external sort run files */
+	bool					binary_;				/*! Force the binary key format for all files */
+	KeyFormat			inputFormat_;		/*! Format of the data file */
+	KeyFormat			outputFormat_;	/*! Format of the output file */
+	bool					inputSorted_;		/*! Data file header says the keys are sorted */
+	DistributionSpec	distribution_;	/*! Distribution of generated values */
+	uint64_t			seed_;					/*! Seed for generated values */
+	bool					verbose_;				/*! Report per-phase statistics */
+	SortStats			stats_;					/*! Per-phase statistics */
+	std::string		pluginDir_;			/*! Plugin directory to scan, if any */
+	bool					listAlgorithms_;	/*! List plugins rather than sort */
+	SortOptions		sortOptions_;		/*! Thread and CPU limits (-j, --cpus) */
+	KeyType				keyType_;				/*! Type of the keys (--key-type) */
+	SelectMode		selectMode_;		/*! Partial result wanted, if any */
+	uint64_t			selectCount_;		/*! Keys wanted (-k, --top) or rank (--nth) */
+	std::vector<Quantile>	quantiles_;	/*! Quantiles wanted (--quantiles), if any */
+	uint32_t			sketchK_;				/*! Sketch size for --approx, 0 for exact */
+	bool					merge_;					/*! Merge sorted files rather than sort */
+	std::vector<std::string>	mergeFileNames_;	/*! Sorted files to merge (--merge) */
+	std::string		deltaFileName_;	/*! Keys to merge into the data file (--delta) */
+	bool					unique_;				/*! Output distinct keys only (--unique, --count) */
+	bool					countKeys_;			/*! Output each distinct key's count (--count) */
 };
 
 }; //End namespace
@@ -0,0 +1,228 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+//Library includes
+#include <cstdio>
+#include <cstring>
+//Project includes
+#include "stats.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Construct with no counters open */
+PerfCounters::PerfCounters() {
+	std::memset(values_, 0, sizeof(values_));
+	for(int& fd : fds_) fd = -1;
+}
+
+/**	@brief	Opens the counters, disabled
+ *	@return	True if at least one counter could be opened
+ */
+bool PerfCounters::open() {
+#ifdef __linux__
+	static const struct { uint32_t type; uint64_t config; } events[CounterCount] = {
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			(PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+	};
+
+	for(int counter = 0; counter < CounterCount; counter++) {
+		struct perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = events[counter].type;
+		attr.config = events[counter].config;
+		attr.disabled = 1;
+		attr.inherit = 1;				//Include plugin worker threads
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		if(fds_[counter] < 0)
+			fds_[counter] = (int) ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+#endif
+	return available();
+}
+
+/**	@brief	Destructor, closes the counters */
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+	for(int fd : fds_) {
+		if(fd >= 0) ::close(fd);
+	}
+#endif
+}
+
+/**	@brief	Resets and enables all counters */
+void PerfCounters::start() {
+#ifdef __linux__
+	for(int fd : fds_) {
+		if(fd < 0) continue;
+		::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+/**	@brief	Disables all counters and reads their values */
+void PerfCounters::stop() {
+#ifdef __linux__
+	for(int counter = 0; counter < CounterCount; counter++) {
+		int fd = fds_[counter];
+		if(fd < 0) continue;
+		::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		uint64_t value = 0;
+		if(::read(fd, &value, sizeof(value)) == (ssize_t) sizeof(value))
+			values_[counter] = value;
+	}
+#endif
+}
+
+/**	@brief	True if at least one counter is open */
+bool PerfCounters::available() const {
+	for(int fd : fds_) {
+		if(fd >= 0) return true;
+	}
+	return false;
+}
+
+/**	@brief	Short name of a counter (ie: cycles) */
+const char* PerfCounters::name(Counter counter) {
+	static const char* names[CounterCount] = {
+		"cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"
+	};
+	return names[counter];
+}
+
+/**	@brief	Construct an empty set of statistics */
+SortStats::SortStats() {
+}
+
+/**	@brief	Destructor */
+SortStats::~SortStats() {
+}
+
+/**	@brief	Starts timing a phase
+ *	@param	name	The phase name
+ */
+void SortStats::begin(const std::string& name) {
+	current_ = name;
+	start_ = std::chrono::steady_clock::now();
+}
+
+/**	@brief	Finishes the phase started by begin()
+ *	@param	keys	Keys processed
+ *	@param	bytes	Bytes processed
+ */
+void SortStats::end(uint64_t keys, uint64_t bytes) {
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+	phases_.push_back({ current_, seconds, keys, bytes });
+}
+
+/**	@brief	Prints a table of phases and counters
+ *	@param	out	The stream to print to
+ */
+void SortStats::print(std::ostream& out) const {
+	char line[160];
+	double total = 0;
+
+	snprintf(line, sizeof(line), "%-10s %12s %14s %12s %10s %10s\n", "Phase", "Seconds",
+		"Keys", "MB", "MB/s", "Mkeys/s");
+	out << line;
+	for(const PhaseStat& phase : phases_) {
+		double seconds = (phase.seconds > 0) ? phase.seconds : 1e-9;
+		snprintf(line, sizeof(line), "%-10s %12.6f %14lu %12.1f %10.1f %10.2f\n",
+			phase.name.c_str(), phase.seconds, phase.keys, phase.bytes / 1e6,
+			phase.bytes / 1e6 / seconds, phase.keys / 1e6 / seconds);
+		out << line;
+		total += phase.seconds;
+	}
+	snprintf(line, sizeof(line), "%-10s %12.6f\n", "total", total);
+	out << line;
+
+	if(!metrics_.empty()) {
+		out << "Algorithm metrics:" << std::endl;
+		for(const auto& metric : metrics_) {
+			snprintf(line, sizeof(line), "  %-14s %16.6g\n", metric.first.c_str(), metric.second);
+			out << line;
+		}
+	}
+
+	if(counterPhase_.empty()) return;
+	if(!counters_.available()) {
+		out << "Hardware counters unavailable (see /proc/sys/kernel/perf_event_paranoid)" <<
+			std::endl;
+		return;
+	}
+
+	out << "Counters for the " << counterPhase_ << " phase:" << std::endl;
+	for(int counter = 0; counter < PerfCounters::CounterCount; counter++) {
+		PerfCounters::Counter id = (PerfCounters::Counter) counter;
+		if(!counters_.available(id)) continue;
+		snprintf(line, sizeof(line), "  %-14s %16lu\n", PerfCounters::name(id), counters_.value(id));
+		out << line;
+	}
+	if(counters_.available(PerfCounters::Cycles) && counters_.available(PerfCounters::Instructions) &&
+		counters_.value(PerfCounters::Cycles) > 0) {
+		snprintf(line, sizeof(line), "  %-14s %16.2f\n", "ipc",
+			(double) counters_.value(PerfCounters::Instructions) / counters_.value(PerfCounters::Cycles));
+		out << line;
+	}
+}
+
+/**	@brief	Prints a single line of key=value pairs
+ *	@param	out				The stream to print to
+ *	@param	algorithm	The algorithm name, included in the line
+ */
+void SortStats::printSummary(std::ostream& out, const std::string& algorithm) const {
+	char value[64];
+	double total = 0;
+
+	out << "isort-stats algorithm=" << algorithm;
+	for(const PhaseStat& phase : phases_) {
+		snprintf(value, sizeof(value), "%.6f", phase.seconds);
+		out << " " << phase.name << "_s=" << value << " " << phase.name << "_keys=" <<
+			phase.keys << " " << phase.name << "_bytes=" << phase.bytes;
+		total += phase.seconds;
+	}
+	snprintf(value, sizeof(value), "%.6f", total);
+	out << " total_s=" << value;
+
+	for(const auto& metric : metrics_) {
+		snprintf(value, sizeof(value), "%.6g", metric.second);
+		out << " " << metric.first << "=" << value;
+	}
+
+	for(int counter = 0; !counterPhase_.empty() && counter < PerfCounters::CounterCount; counter++) {
+		PerfCounters::Counter id = (PerfCounters::Counter) counter;
+		if(counters_.available(id))
+			out << " " << PerfCounters::name(id) << "=" << counters_.value(id);
+	}
+	out << std::endl;
+}
+
+}; //End namespace
@@ -0,0 +1,165 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _STATS_INCLUDED
+#define _STATS_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace JAC::Integer {
+
+/**	@brief	Hardware performance counters for the calling process
+ *	Counts cycles, instructions, last-level cache misses, branch misses and
+ *	data TLB misses through perf_event_open(2), user space only, including
+ *	threads started while counting. Each counter is opened on its own so
+ *	that the rest still work when one is unsupported. Until open() succeeds,
+ *	or where the kernel or platform does not allow counting, available() is
+ *	false and start() and stop() do nothing.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class PerfCounters {
+public:
+	//The counters, in the order of values()
+	enum Counter { Cycles, Instructions, CacheMisses, BranchMisses, TlbMisses, CounterCount };
+
+public:
+	/**	@brief	Construct with no counters open */
+	PerfCounters();
+
+	/**	@brief	Destructor, closes the counters */
+	virtual ~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	/**	@brief	Opens the counters, disabled
+	 *	@return	True if at least one counter could be opened
+	 */
+	bool open();
+
+	/**	@brief	Resets and enables all counters */
+	void start();
+
+	/**	@brief	Disables all counters and reads their values */
+	void stop();
+
+	/**	@brief	True if at least one counter is open */
+	bool available() const;
+
+	/**	@brief	True if the specified counter is open */
+	inline bool available(Counter counter) const { return fds_[counter] >= 0; }
+
+	/**	@brief	Value of a counter from the last start()/stop() */
+	inline uint64_t value(Counter counter) const { return values_[counter]; }
+
+	/**	@brief	Short name of a counter (ie: cycles) */
+	static const char* name(Counter counter);
+
+private:
+	int				fds_[CounterCount];			/*! Counter file descriptors, -1 if unavailable */
+	uint64_t	values_[CounterCount];	/*! Values read at stop() */
+};
+
+/**	@brief	Wall time and volume of one processing phase */
+struct PhaseStat {
+	std::string	name;				/*! Phase name (ie: read, sort) */
+	double			seconds;		/*! Wall time */
+	uint64_t		keys;				/*! Keys processed */
+	uint64_t		bytes;			/*! Bytes read, written or sorted */
+};
+
+/**	@brief	Per-phase timing for a sort run
+ *	Phases are timed with begin()/end() around each step. The phase that
+ *	runs the plugin may also be sampled with the hardware counters, opened
+ *	through counters(), and annotated with the plugin's own metrics.
+ *	Results are printed as a table, and as one machine-readable line of
+ *	key=value pairs prefixed with "isort-stats".
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class SortStats {
+public:
+	/**	@brief	Construct an empty set of statistics */
+	SortStats();
+
+	/**	@brief	Destructor */
+	virtual ~SortStats();
+
+	/**	@brief	Starts timing a phase
+	 *	@param	name	The phase name
+	 */
+	void begin(const std::string& name);
+
+	/**	@brief	Finishes the phase started by begin()
+	 *	@param	keys	Keys processed
+	 *	@param	bytes	Bytes processed
+	 */
+	void end(uint64_t keys, uint64_t bytes);
+
+	/**	@brief	The phases recorded so far, in order */
+	inline const std::vector<PhaseStat>& phases() const { return phases_; }
+
+	/**	@brief	Hardware counters for the phase that runs the plugin */
+	inline PerfCounters& counters() { return counters_; }
+
+	/**	@brief	Starts the hardware counters for the phase in progress */
+	inline void startCounters() { counters_.start(); }
+
+	/**	@brief	Stops the hardware counters, crediting the phase in progress */
+	inline void stopCounters() {
+		counters_.stop();
+		counterPhase_ = current_;
+	}
+
+	/**	@brief	Records measurements reported by the plugin
+	 *	@param	metrics	Name/value pairs, in report order
+	 */
+	inline void setMetrics(const std::vector<std::pair<std::string, double>>& metrics) {
+		metrics_ = metrics;
+	}
+
+	/**	@brief	Prints a table of phases, counters and plugin metrics
+	 *	@param	out	The stream to print to
+	 */
+	void print(std::ostream& out) const;
+
+	/**	@brief	Prints a single line of key=value pairs
+	 *	@param	out				The stream to print to
+	 *	@param	algorithm	The algorithm name, included in the line
+	 */
+	void printSummary(std::ostream& out, const std::string& algorithm) const;
+
+private:
+	std::vector<PhaseStat>	phases_;	/*! Completed phases */
+	std::string							current_;	/*! Name of the phase in progress */
+	std::chrono::steady_clock::time_point	start_;	/*! Start of the phase in progress */
+	PerfCounters						counters_;	/*! Counters for the plugin's phase */
+	std::string							counterPhase_;	/*! Phase counted by counters_, if any */
+	std::vector<std::pair<std::string, double>>	metrics_;	/*! Plugin metrics */
+};
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,118 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+//Project includes
+#include "textformat.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+//"00" through "99"
+static const char DigitPairs[201] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/**	@brief	Formats keys as newline-terminated decimal text
+ *	@param	keys	The keys to format
+ *	@param	count	Number of keys
+ *	@param	out		Destination, at least count * MaxTextKeyBytes bytes
+ *	@return	Number of bytes written to out
+ */
+size_t formatKeys(const uint64_t* keys, size_t count, char* out) {
+	char* pos = out;
+	const char* prev = nullptr;
+	size_t prevLength = 0;
+	uint64_t prevHigh = 0;
+
+	for(size_t idx = 0; idx < count; idx++) {
+		uint64_t value = keys[idx];
+		uint64_t high = value / 10000;
+		size_t length;
+
+		if(prev != nullptr && high == prevHigh && high != 0) {
+			//Same leading digits as the previous key; rewrite the last four
+			uint32_t low = (uint32_t) (value - high * 10000);
+			length = prevLength;
+			std::memcpy(pos, prev, length - 4);
+			std::memcpy(pos + length - 4, DigitPairs + (low / 100) * 2, 2);
+			std::memcpy(pos + length - 2, DigitPairs + (low % 100) * 2, 2);
+		}
+		else {
+			length = std::to_chars(pos, pos + MaxTextKeyBytes, value).ptr - pos;
+			prevHigh = high;
+		}
+
+		prev = pos;
+		prevLength = length;
+		pos[length] = '\n';
+		pos += length + 1;
+	}
+	return pos - out;
+}
+
+/**	@brief	Construct with a thread count
+ *	@param	threads	Number of threads to use, 0 for the default
+ */
+TextKeyFormatter::TextKeyFormatter(unsigned threads) :
+	threads_(threads)
+	{}
+
+/**	@brief	Destructor */
+TextKeyFormatter::~TextKeyFormatter() {
+}
+
+/**	@brief	Formats keys and passes the text to a sink
+ *	@param	keys	The keys to format
+ *	@param	count	Number of keys
+ *	@param	sink	Called with each block of text, in order
+ */
+void TextKeyFormatter::format(const uint64_t* keys, size_t count, const Sink_t& sink) {
+	if(count == 0) return;
+
+	size_t threads = (threads_ > 0) ? threads_ : defaultThreads();
+	threads = std::max<size_t>(1, std::min(threads, count / MinKeysPerThread));
+	size_t roundKeys = ChunkKeys * threads;
+
+	buffers_.resize(threads);
+	for(std::vector<char>& buffer : buffers_)
+		buffer.resize(std::min(count, ChunkKeys) * MaxTextKeyBytes);
+
+	std::vector<size_t> bytes(threads, 0);
+	for(size_t done = 0; done < count; done += roundKeys) {
+		size_t round = std::min(count - done, roundKeys);
+		size_t slice = (round + threads - 1) / threads;
+
+		parallelFor(threads, [&](unsigned tid) {
+			size_t begin = std::min(tid * slice, round);
+			size_t end = std::min(begin + slice, round);
+			bytes[tid] = formatKeys(keys + done + begin, end - begin, buffers_[tid].data());
+		});
+
+		for(size_t tid = 0; tid < threads; tid++) {
+			if(bytes[tid] > 0) sink(buffers_[tid].data(), bytes[tid]);
+		}
+	}
+}
+
+}; //End namespace
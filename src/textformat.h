@@ -0,0 +1,86 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _TEXTFORMAT_INCLUDED
+#define _TEXTFORMAT_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace JAC::Integer {
+
+//Longest decimal uint64_t plus its newline
+static const size_t MaxTextKeyBytes = 21;
+
+/**	@brief	Formats keys as newline-terminated decimal text
+ *	Runs of keys that share all but their last four digits, which is the
+ *	common case in sorted output, reuse the previous key's text and only
+ *	rewrite the low digits.
+ *	@param	keys	The keys to format
+ *	@param	count	Number of keys
+ *	@param	out		Destination, at least count * MaxTextKeyBytes bytes
+ *	@return	Number of bytes written to out
+ */
+size_t formatKeys(const uint64_t* keys, size_t count, char* out);
+
+/**	@brief	Multithreaded formatter for newline-separated text key output
+ *	Keys are formatted in rounds: each thread formats a slice of the round
+ *	into its own buffer, then the buffers are handed to the sink in order, so
+ *	output is written with a few large writes and is identical to formatting
+ *	the keys one at a time.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class TextKeyFormatter {
+public:
+	//Receives formatted text, in order
+	typedef std::function<void(const char*, size_t)> Sink_t;
+
+	//Keys formatted by each thread per round
+	static constexpr size_t ChunkKeys = 1 << 17;
+
+	//Smallest slice worth giving its own thread
+	static constexpr size_t MinKeysPerThread = 1 << 16;
+
+public:
+	/**	@brief	Construct with a thread count
+	 *	@param	threads	Number of threads to use, 0 for the default
+	 */
+	explicit TextKeyFormatter(unsigned threads = 0);
+
+	/**	@brief	Destructor */
+	virtual ~TextKeyFormatter();
+
+	/**	@brief	Formats keys and passes the text to a sink
+	 *	@param	keys	The keys to format
+	 *	@param	count	Number of keys
+	 *	@param	sink	Called with each block of text, in order
+	 */
+	void format(const uint64_t* keys, size_t count, const Sink_t& sink);
+
+private:
+	unsigned											threads_;		/*! Thread count, 0 for the default */
+	std::vector<std::vector<char>>	buffers_;		/*! One output buffer per thread */
+};
+
+}; //End namespace
+
+#endif //Include once
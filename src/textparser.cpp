@@ -0,0 +1,326 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+//Library includes
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+//Project includes
+#include "textparser.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+/**	@brief	True for the whitespace characters accepted around a value */
+static inline bool isBlank(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**	@brief	Loads eight bytes with the first byte in the lowest position */
+static inline uint64_t loadEight(const char* data) {
+	uint64_t chunk;
+	std::memcpy(&chunk, data, sizeof(chunk));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	chunk = __builtin_bswap64(chunk);
+#endif
+	return chunk;
+}
+
+/**	@brief	True if all eight bytes are ASCII digits */
+static inline bool isEightDigits(uint64_t chunk) {
+	return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+		(((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+		0x3333333333333333ULL;
+}
+
+/**	@brief	Converts eight ASCII digits to their value with three multiplies */
+static inline uint64_t convertEightDigits(uint64_t chunk) {
+	chunk -= 0x3030303030303030ULL;
+	chunk = (chunk * 10) + (chunk >> 8);
+	chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+		(((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+	return chunk;
+}
+
+/**	@brief	Parses a run of decimal digits
+ *	@param	pos		First byte; advanced past the digits consumed
+ *	@param	end		One past the last byte available
+ *	@param	value	Receives the value of the digits
+ *	@return	False if the value does not fit in 64 bits
+ */
+static inline bool parseDigits(const char*& pos, const char* end, uint64_t& value) {
+	uint64_t result = 0;
+
+	//Eight digits at a time while they last
+	while(end - pos >= 8) {
+		uint64_t chunk = loadEight(pos);
+		if(!isEightDigits(chunk)) break;
+		if(__builtin_mul_overflow(result, 100000000ULL, &result) ||
+			__builtin_add_overflow(result, convertEightDigits(chunk), &result))
+			return false;
+		pos += 8;
+	}
+	while(pos < end && (unsigned char) (*pos - '0') < 10) {
+		if(__builtin_mul_overflow(result, 10ULL, &result) ||
+			__builtin_add_overflow(result, (uint64_t) (*pos - '0'), &result))
+			return false;
+		pos++;
+	}
+
+	value = result;
+	return true;
+}
+
+/**	@brief	Parses one line of a text key file
+ *	@param	begin	First byte of the line
+ *	@param	end		One past the last byte, excluding the newline
+ *	@param	value	Receives the parsed value
+ *	@return	False if the line is malformed
+ */
+bool parseKeyLine(const char* begin, const char* end, uint64_t& value) {
+	//CRLF line endings
+	if(begin < end && end[-1] == '\r') end--;
+	if(begin == end) {
+		value = 0;
+		return true;
+	}
+
+	while(begin < end && isBlank(*begin)) begin++;
+	if(begin < end && *begin == '+') begin++;
+
+	const char* digits = begin;
+	uint64_t result = 0;
+	if(!parseDigits(begin, end, result) || begin == digits)
+		return false;
+
+	while(begin < end && isBlank(*begin)) begin++;
+	if(begin != end)
+		return false;
+
+	value = result;
+	return true;
+}
+
+/**	@brief	Parses one line of a text file of typed keys
+ *	@param	begin	First byte of the line
+ *	@param	end		One past the last byte, excluding the newline
+ *	@param	value	Receives the parsed value
+ *	@return	False if the line is malformed or out of range for the type
+ */
+template<typename Key>
+bool parseTypedKeyLine(const char* begin, const char* end, Key& value) {
+	while(begin < end && isBlank(end[-1])) end--;
+	while(begin < end && isBlank(*begin)) begin++;
+	if(begin == end) {
+		value = 0;
+		return true;
+	}
+	if(*begin == '+' && end - begin > 1 && begin[1] != '-') begin++;
+
+	std::from_chars_result result = std::from_chars(begin, end, value);
+	return result.ec == std::errc() && result.ptr == end;
+}
+
+/**	@brief	Parses one line into a key, with parseKeyLine() for uint64_t keys */
+template<typename Key>
+static inline bool parseLine(const char* begin, const char* end, Key& value) {
+	if constexpr(std::is_same<Key, uint64_t>::value)
+		return parseKeyLine(begin, end, value);
+	else
+		return parseTypedKeyLine(begin, end, value);
+}
+
+/**	@brief	Construct with a thread count
+ *	@param	threads	Number of threads to use, 0 for the default
+ */
+TextKeyParser::TextKeyParser(unsigned threads) :
+	threads_(threads),
+	badLines_(0)
+	{}
+
+/**	@brief	Destructor */
+TextKeyParser::~TextKeyParser() {
+}
+
+/**	@brief	Parses a whole text key file
+ *	@param	path	The file to parse
+ *	@param	keys	Receives the parsed keys, replacing any contents
+ *	@throws	std::runtime_error	If the file cannot be opened or mapped
+ */
+template<typename Key>
+void TextKeyParser::parseFile(const std::string& path, std::vector<Key>& keys) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		throw std::runtime_error("Unable to open input file '" + path + "': " +
+			strerror(errno));
+
+	struct stat st;
+	if(::fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error("Unable to read '" + path + "': " + strerror(errno));
+	}
+	if(st.st_size == 0) {
+		::close(fd);
+		parse(nullptr, 0, keys);
+		return;
+	}
+
+	void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(map == MAP_FAILED)
+		throw std::runtime_error("Unable to map '" + path + "': " + strerror(errno));
+	::madvise(map, st.st_size, MADV_SEQUENTIAL | MADV_WILLNEED);
+
+	try {
+		parse((const char*) map, st.st_size, keys);
+	}
+	catch(...) {
+		::munmap(map, st.st_size);
+		throw;
+	}
+	::munmap(map, st.st_size);
+}
+
+/**	@brief	Parses text key data held in memory
+ *	@param	data		The text
+ *	@param	length	Number of bytes of text
+ *	@param	keys		Receives the parsed keys, replacing any contents
+ */
+template<typename Key>
+void TextKeyParser::parse(const char* data, size_t length, std::vector<Key>& keys) {
+	badLines_ = 0;
+	errors_.clear();
+	keys.clear();
+	if(length == 0) return;
+
+	size_t threads = (threads_ > 0) ? threads_ : defaultThreads();
+	threads = std::max<size_t>(1, std::min(threads, length / MinBytesPerThread));
+
+	//Block boundaries, each just after a newline
+	std::vector<size_t> bounds(threads + 1, length);
+	bounds[0] = 0;
+	for(size_t tid = 1; tid < threads; tid++) {
+		size_t pos = std::max(length / threads * tid, bounds[tid-1]);
+		const char* newline = (const char*) memchr(data + pos, '\n', length - pos);
+		bounds[tid] = (newline != nullptr) ? newline + 1 - data : length;
+	}
+
+	//Count lines per block; a final line may lack its newline
+	std::vector<uint64_t> first(threads + 1, 0);
+	parallelFor(threads, [&](unsigned tid) {
+		size_t begin = bounds[tid];
+		size_t end = bounds[tid+1];
+		uint64_t lines = std::count(data + begin, data + end, '\n');
+		if(end == length && end > begin && data[length-1] != '\n') lines++;
+		first[tid+1] = lines;
+	});
+	for(size_t tid = 0; tid < threads; tid++)
+		first[tid+1] += first[tid];
+
+	//Parse each block straight into its region of the output
+	keys.resize(first[threads]);
+	std::vector<uint64_t> written(threads, 0);
+	std::vector<uint64_t> bad(threads, 0);
+	std::vector<std::vector<ParseError>> errors(threads);
+	parallelFor(threads, [&](unsigned tid) {
+		const char* pos = data + bounds[tid];
+		const char* end = data + bounds[tid+1];
+		Key* out = keys.data() + first[tid];
+		uint64_t line = first[tid];
+		uint64_t count = 0;
+
+		while(pos < end) {
+			//Common case for uint64_t: nothing but digits up to the newline
+			if constexpr(std::is_same<Key, uint64_t>::value) {
+				const char* digits = pos;
+				if(parseDigits(digits, end, out[count]) && digits != pos &&
+					digits < end && *digits == '\n') {
+					count++;
+					line++;
+					pos = digits + 1;
+					continue;
+				}
+			}
+
+			const char* newline = (const char*) memchr(pos, '\n', end - pos);
+			const char* lineEnd = (newline != nullptr) ? newline : end;
+			line++;
+
+			if(parseLine(pos, lineEnd, out[count])) {
+				count++;
+			}
+			else {
+				bad[tid]++;
+				if(errors[tid].size() < MaxReportedErrors)
+					errors[tid].push_back({ line,
+						std::string(pos, std::min<size_t>(lineEnd - pos, MaxErrorText)) });
+			}
+			pos = lineEnd + 1;
+		}
+		written[tid] = count;
+	});
+
+	//Close the gaps left by malformed lines
+	uint64_t total = written[0];
+	for(size_t tid = 1; tid < threads; tid++) {
+		if(total != first[tid])
+			std::memmove(keys.data() + total, keys.data() + first[tid],
+				written[tid] * sizeof(Key));
+		total += written[tid];
+	}
+	keys.resize(total);
+
+	for(size_t tid = 0; tid < threads; tid++) {
+		badLines_ += bad[tid];
+		for(ParseError& error : errors[tid]) {
+			if(errors_.size() < MaxReportedErrors)
+				errors_.push_back(std::move(error));
+		}
+	}
+}
+
+//Key types read from text files; see KeyTraits
+template void TextKeyParser::parseFile<uint32_t>(const std::string&, std::vector<uint32_t>&);
+template void TextKeyParser::parse<uint32_t>(const char*, size_t, std::vector<uint32_t>&);
+template void TextKeyParser::parseFile<uint64_t>(const std::string&, std::vector<uint64_t>&);
+template void TextKeyParser::parse<uint64_t>(const char*, size_t, std::vector<uint64_t>&);
+template void TextKeyParser::parseFile<int32_t>(const std::string&, std::vector<int32_t>&);
+template void TextKeyParser::parse<int32_t>(const char*, size_t, std::vector<int32_t>&);
+template void TextKeyParser::parseFile<int64_t>(const std::string&, std::vector<int64_t>&);
+template void TextKeyParser::parse<int64_t>(const char*, size_t, std::vector<int64_t>&);
+template void TextKeyParser::parseFile<float>(const std::string&, std::vector<float>&);
+template void TextKeyParser::parse<float>(const char*, size_t, std::vector<float>&);
+template void TextKeyParser::parseFile<double>(const std::string&, std::vector<double>&);
+template void TextKeyParser::parse<double>(const char*, size_t, std::vector<double>&);
+template bool parseTypedKeyLine<uint32_t>(const char*, const char*, uint32_t&);
+template bool parseTypedKeyLine<uint64_t>(const char*, const char*, uint64_t&);
+template bool parseTypedKeyLine<int32_t>(const char*, const char*, int32_t&);
+template bool parseTypedKeyLine<int64_t>(const char*, const char*, int64_t&);
+template bool parseTypedKeyLine<float>(const char*, const char*, float&);
+template bool parseTypedKeyLine<double>(const char*, const char*, double&);
+
+}; //End namespace
@@ -0,0 +1,120 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _TEXTPARSER_INCLUDED
+#define _TEXTPARSER_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace JAC::Integer {
+
+/**	@brief	Parses one line of a text key file
+ *	An empty line (or a lone carriage return) is the value 0. Otherwise the
+ *	line may have leading whitespace and a '+', then 1 to 20 decimal digits
+ *	that fit in 64 bits, then trailing whitespace only.
+ *	@param	begin	First byte of the line
+ *	@param	end		One past the last byte, excluding the newline
+ *	@param	value	Receives the parsed value
+ *	@return	False if the line is malformed
+ */
+bool parseKeyLine(const char* begin, const char* end, uint64_t& value);
+
+/**	@brief	A malformed line found while parsing */
+struct ParseError {
+	uint64_t		line;				/*! Line number, starting at 1 */
+	std::string	text;				/*! Line contents, truncated if long */
+};
+
+/**	@brief	Parses one line of a text file of typed keys
+ *	Accepts the layout of parseKeyLine(): an empty line is 0, otherwise
+ *	optional whitespace and '+', the value in std::from_chars() syntax for
+ *	the type, then optional whitespace.
+ *	@param	begin	First byte of the line
+ *	@param	end		One past the last byte, excluding the newline
+ *	@param	value	Receives the parsed value
+ *	@return	False if the line is malformed or out of range for the type
+ */
+template<typename Key>
+bool parseTypedKeyLine(const char* begin, const char* end, Key& value);
+
+/**	@brief	Multithreaded parser for newline-separated text key files
+ *	The file is mapped and split at newline boundaries into one block per
+ *	thread. Each thread counts the lines in its block, the output is sized
+ *	once from the totals, and each thread then parses its block directly into
+ *	its own region of the output. Malformed lines are skipped and reported
+ *	through badLines() and errors() rather than thrown. Keys may be of any
+ *	type KeyTraits supports; uint64_t keys take a SWAR fast path and other
+ *	types are parsed with parseTypedKeyLine().
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class TextKeyParser {
+public:
+	//Number of malformed lines kept for errors()
+	static const size_t MaxReportedErrors = 10;
+
+	//Smallest block worth giving its own thread
+	static const size_t MinBytesPerThread = 1 << 20;
+
+public:
+	/**	@brief	Construct with a thread count
+	 *	@param	threads	Number of threads to use, 0 for the default
+	 */
+	explicit TextKeyParser(unsigned threads = 0);
+
+	/**	@brief	Destructor */
+	virtual ~TextKeyParser();
+
+	/**	@brief	Parses a whole text key file
+	 *	@param	path	The file to parse
+	 *	@param	keys	Receives the parsed keys, replacing any contents
+	 *	@throws	std::runtime_error	If the file cannot be opened or mapped
+	 */
+	template<typename Key>
+	void parseFile(const std::string& path, std::vector<Key>& keys);
+
+	/**	@brief	Parses text key data held in memory
+	 *	@param	data		The text
+	 *	@param	length	Number of bytes of text
+	 *	@param	keys		Receives the parsed keys, replacing any contents
+	 */
+	template<typename Key>
+	void parse(const char* data, size_t length, std::vector<Key>& keys);
+
+	/**	@brief	Number of malformed lines skipped by the last parse */
+	inline uint64_t badLines() const { return badLines_; }
+
+	/**	@brief	The first MaxReportedErrors malformed lines, in file order */
+	inline const std::vector<ParseError>& errors() const { return errors_; }
+
+	//Longest line text kept in a ParseError
+	static const size_t MaxErrorText = 80;
+
+private:
+	unsigned								threads_;		/*! Thread count, 0 for the default */
+	uint64_t								badLines_;	/*! Malformed lines in the last parse */
+	std::vector<ParseError>	errors_;		/*! First malformed lines of the last parse */
+};
+
+}; //End namespace
+
+#endif //Include once
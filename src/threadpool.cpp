@@ -0,0 +1,503 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+//Library includes
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+//Project includes
+#include "threadpool.h"
+#include "parallel.h"
+
+namespace JAC::Integer {
+
+//Size requested for the shared pool, 0 for one per hardware thread
+static std::mutex sharedMutex;
+static unsigned sharedSize = 0;
+static bool sharedCreated = false;
+
+//Pool and worker index of the calling thread, if it is a worker
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local unsigned currentWorker = 0;
+
+//True while the calling thread runs a task it took from another worker's deque
+static thread_local bool currentStolen = false;
+
+//Innermost ConcurrencyScope of the calling thread
+static thread_local ConcurrencyScope* currentScope = nullptr;
+
+/**	@brief	Starts a pool
+ *	@param	threads	Number of workers, at least 1
+ */
+ThreadPool::ThreadPool(unsigned threads) :
+	queued_(0),
+	steals_(0),
+	next_(0),
+	stop_(false) {
+	threads = std::max(1U, threads);
+	for(unsigned id = 0; id < threads; id++) {
+		workers_.emplace_back(new Worker());
+		workers_.back()->idle = false;
+	}
+	threads_.reserve(threads);
+	for(unsigned id = 0; id < threads; id++)
+		threads_.emplace_back(&ThreadPool::work, this, id);
+}
+
+/**	@brief	Destructor, finishes queued tasks and joins the workers */
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+		for(unsigned id : idle_) {
+			workers_[id]->idle = false;
+			workers_[id]->wake.notify_one();
+		}
+		idle_.clear();
+	}
+	for(std::thread& thread : threads_)
+		thread.join();
+}
+
+/**	@brief	The process-wide pool, created on first use */
+ThreadPool& ThreadPool::shared() {
+	static ThreadPool pool([] {
+		std::lock_guard<std::mutex> lock(sharedMutex);
+		sharedCreated = true;
+		return (sharedSize > 0) ? sharedSize : hardwareThreads();
+	}());
+	return pool;
+}
+
+/**	@brief	Sets the size of the shared pool
+ *	@param	threads	Number of workers, 0 for one per hardware thread
+ *	@return	False if the shared pool already exists, which keeps its size
+ */
+bool ThreadPool::setSharedThreads(unsigned threads) {
+	std::lock_guard<std::mutex> lock(sharedMutex);
+	if(sharedCreated) return false;
+	sharedSize = threads;
+	return true;
+}
+
+/**	@brief	Size of the shared pool, whether or not it exists yet */
+unsigned ThreadPool::sharedThreads() {
+	std::lock_guard<std::mutex> lock(sharedMutex);
+	return (sharedSize > 0) ? sharedSize : hardwareThreads();
+}
+
+/**	@brief	Queues a task
+ *	@param	task	The task; must not throw
+ */
+void ThreadPool::submit(Task_t task) {
+	unsigned id = (currentPool == this) ? currentWorker :
+		next_.fetch_add(1, std::memory_order_relaxed) % threads();
+	{
+		std::lock_guard<std::mutex> lock(workers_[id]->mutex);
+		workers_[id]->tasks.push_back(std::move(task));
+	}
+	queued_++;
+	wakeOne();
+}
+
+/**	@brief	Runs one queued task on the calling thread
+ *	@return	False if no task was queued
+ */
+bool ThreadPool::runOne() {
+	Task_t task;
+	if(!takeTask((currentPool == this) ? currentWorker : 0, task))
+		return false;
+	task();
+	return true;
+}
+
+/**	@brief	Runs queued tasks on a worker of this pool until done() is true
+ *	done() is checked with mutex_ held, which submit() and wakeHelpers() take
+ *	before waking a helper, so no wake-up falls between the check and the wait.
+ *	@param	done	The condition to wait for
+ */
+void ThreadPool::helpUntil(const std::function<bool()>& done) {
+	const unsigned id = currentWorker;
+	Worker& self = *workers_[id];
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			if(done()) return;
+			if(queued_.load() == 0) {
+				self.idle = true;
+				helpers_.push_back(id);
+				self.wake.wait(lock, [&] { return !self.idle; });
+				continue;
+			}
+		}
+		runOne();
+	}
+}
+
+/**	@brief	Wakes every worker sleeping in helpUntil() to check its condition */
+void ThreadPool::wakeHelpers() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	for(unsigned id : helpers_) {
+		workers_[id]->idle = false;
+		workers_[id]->wake.notify_one();
+	}
+	helpers_.clear();
+}
+
+/**	@brief	Most members runConcurrently() accepts from the calling thread */
+unsigned ThreadPool::concurrency() const {
+	return (currentPool == this) ? 1 : threads() + 1;
+}
+
+/**	@brief	Runs fn(tid) for tid in [0, count), all at the same time
+ *	The members are queued together, so those of an earlier group are all
+ *	taken before any of this one and two groups never hold each other's
+ *	workers.
+ *	@param	count	Number of members, at most concurrency()
+ *	@param	fn		The member body; must not throw
+ *	@throws	std::invalid_argument	If count exceeds concurrency()
+ */
+void ThreadPool::runConcurrently(unsigned count, const std::function<void(unsigned)>& fn) {
+	if(count == 0) return;
+	if(count > concurrency())
+		throw std::invalid_argument("Cannot run " + std::to_string(count) +
+			" members at once on " + std::to_string(threads()) + " workers");
+
+	std::mutex doneMutex;
+	std::condition_variable doneCond;
+	unsigned remaining = count - 1;
+	auto member = [&](unsigned tid) {
+		fn(tid);
+		std::lock_guard<std::mutex> lock(doneMutex);
+		if(--remaining == 0) doneCond.notify_all();
+	};
+
+	//Idle workers start at once, busy ones as they finish their task
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(unsigned tid = 1; tid < count; tid++) {
+			members_.push_back([&member, tid] { member(tid); });
+			if(idle_.empty()) continue;
+			Worker& worker = *workers_[idle_.back()];
+			idle_.pop_back();
+			worker.idle = false;
+			worker.wake.notify_one();
+		}
+	}
+
+	fn(0);
+	std::unique_lock<std::mutex> lock(doneMutex);
+	doneCond.wait(lock, [&] { return remaining == 0; });
+}
+
+/**	@brief	Worker thread body
+ *	@param	id	Index of the worker
+ */
+void ThreadPool::work(unsigned id) {
+	currentPool = this;
+	currentWorker = id;
+	Worker& self = *workers_[id];
+
+	while(true) {
+		Task_t task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while(members_.empty() && queued_.load() == 0 && !stop_) {
+				self.idle = true;
+				idle_.push_back(id);
+				self.wake.wait(lock, [&] { return !self.idle; });
+			}
+			if(!members_.empty()) {
+				task = std::move(members_.front());
+				members_.pop_front();
+			}
+			else if(stop_ && queued_.load() == 0) {
+				break;
+			}
+		}
+		if(task || takeTask(id, task))
+			task();
+	}
+}
+
+/**	@brief	Takes a task: the newest from deque id, else the oldest from another
+ *	@param	id		Deque to try first
+ *	@param	task	Receives the task
+ *	@return	False if every deque is empty
+ */
+bool ThreadPool::takeTask(unsigned id, Task_t& task) {
+	if(queued_.load() == 0) return false;
+
+	{
+		Worker& worker = *workers_[id];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if(!worker.tasks.empty()) {
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+			queued_--;
+			currentStolen = false;
+			return true;
+		}
+	}
+
+	for(unsigned step = 1; step < threads(); step++) {
+		Worker& victim = *workers_[(id + step) % threads()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queued_--;
+			steals_++;
+			currentStolen = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**	@brief	Wakes one idle worker, or else one helper, to look for queued tasks */
+void ThreadPool::wakeOne() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::vector<unsigned>& sleepers = idle_.empty() ? helpers_ : idle_;
+	if(sleepers.empty()) return;
+	Worker& worker = *workers_[sleepers.back()];
+	sleepers.pop_back();
+	worker.idle = false;
+	worker.wake.notify_one();
+}
+
+/**	@brief	Construct an empty group
+ *	@param	pool	The pool to run on
+ *	@param	limit	Most tasks running at once, 0 for ConcurrencyScope::threads()
+ */
+TaskGroup::TaskGroup(ThreadPool& pool, unsigned limit) :
+	pool_(pool),
+	limit_((limit > 0) ? limit : ConcurrencyScope::threads()),
+	threads_(ConcurrencyScope::threads()),
+	cpus_(ConcurrencyScope::cpus()),
+	pending_(0),
+	running_(0),
+	steals_(0)
+	{}
+
+/**	@brief	Destructor, waits for outstanding tasks */
+TaskGroup::~TaskGroup() {
+	try {
+		wait();
+	}
+	catch(...) {
+	}
+}
+
+/**	@brief	Submits a task to the pool as part of this group
+ *	@param	task	The task
+ */
+void TaskGroup::run(ThreadPool::Task_t task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_++;
+		if(running_ >= limit_) {
+			waiting_.push_back(std::move(task));
+			return;
+		}
+		running_++;
+	}
+	pool_.submit([this, task = std::move(task)]() mutable {
+		if(currentStolen) steals_++;
+		drain(std::move(task));
+	});
+}
+
+/**	@brief	Waits for every task of the group
+ *	@throws	The first exception thrown by a task of the group
+ */
+void TaskGroup::wait() {
+	//A worker helps, as the tasks it waits for may be queued behind others
+	if(currentPool == &pool_) {
+		pool_.helpUntil([this] {
+			std::lock_guard<std::mutex> lock(mutex_);
+			return pending_ == 0;
+		});
+	}
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		done_.wait(lock, [&] { return pending_ == 0; });
+		std::swap(error, error_);
+	}
+	if(error) std::rethrow_exception(error);
+}
+
+/**	@brief	Runs a task, then tasks waiting in the group until there are none
+ *	The group may be destroyed as soon as pending_ reaches 0, so nothing of
+ *	it is touched after the lock that does so is released; helpers waiting
+ *	for it are woken through the pool.
+ *	@param	task	The first task
+ */
+void TaskGroup::drain(ThreadPool::Task_t task) {
+	ThreadPool& pool = pool_;
+	ConcurrencyScope scope(threads_, cpus_);
+	AffinityGuard pin(cpus_);
+	while(task) {
+		try {
+			task();
+		}
+		catch(...) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			if(!error_) error_ = std::current_exception();
+		}
+		task = nullptr;
+
+		bool finished = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if(!waiting_.empty()) {
+				task = std::move(waiting_.front());
+				waiting_.pop_front();
+			}
+			else {
+				running_--;
+			}
+			finished = (--pending_ == 0);
+			if(finished) done_.notify_all();
+		}
+		if(finished) pool.wakeHelpers();
+	}
+}
+
+/**	@brief	Applies limits to the calling thread until destroyed
+ *	Limits left at their defaults are inherited from the enclosing scope.
+ *	@param	threads	Most threads, 0 for the default
+ *	@param	cpus		CPUs to run on, empty for any
+ */
+ConcurrencyScope::ConcurrencyScope(unsigned threads, const std::vector<unsigned>& cpus) :
+	threads_(threads),
+	cpus_(cpus),
+	outer_(currentScope) {
+	if(outer_ != nullptr) {
+		if(threads_ == 0) threads_ = outer_->threads_;
+		if(cpus_.empty()) cpus_ = outer_->cpus_;
+	}
+	currentScope = this;
+}
+
+/**	@brief	Destructor, restores the enclosing limits */
+ConcurrencyScope::~ConcurrencyScope() {
+	currentScope = outer_;
+}
+
+/**	@brief	Thread limit for the calling thread */
+unsigned ConcurrencyScope::threads() {
+	if(currentScope != nullptr) {
+		if(currentScope->threads_ > 0) return currentScope->threads_;
+		if(!currentScope->cpus_.empty()) return (unsigned) currentScope->cpus_.size();
+	}
+	return std::max(1U, ThreadPool::sharedThreads());
+}
+
+/**	@brief	CPUs the calling thread's parallel work may use, empty for any */
+const std::vector<unsigned>& ConcurrencyScope::cpus() {
+	static const std::vector<unsigned> any;
+	return (currentScope != nullptr) ? currentScope->cpus_ : any;
+}
+
+/**	@brief	Pins the calling thread
+ *	@param	cpus	CPUs to run on, empty to leave the thread alone
+ */
+AffinityGuard::AffinityGuard(const std::vector<unsigned>& cpus) :
+	pinned_(false) {
+#ifdef __linux__
+	if(cpus.empty()) return;
+
+	cpu_set_t previous;
+	if(::pthread_getaffinity_np(::pthread_self(), sizeof(previous), &previous) != 0)
+		return;
+
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	for(unsigned cpu : cpus) {
+		if(cpu < CPU_SETSIZE) CPU_SET(cpu, &allowed);
+	}
+	if(::pthread_setaffinity_np(::pthread_self(), sizeof(allowed), &allowed) == 0) {
+		saved_.resize(sizeof(previous));
+		std::memcpy(saved_.data(), &previous, sizeof(previous));
+		pinned_ = true;
+	}
+#else
+	(void) cpus;
+#endif
+}
+
+/**	@brief	Destructor, restores the previous affinity */
+AffinityGuard::~AffinityGuard() {
+#ifdef __linux__
+	if(!pinned_) return;
+	cpu_set_t previous;
+	std::memcpy(&previous, saved_.data(), sizeof(previous));
+	::pthread_setaffinity_np(::pthread_self(), sizeof(previous), &previous);
+#endif
+}
+
+/**	@brief	Parses a CPU list such as "0-3,8"
+ *	@param	text	Comma-separated CPU numbers and inclusive ranges
+ *	@return	The CPUs, in ascending order without repeats
+ *	@throws	std::invalid_argument	On a malformed list
+ */
+std::vector<unsigned> parseCpuList(const std::string& text) {
+	//Parses a CPU number, advancing pos past it
+	auto number = [&](size_t& pos) {
+		size_t start = pos;
+		unsigned long value = 0;
+		while(pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && pos - start < 6)
+			value = value * 10 + (text[pos++] - '0');
+		if(pos == start || (pos < text.size() && text[pos] >= '0' && text[pos] <= '9'))
+			throw std::invalid_argument("Invalid CPU list: " + text);
+		return (unsigned) value;
+	};
+
+	std::vector<unsigned> cpus;
+	size_t pos = 0;
+	while(true) {
+		unsigned first = number(pos);
+		unsigned last = first;
+		if(pos < text.size() && text[pos] == '-') {
+			pos++;
+			last = number(pos);
+			if(last < first)
+				throw std::invalid_argument("Invalid CPU list: " + text);
+		}
+		for(unsigned cpu = first; cpu <= last; cpu++)
+			cpus.push_back(cpu);
+
+		if(pos == text.size()) break;
+		if(text[pos++] != ',')
+			throw std::invalid_argument("Invalid CPU list: " + text);
+	}
+
+	std::sort(cpus.begin(), cpus.end());
+	cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+	return cpus;
+}
+
+}; //End namespace
@@ -0,0 +1,292 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _THREADPOOL_INCLUDED
+#define _THREADPOOL_INCLUDED
+//System includes
+//Library includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace JAC::Integer {
+
+/**	@brief	Fixed pool of worker threads shared by every sort in the process
+ *	Work reaches the workers in two ways:
+ *		- submit() queues a task on a worker's deque. Workers pop their own
+ *			deque newest first and steal the oldest task from others when it
+ *			is empty; a thread waiting for tasks (see TaskGroup) helps run them.
+ *		- runConcurrently() queues the members of a group that must run at the
+ *			same time (ie: threads meeting at a Barrier). Workers take members
+ *			before queued tasks, group by group in the order they were started,
+ *			so a group waits only for workers to finish their current task.
+ *	Sorts therefore reuse the same threads instead of creating their own.
+ *	The shared pool is created on first use, with setSharedThreads() workers
+ *	or one per hardware thread.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class ThreadPool {
+public:
+	//A unit of work
+	typedef std::function<void()>	Task_t;
+
+public:
+	/**	@brief	Starts a pool
+	 *	@param	threads	Number of workers, at least 1
+	 */
+	explicit ThreadPool(unsigned threads);
+
+	/**	@brief	Destructor, finishes queued tasks and joins the workers */
+	virtual ~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**	@brief	The process-wide pool, created on first use */
+	static ThreadPool& shared();
+
+	/**	@brief	Sets the size of the shared pool
+	 *	@param	threads	Number of workers, 0 for one per hardware thread
+	 *	@return	False if the shared pool already exists, which keeps its size
+	 */
+	static bool setSharedThreads(unsigned threads);
+
+	/**	@brief	Size of the shared pool, whether or not it exists yet */
+	static unsigned sharedThreads();
+
+	/**	@brief	Number of workers */
+	inline unsigned threads() const { return (unsigned) workers_.size(); }
+
+	/**	@brief	Queues a task
+	 *	From a worker of this pool the task goes on that worker's deque,
+	 *	otherwise the deques are used in turn.
+	 *	@param	task	The task; must not throw
+	 */
+	void submit(Task_t task);
+
+	/**	@brief	Runs one queued task on the calling thread
+	 *	@return	False if no task was queued
+	 */
+	bool runOne();
+
+	/**	@brief	Runs queued tasks on a worker of this pool until done() is true
+	 *	With nothing queued the worker sleeps as a helper, woken by submit()
+	 *	when no idle worker is left and by wakeHelpers(). done() is called
+	 *	with the pool's lock held, so it must not use the pool.
+	 *	@param	done	The condition to wait for
+	 */
+	void helpUntil(const std::function<bool()>& done);
+
+	/**	@brief	Wakes every worker sleeping in helpUntil() to check its condition */
+	void wakeHelpers();
+
+	/**	@brief	Most members runConcurrently() accepts from the calling thread
+	 *	One per worker plus the calling thread, or just 1 on a worker of this
+	 *	pool: its members would wait for workers that may all be waiting too.
+	 */
+	unsigned concurrency() const;
+
+	/**	@brief	Runs fn(tid) for tid in [0, count), all at the same time
+	 *	tid 0 runs on the calling thread and the others on workers. Returns
+	 *	once every member is done.
+	 *	@param	count	Number of members, at most concurrency()
+	 *	@param	fn		The member body; must not throw
+	 *	@throws	std::invalid_argument	If count exceeds concurrency()
+	 */
+	void runConcurrently(unsigned count, const std::function<void(unsigned)>& fn);
+
+	/**	@brief	Tasks taken from another worker's deque so far, by every user of the pool */
+	inline uint64_t steals() const { return steals_.load(); }
+
+private:
+	/**	@brief	A worker's deque and wake-up signal */
+	struct Worker {
+		std::mutex							mutex;			/*! Guards tasks */
+		std::deque<Task_t>			tasks;			/*! Queued tasks, newest at the back */
+		std::condition_variable	wake;				/*! Signalled when idle is cleared */
+		bool										idle;				/*! Waiting in idle_ or helpers_; guarded by mutex_ */
+	};
+
+	/**	@brief	Worker thread body
+	 *	@param	id	Index of the worker
+	 */
+	void work(unsigned id);
+
+	/**	@brief	Takes a task: the newest from deque id, else the oldest from another
+	 *	@param	id		Deque to try first
+	 *	@param	task	Receives the task
+	 *	@return	False if every deque is empty
+	 */
+	bool takeTask(unsigned id, Task_t& task);
+
+	/**	@brief	Wakes one idle worker, or else one helper, to look for queued tasks */
+	void wakeOne();
+
+private:
+	std::vector<std::unique_ptr<Worker>>	workers_;		/*! One per thread */
+	std::vector<std::thread>	threads_;						/*! The worker threads */
+	std::mutex								mutex_;							/*! Guards idle_, helpers_, members_ and stop_ */
+	std::vector<unsigned>			idle_;							/*! Workers waiting for work */
+	std::vector<unsigned>			helpers_;						/*! Workers waiting in helpUntil() */
+	std::deque<Task_t>				members_;						/*! Group members waiting for a worker */
+	std::atomic<uint64_t>			queued_;						/*! Tasks in all deques */
+	std::atomic<uint64_t>			steals_;						/*! Tasks stolen */
+	std::atomic<unsigned>			next_;							/*! Next deque for outside submissions */
+	bool											stop_;							/*! Set by the destructor */
+};
+
+/**	@brief	Set of tasks submitted to a pool and waited for together
+ *	Tasks may add more tasks to their own group. At most limit() of them
+ *	run at once; the rest wait in the group and are run in turn by the
+ *	workers that finish earlier ones. Each task inherits the ConcurrencyScope
+ *	of the thread that created the group and is pinned to its CPUs, if any.
+ *	wait() blocks the calling thread, except that a worker of the same pool
+ *	runs queued tasks while it waits, so tasks may wait for groups of their
+ *	own without starving the pool.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class TaskGroup {
+public:
+	/**	@brief	Construct an empty group
+	 *	@param	pool	The pool to run on
+	 *	@param	limit	Most tasks running at once, 0 for ConcurrencyScope::threads()
+	 */
+	explicit TaskGroup(ThreadPool& pool = ThreadPool::shared(), unsigned limit = 0);
+
+	/**	@brief	Destructor, waits for outstanding tasks */
+	virtual ~TaskGroup();
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	/**	@brief	Submits a task to the pool as part of this group
+	 *	@param	task	The task
+	 */
+	void run(ThreadPool::Task_t task);
+
+	/**	@brief	Waits for every task of the group
+	 *	@throws	The first exception thrown by a task of the group
+	 */
+	void wait();
+
+	/**	@brief	Most tasks of the group running at once */
+	inline unsigned limit() const { return limit_; }
+
+	/**	@brief	Tasks of this group taken from another worker's deque so far */
+	inline uint64_t steals() const { return steals_.load(); }
+
+private:
+	/**	@brief	Runs a task, then tasks waiting in the group until there are none
+	 *	@param	task	The first task
+	 */
+	void drain(ThreadPool::Task_t task);
+
+private:
+	ThreadPool&								pool_;			/*! The pool tasks run on */
+	unsigned									limit_;			/*! Most tasks running at once */
+	unsigned									threads_;		/*! Creator's thread limit, inherited by tasks */
+	std::vector<unsigned>			cpus_;			/*! Creator's CPUs, inherited by tasks */
+	std::mutex								mutex_;			/*! Guards everything below */
+	std::condition_variable		done_;			/*! Signalled when pending_ reaches 0 */
+	uint64_t									pending_;		/*! Tasks added and not yet finished */
+	unsigned									running_;		/*! Tasks submitted to the pool */
+	std::deque<ThreadPool::Task_t>	waiting_;	/*! Tasks beyond the limit, oldest first */
+	std::exception_ptr				error_;			/*! First exception thrown by a task */
+	std::atomic<uint64_t>			steals_;		/*! Tasks of this group that were stolen */
+};
+
+/**	@brief	Per-thread limits on the parallel work a sort starts
+ *	While a scope is alive, parallel work started by the thread that created
+ *	it (and, through parallelFor(), by the threads that work runs on) uses
+ *	at most threads() threads, pinned to cpus() if any are given. Scopes
+ *	nest; the innermost one applies.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class ConcurrencyScope {
+public:
+	/**	@brief	Applies limits to the calling thread until destroyed
+	 *	@param	threads	Most threads, 0 for the default
+	 *	@param	cpus		CPUs to run on, empty for any
+	 */
+	ConcurrencyScope(unsigned threads, const std::vector<unsigned>& cpus);
+
+	/**	@brief	Destructor, restores the enclosing limits */
+	virtual ~ConcurrencyScope();
+
+	ConcurrencyScope(const ConcurrencyScope&) = delete;
+	ConcurrencyScope& operator=(const ConcurrencyScope&) = delete;
+
+	/**	@brief	Thread limit for the calling thread
+	 *	The innermost scope's limit, otherwise the number of CPUs it allows,
+	 *	otherwise the size of the shared pool. At least 1.
+	 */
+	static unsigned threads();
+
+	/**	@brief	CPUs the calling thread's parallel work may use, empty for any */
+	static const std::vector<unsigned>& cpus();
+
+private:
+	unsigned							threads_;		/*! Thread limit, 0 for the default */
+	std::vector<unsigned>	cpus_;			/*! Allowed CPUs, empty for any */
+	ConcurrencyScope*			outer_;			/*! Enclosing scope on this thread */
+};
+
+/**	@brief	Pins the calling thread to a set of CPUs until destroyed
+ *	Does nothing for an empty set or where affinity is not supported.
+ *
+ *	@author	jcleland@jamescleland.com
+ */
+class AffinityGuard {
+public:
+	/**	@brief	Pins the calling thread
+	 *	@param	cpus	CPUs to run on, empty to leave the thread alone
+	 */
+	explicit AffinityGuard(const std::vector<unsigned>& cpus);
+
+	/**	@brief	Destructor, restores the previous affinity */
+	virtual ~AffinityGuard();
+
+	AffinityGuard(const AffinityGuard&) = delete;
+	AffinityGuard& operator=(const AffinityGuard&) = delete;
+
+private:
+	bool									pinned_;		/*! True if the affinity was changed */
+	std::vector<uint8_t>	saved_;			/*! Previous affinity mask */
+};
+
+/**	@brief	Parses a CPU list such as "0-3,8"
+ *	@param	text	Comma-separated CPU numbers and inclusive ranges
+ *	@return	The CPUs, in ascending order without repeats
+ *	@throws	std::invalid_argument	On a malformed list
+ */
+std::vector<unsigned> parseCpuList(const std::string& text);
+
+}; //End namespace
+
+#endif //Include once
@@ -0,0 +1,72 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+//Library includes
+#include <cstring>
+#include <vector>
+//Project includes
+#include "unique.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Collapses each run of equal keys in sorted data to one key
+ *	@param	keys		Sorted keys; the distinct keys are moved to the front
+ *	@param	count		Number of keys
+ *	@param	counts	Receives the length of each run, at least count elements, or
+ *									nullptr if only the distinct keys are wanted
+ *	@return	The number of distinct keys
+ */
+size_t collapseRuns(uint64_t* keys, size_t count, uint64_t* counts) {
+	if(count == 0) return 0;
+
+	size_t distinct = 0;
+	size_t runStart = 0;
+	for(size_t idx = 1; idx <= count; idx++) {
+		if(idx < count && keys[idx] == keys[runStart]) continue;
+		keys[distinct] = keys[runStart];
+		if(counts != nullptr) counts[distinct] = idx - runStart;
+		distinct++;
+		runStart = idx;
+	}
+	return distinct;
+}
+
+/**	@brief	LSD radix sort that keeps one copy of each key
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to sort; the distinct keys are left at the front
+ *	@param	count			Number of keys
+ *	@param	counts		Receives the count of each distinct key, at least count
+ *										elements, or nullptr
+ *	@return	The number of distinct keys
+ */
+size_t radixSortUnique(const RadixEngine& engine, ScratchArena& scratch, uint64_t* keys,
+	size_t count, uint64_t* counts) {
+	if(count < 2) return collapseRuns(keys, count, counts);
+
+	std::vector<uint64_t> histogram(engine.histogramSize());
+	size_t distinct = 0;
+	uint64_t* result = engine.sortUnique(keys, scratch.reserve<uint64_t>(count), count,
+		histogram.data(), counts, distinct);
+	if(result != keys)
+		std::memcpy(keys, result, distinct * sizeof(uint64_t));
+	return distinct;
+}
+
+}; //End namespace
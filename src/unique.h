@@ -0,0 +1,56 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _UNIQUE_INCLUDED
+#define _UNIQUE_INCLUDED
+//System includes
+//Library includes
+#include <cstdint>
+#include <cstddef>
+//Project includes
+#include "radixengine.h"
+#include "scratch.h"
+
+namespace JAC::Integer {
+
+/**	@brief	Collapses each run of equal keys in sorted data to one key
+ *	@param	keys		Sorted keys; the distinct keys are moved to the front
+ *	@param	count		Number of keys
+ *	@param	counts	Receives the length of each run, at least count elements, or
+ *									nullptr if only the distinct keys are wanted
+ *	@return	The number of distinct keys
+ */
+size_t collapseRuns(uint64_t* keys, size_t count, uint64_t* counts);
+
+/**	@brief	LSD radix sort that keeps one copy of each key
+ *	Duplicates are dropped during the final scatter (see
+ *	BasicRadixEngine::sortUnique()) rather than by a pass over the output.
+ *	@param	engine		Digit layout
+ *	@param	scratch		Scratch memory for the passes
+ *	@param	keys			Keys to sort; the distinct keys are left at the front
+ *	@param	count			Number of keys
+ *	@param	counts		Receives the count of each distinct key, at least count
+ *										elements, or nullptr
+ *	@return	The number of distinct keys
+ */
+size_t radixSortUnique(const RadixEngine& engine, ScratchArena& scratch, uint64_t* keys,
+	size_t count, uint64_t* counts);
+
+}; //End namespace
+
+#endif //Include once
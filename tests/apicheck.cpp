@@ -0,0 +1,356 @@
+/*!
+ *  The latest source code can be downloaded from: [[URL]]
+ *
+ *  Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed Addin the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//System includes
+#ifdef __linux__
+#include <sched.h>
+#endif
+//Library includes
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+//Local includes
+#include "sortalgorithm.h"
+#include "threadpool.h"
+#include "segments.h"
+
+//Integer library namespace
+using namespace JAC::Integer;
+
+//Checks of the sort library API that the isort command line does not reach,
+//against std::stable_sort and std::sort. Usage: isort-apicheck <check>
+
+/**	@brief	Thrown when a result differs from the reference */
+struct CheckFailure : public std::runtime_error {
+	explicit CheckFailure(const std::string& what) : std::runtime_error(what) {}
+};
+
+/**	@brief	Fails the check unless a result matches the reference
+ *	@param	expected	The reference result
+ *	@param	actual		The result
+ *	@param	what			Describes the result, for the failure message
+ */
+template<typename T>
+static void expectEqual(const std::vector<T>& expected, const std::vector<T>& actual,
+	const std::string& what) {
+	if(expected == actual) return;
+	size_t idx = 0;
+	while(idx < expected.size() && idx < actual.size() && expected[idx] == actual[idx]) idx++;
+	throw CheckFailure(what + " differs from std::stable_sort at index " + std::to_string(idx));
+}
+
+/**	@brief	Duplicate-heavy keys
+ *	Keys are drawn from a few hundred values; wide values exercise every
+ *	digit and narrow ones the skipping of passes with a single digit value.
+ *	@param	count	Number of keys
+ *	@param	wide	True for values spread over 64 bits, false for values below 300
+ *	@param	seed	Random seed
+ */
+static std::vector<uint64_t> duplicateKeys(size_t count, bool wide, uint64_t seed) {
+	std::mt19937_64 random(seed);
+	std::vector<uint64_t> values(300);
+	for(size_t idx = 0; idx < values.size(); idx++)
+		values[idx] = wide ? random() : idx;
+	std::vector<uint64_t> keys(count);
+	for(uint64_t& key : keys)
+		key = values[random() % values.size()];
+	return keys;
+}
+
+/**	@brief	Stable key/value sorting and argsort of one plugin and layout
+ *	@param	name		Plugin name
+ *	@param	options	Options set on the plugin
+ *	@param	keys		Keys to sort
+ */
+static void checkPairs(const std::string& name,
+	const std::vector<std::pair<std::string, std::string>>& options,
+	const std::vector<uint64_t>& keys) {
+	std::string what = name;
+	for(const auto& option : options)
+		what += " " + option.first + "=" + option.second;
+	what += " on " + std::to_string(keys.size()) + " keys: ";
+
+	//Reference order: indices of the keys, equal keys in input order
+	const size_t count = keys.size();
+	std::vector<uint64_t> order(count);
+	for(size_t idx = 0; idx < count; idx++) order[idx] = idx;
+	std::stable_sort(order.begin(), order.end(),
+		[&](uint64_t a, uint64_t b) { return keys[a] < keys[b]; });
+	std::vector<uint64_t> sortedKeys(count);
+	for(size_t idx = 0; idx < count; idx++) sortedKeys[idx] = keys[order[idx]];
+	std::vector<uint32_t> order32(order.begin(), order.end());
+
+	SortAlgorithm* sorter = SortAlgorithm::create(name);
+	try {
+		for(const auto& option : options)
+			if(!sorter->setOption(option.first, option.second))
+				throw CheckFailure(what + "option not recognized");
+
+		//Payloads are the input positions, so they must come out in reference order
+		std::vector<uint64_t> pairKeys(keys), values(count);
+		for(size_t idx = 0; idx < count; idx++) values[idx] = idx;
+		sorter->sortPairs(pairKeys.data(), values.data(), count);
+		expectEqual(sortedKeys, pairKeys, what + "sortPairs keys");
+		expectEqual(order, values, what + "sortPairs values");
+
+		std::vector<KeyValue> records(count);
+		for(size_t idx = 0; idx < count; idx++) records[idx] = { keys[idx], idx };
+		sorter->sortRecords(records.data(), count);
+		std::vector<uint64_t> recordValues(count);
+		for(size_t idx = 0; idx < count; idx++) recordValues[idx] = records[idx].value;
+		expectEqual(order, recordValues, what + "sortRecords");
+
+		std::vector<uint64_t> indices(count);
+		sorter->argsort(keys.data(), count, indices.data());
+		expectEqual(order, indices, what + "argsort with 64-bit indices");
+
+		std::vector<uint32_t> indices32(count);
+		sorter->argsort(keys.data(), count, indices32.data());
+		expectEqual(order32, indices32, what + "argsort with 32-bit indices");
+	}
+	catch(...) {
+		SortAlgorithm::destroy(sorter);
+		throw;
+	}
+	SortAlgorithm::destroy(sorter);
+}
+
+/**	@brief	Key/value sorting and argsort against std::stable_sort
+ *	Both radix plugins, both pair layouts and every digit width, on sizes
+ *	from empty to large enough for parradix to use several threads.
+ */
+static void checkPairSorts() {
+	for(const char* name : { "radix", "parradix" }) {
+		for(const char* layout : { "split", "packed" }) {
+			for(const char* bits : { "8", "11", "16" }) {
+				for(size_t count : { 0, 1, 2, 1000, 300000 }) {
+					for(bool wide : { false, true }) {
+						std::vector<std::pair<std::string, std::string>> options = {
+							{ "pair-layout", layout }, { "digit-bits", bits } };
+						if(std::string(name) == "parradix") options.emplace_back("threads", "3");
+						checkPairs(name, options, duplicateKeys(count, wide, count + wide));
+					}
+				}
+			}
+		}
+	}
+}
+
+//Workers of the shared pool in the pool check, fewer than the threads using it
+static const unsigned PoolThreads = 2;
+
+//Plugins sorted concurrently in the pool check; all of them start parallel work
+static const char* const PoolPlugins[] = { "parradix", "samplesort", "counting", "radix" };
+
+/**	@brief	Sorts a copy of some keys with a plugin and compares with std::sort
+ *	@param	name		Plugin name
+ *	@param	keys		Keys to sort
+ *	@param	options	Limits for the call
+ */
+static void checkSort(const std::string& name, const std::vector<uint64_t>& keys,
+	const SortOptions& options) {
+	std::vector<uint64_t> expected(keys), actual(keys);
+	std::sort(expected.begin(), expected.end());
+	SortAlgorithm* sorter = SortAlgorithm::create(name);
+	try {
+		sorter->sort(actual.data(), actual.size(), options);
+	}
+	catch(...) {
+		SortAlgorithm::destroy(sorter);
+		throw;
+	}
+	SortAlgorithm::destroy(sorter);
+	expectEqual(expected, actual, name + " on " + std::to_string(keys.size()) + " keys");
+}
+
+/**	@brief	Runs fn on several threads at once, rethrowing the first exception
+ *	@param	count	Number of threads
+ *	@param	fn		Callable taking the thread index (unsigned)
+ */
+template<typename Function>
+static void onThreads(unsigned count, Function fn) {
+	std::vector<std::exception_ptr> errors(count);
+	std::vector<std::thread> threads;
+	for(unsigned tid = 0; tid < count; tid++) {
+		threads.emplace_back([&, tid] {
+			try {
+				fn(tid);
+			}
+			catch(...) {
+				errors[tid] = std::current_exception();
+			}
+		});
+	}
+	for(std::thread& thread : threads) thread.join();
+	for(std::exception_ptr& error : errors)
+		if(error) std::rethrow_exception(error);
+}
+
+/**	@brief	CPUs the calling thread may run on, empty where unsupported */
+static std::vector<unsigned> allowedCpus() {
+	std::vector<unsigned> cpus;
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for(unsigned cpu = 0; cpu < CPU_SETSIZE; cpu++)
+			if(CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+	}
+#endif
+	return cpus;
+}
+
+/**	@brief	The shared pool under more threads and nesting than it has workers
+ *	Sorts run from several threads at once and from tasks of nested groups,
+ *	which start parallel work of their own on workers; a deadlock shows up
+ *	as a ctest timeout. Tasks must also see their creator's ConcurrencyScope
+ *	and run on its CPUs.
+ */
+static void checkPool() {
+	if(!ThreadPool::setSharedThreads(PoolThreads))
+		throw CheckFailure("the shared pool was created before the check");
+	const std::vector<uint64_t> keys = duplicateKeys(400000, true, 16);
+	std::vector<uint64_t> wide(keys.size());
+	std::mt19937_64 random(16);
+	for(uint64_t& key : wide) key = random();
+
+	//Sorts from more threads than there are workers
+	onThreads(4, [&](unsigned tid) {
+		for(const char* name : PoolPlugins)
+			checkSort(name, (tid % 2) ? keys : wide, { 3, {} });
+	});
+
+	//Sorts from tasks of groups nested in tasks, on workers and outside threads
+	std::atomic<unsigned> sorted(0);
+	onThreads(2, [&](unsigned) {
+		TaskGroup outer;
+		for(unsigned task = 0; task < 4; task++) {
+			outer.run([&, task] {
+				TaskGroup inner;
+				for(const char* name : PoolPlugins) {
+					inner.run([&, name] {
+						checkSort(name, (task % 2) ? keys : wide, { 3, {} });
+						sorted++;
+					});
+				}
+				inner.wait();
+			});
+		}
+		outer.wait();
+	});
+	if(sorted != 2 * 4 * (sizeof(PoolPlugins) / sizeof(PoolPlugins[0])))
+		throw CheckFailure("nested groups ran " + std::to_string(sorted.load()) + " sorts");
+
+	//Tasks inherit the scope of the thread that created their group
+	std::vector<unsigned> cpus = allowedCpus();
+	if(!cpus.empty()) cpus.resize(1);
+	{
+		ConcurrencyScope scope(3, cpus);
+		TaskGroup group;
+		for(unsigned task = 0; task < 8; task++) {
+			group.run([&] {
+				if(ConcurrencyScope::threads() != 3 || ConcurrencyScope::cpus() != cpus)
+					throw CheckFailure("a task did not inherit its creator's scope");
+				if(!cpus.empty() && allowedCpus() != cpus)
+					throw CheckFailure("a task is not pinned to its creator's CPUs");
+			});
+		}
+		group.wait();
+	}
+	if(!cpus.empty()) {
+		for(const char* name : PoolPlugins)
+			checkSort(name, wide, { 3, cpus });
+	}
+}
+
+/**	@brief	Batched segment sorting against std::sort per segment
+ *	Segment lengths cover empty and one-key segments and both sides of the
+ *	network, introsort and radix thresholds, in a shuffled order, with
+ *	enough keys in all for the segments to be spread across threads.
+ */
+static void checkSegments() {
+	std::vector<size_t> lengths;
+	for(size_t length : { (size_t) 0, (size_t) 1, (size_t) 2, (size_t) 8, (size_t) 9,
+		SegmentNetworkKeys, SegmentNetworkKeys + 1, SegmentRadixKeys - 1, SegmentRadixKeys,
+		SegmentRadixKeys + 1, (size_t) 5000 }) {
+		for(unsigned repeat = 0; repeat < 40; repeat++) lengths.push_back(length);
+	}
+	std::mt19937_64 random(19);
+	std::shuffle(lengths.begin(), lengths.end(), random);
+	std::vector<uint64_t> offsets = { 0 };
+	for(size_t length : lengths) offsets.push_back(offsets.back() + length);
+
+	const std::vector<uint64_t> keys = duplicateKeys(offsets.back(), true, 19);
+	std::vector<uint64_t> expected(keys);
+	for(size_t segment = 0; segment < lengths.size(); segment++)
+		std::sort(expected.begin() + offsets[segment], expected.begin() + offsets[segment+1]);
+
+	SortAlgorithm* sorter = SortAlgorithm::create("radix");
+	try {
+		for(unsigned threads : { 1, 3 }) {
+			ConcurrencyScope scope(threads, {});
+			std::vector<uint64_t> actual(keys);
+			sorter->sortSegments(actual.data(), offsets.data(), lengths.size());
+			expectEqual(expected, actual, std::to_string(lengths.size()) + " segments on " +
+				std::to_string(threads) + " threads");
+			sorter->sortSegments(actual.data(), offsets.data(), 0);
+			expectEqual(expected, actual, "no segments");
+		}
+	}
+	catch(...) {
+		SortAlgorithm::destroy(sorter);
+		throw;
+	}
+	SortAlgorithm::destroy(sorter);
+}
+
+/**	@brief	Runs the named check
+ *	@return	0 if it passes, 1 if it fails
+ */
+int main(int argc, char** argv) {
+	if(argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " <pairs|pool|segments>" << std::endl;
+		return 1;
+	}
+	const std::string check = argv[1];
+
+	try {
+		SortAlgorithm::loadPlugins(SortAlgorithm::pluginDirectory());
+		if(check == "pairs")
+			checkPairSorts();
+		else if(check == "pool")
+			checkPool();
+		else if(check == "segments")
+			checkSegments();
+		else
+			throw CheckFailure("unknown check");
+	}
+	catch(const std::exception& e) {
+		std::cerr << "FAIL (" << check << "): " << e.what() << std::endl;
+		return 1;
+	}
+	std::cout << "PASS (" << check << ")" << std::endl;
+	return 0;
+}
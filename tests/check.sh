@@ -0,0 +1,395 @@
+#!/bin/sh
+# The latest source code can be downloaded from: [[URL]]
+#
+# Copyright (c) 2020, James A. Cleland <jcleland at jamescleland dot com>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed Addin the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#End-to-end checks of isort, comparing its output with references built by
+#sort(1) and awk. Usage: check.sh <isort> <check> <work directory>
+
+set -u
+ISORT=$1
+CHECK=$2
+WORK=$3
+mkdir -p "$WORK" && cd "$WORK" || exit 1
+
+#Fails the check with a message
+fail() {
+	echo "FAIL ($CHECK): $*" >&2
+	exit 1
+}
+
+#Runs isort, failing if it reports an exception
+run() {
+	"$ISORT" "$@" > run.log 2>&1 || fail "isort $* exited with status $?"
+	if grep -q "Exception caught" run.log; then
+		fail "isort $*: $(grep "Exception caught" run.log)"
+	fi
+}
+
+#Runs isort, failing unless it reports an exception matching a pattern
+#	expect_error <pattern> <isort arguments>...
+expect_error() {
+	pattern=$1
+	shift
+	"$ISORT" "$@" > run.log 2>&1
+	grep -q "Exception caught.*$pattern" run.log ||
+		fail "isort $* did not fail with '$pattern': $(cat run.log)"
+}
+
+#Creates a text file of unsigned keys
+#	generate <file> <count> <max, 0 for the full range> [distribution]
+generate() {
+	run -c -f "$1" -n "$2" -s "$3" ${4:+-d "$4"} -o /dev/null
+}
+
+#Prints the keys of a binary key file as text, skipping its 32 byte header
+#	keys_of <file>
+keys_of() {
+	od -An -v -t u8 -j 32 "$1" | awk '{ for(i = 1; i <= NF; i++) print $i }'
+}
+
+#Fails unless a text output holds the keys of a text input in ascending order
+#	expect_sorted <input> <output>
+expect_sorted() {
+	sort -n "$1" > expected.txt
+	cmp -s expected.txt "$2" || fail "$2 is not $1 sorted"
+}
+
+#Counting sort: dense and sparse counts, and the fallback for keys it cannot count
+check_counting() {
+	generate dense.dat 200000 5000
+	for threads in 1 3; do
+		run -a counting -j $threads -f dense.dat -o out.txt
+		expect_sorted dense.dat out.txt
+	done
+
+	generate sparse.dat 200000 0 few:64
+	run -a counting -f sparse.dat -o out.txt
+	expect_sorted sparse.dat out.txt
+
+	generate wide.dat 200000 0
+	for fallback in radix msdradix samplesort; do
+		run -a counting -O fallback=$fallback -f wide.dat -o out.txt
+		expect_sorted wide.dat out.txt
+	done
+	expect_error "no fallback" -a counting -O fallback=none -f wide.dat -o out.txt
+}
+
+#Parallel radix: per-thread histograms and scatter, serially and across threads
+check_parradix() {
+	generate wide.dat 400000 0
+	generate narrow.dat 400000 100000
+	for input in wide.dat narrow.dat; do
+		for bits in 8 11 16; do
+			for threads in 1 3; do
+				run -a parradix -j $threads -O digit-bits=$bits -f $input -o out.txt
+				expect_sorted $input out.txt
+			done
+		done
+	done
+}
+
+#MSD radix: full-range, narrow and all-equal keys, on sizes either side of the
+#insertion threshold of 64
+check_msdradix() {
+	for count in 50 64 65 200000; do
+		generate wide.dat $count 0
+		generate narrow.dat $count 1000
+		awk -v count=$count 'BEGIN { for(i = 0; i < count; i++) print 123456789 }' > equal.dat
+		for input in wide.dat narrow.dat equal.dat; do
+			run -a msdradix -f $input -o out.txt
+			expect_sorted $input out.txt
+		done
+	done
+}
+
+#Vectorized quicksort: each instruction set the plugin can be forced to, skipping
+#those this CPU lacks
+check_simdsort() {
+	generate wide.dat 300000 0
+	generate few.dat 300000 0 few:40
+	generate nearly.dat 300000 0 nearly
+	generate tiny.dat 37 0
+	for isa in scalar avx2 avx512; do
+		"$ISORT" -a simdsort -O isa=$isa -f tiny.dat -o out.txt > run.log 2>&1
+		if grep -q "not supported on this CPU" run.log; then
+			echo "Skipping isa=$isa: not supported on this CPU"
+			continue
+		fi
+		for input in wide.dat few.dat nearly.dat tiny.dat; do
+			run -a simdsort -O isa=$isa -f $input -o out.txt
+			expect_sorted $input out.txt
+		done
+	done
+}
+
+#Sample sort: recursive and equality buckets, serially and on pool workers
+check_samplesort() {
+	for data in "1500000 0" "1500000 0 few:16" "1500000 0 few:2000" "1500000 0 zipf" "10000 0"; do
+		set -- $data
+		generate ss.dat $1 $2 ${3:-}
+		for threads in 1 3; do
+			run -a samplesort -j $threads -f ss.dat -o out.txt
+			expect_sorted ss.dat out.txt
+		done
+	done
+}
+
+#Output over an input: the input must be read in full before it is replaced
+check_inplace() {
+	#Binary keys are sorted in a private mapping of the file being replaced
+	generate keys.bin 2000000 0
+	keys_of keys.bin > keys.dat
+	run -f keys.bin -o keys.bin
+	keys_of keys.bin > out.txt
+	expect_sorted keys.dat out.txt
+
+	#Merged inputs are streamed while the output is written, far past the first block
+	sort -n keys.dat > l1.txt
+	generate l2.dat 2000000 0
+	sort -n l2.dat > l2.txt
+	cat keys.dat l2.dat > all.dat
+	run --merge l1.txt l2.txt -o l1.txt
+	expect_sorted all.dat l1.txt
+	sort -n keys.dat > base.txt
+	run -f base.txt --delta l2.dat -o base.txt
+	expect_sorted all.dat base.txt
+
+	#A failed merge leaves its inputs alone
+	cp l2.dat unsorted.txt
+	expect_error "is not sorted" --merge l2.txt unsorted.txt -o unsorted.txt
+	cmp -s l2.dat unsorted.txt || fail "a failed merge replaced its input"
+}
+
+#Fails unless two text files hold the same numbers line by line, to within
+#a relative error (0 for exact)
+#	expect_same_numbers <expected> <output> [relative error]
+expect_same_numbers() {
+	[ "$(wc -l < "$1")" -eq "$(wc -l < "$2")" ] || fail "$2 has the wrong number of keys"
+	paste "$1" "$2" | awk -v error="${3:-0}" '
+		function abs(x) { return (x < 0) ? -x : x }
+		abs($1 - $2) > error * abs($1) { print "line " NR ": expected " $1 ", got " $2; exit 1 }' ||
+		fail "$2 differs from $1"
+}
+
+#Typed keys: signed and floating-point keys through their unsigned transforms
+check_keytypes() {
+	awk 'BEGIN { srand(21)
+		print "-2147483648"; print "2147483647"; print "0"; print "-1"
+		for(i = 0; i < 50000; i++) printf "%.0f\n", int((rand() - 0.5) * 4294967295) }' > i32.dat
+	awk 'BEGIN { srand(22)
+		print "4294967295"; print "0"
+		for(i = 0; i < 50000; i++) printf "%.0f\n", int(rand() * 4294967295) }' > u32.dat
+	awk 'BEGIN { srand(23)
+		print "-9223372036854775808"; print "9223372036854775807"; print "0"; print "-1"
+		for(i = 0; i < 50000; i++)
+			printf "%s%.0f%09.0f\n", (rand() < 0.5) ? "-" : "", 1e8 + int(rand() * 9e8),
+				int(rand() * 1e9) }' > i64.dat
+	awk 'BEGIN { srand(24)
+		print "3.4e38"; print "-3.4e38"; print "1e-30"; print "-1e-30"; print "0"
+		for(i = 0; i < 50000; i++) printf "%.4f\n", int((rand() - 0.5) * 2000000) / 16 }' > f32.dat
+	awk 'BEGIN { srand(25)
+		print "1e300"; print "-1e300"; print "2.5e-300"; print "-2.5e-300"; print "0"
+		for(i = 0; i < 50000; i++) printf "%.10f\n", int((rand() - 0.5) * 2^40) / 1024 }' > f64.dat
+
+	for algorithm in radix parradix msdradix samplesort; do
+		for type in u32 i32 i64; do
+			run -a $algorithm --key-type $type -f $type.dat -o out.txt
+			expect_sorted $type.dat out.txt
+		done
+		#Floats are written in their shortest form, which may round the input
+		run -a $algorithm --key-type f32 -f f32.dat -o out.txt
+		sort -g f32.dat > expected.txt
+		expect_same_numbers expected.txt out.txt 1e-7
+		run -a $algorithm --key-type f64 -f f64.dat -o out.txt
+		sort -g f64.dat > expected.txt
+		expect_same_numbers expected.txt out.txt
+	done
+
+	#Keys out of range for the type are skipped as malformed
+	run --key-type i32 -f i64.dat -o out.txt
+	grep -q "Skipped 50002 malformed" run.log || fail "out of range i32 keys were accepted"
+}
+
+#External sort: -m budgets small enough to spill several runs
+check_external() {
+	generate big.bin 300000 0 zipf
+	keys_of big.bin > big.dat
+	for algorithm in radix parradix msdradix samplesort; do
+		for input in big.dat big.bin; do
+			run -a $algorithm -f $input -m 512K -T . -o out.txt
+			expect_sorted big.dat out.txt
+		done
+		run -a $algorithm -f big.dat -m 512K -T . -o out.bin
+		keys_of out.bin > out.txt
+		expect_sorted big.dat out.txt
+	done
+}
+
+#Selection: -k, --top and --nth against the sorted keys, without a full sort
+check_select() {
+	#Text keys, unsorted binary keys, and sorted binary keys, which are just indexed
+	generate keys.bin 200000 0 zipf
+	keys_of keys.bin > keys.dat
+	run -f keys.dat -o sorted.bin
+	sort -n keys.dat > sorted.txt
+	head -n 100 sorted.txt > smallest.txt
+	tail -n 100 sorted.txt | sort -rn > largest.txt
+	sed -n 12346p sorted.txt > nth.txt
+
+	for algorithm in radix parradix msdradix counting samplesort simdsort; do
+		for input in keys.dat keys.bin sorted.bin; do
+			run -a $algorithm -f $input -k 100 -o out.txt
+			cmp -s smallest.txt out.txt || fail "-k 100 of $input with $algorithm"
+			run -a $algorithm -f $input --top 100 -o out.txt
+			cmp -s largest.txt out.txt || fail "--top 100 of $input with $algorithm"
+			run -a $algorithm -f $input --nth 12345 -o out.txt
+			cmp -s nth.txt out.txt || fail "--nth 12345 of $input with $algorithm"
+		done
+	done
+
+	#More keys wanted than there are, and a rank past the end
+	run -f keys.dat -k 300000 -o out.txt
+	cmp -s sorted.txt out.txt || fail "-k larger than the input"
+	expect_error "out of range" -f keys.dat --nth 200000 -o out.txt
+}
+
+#Quantile list used by check_quantiles, and each quantile in thousandths
+QUANTILES=min,p1,p10,p25,p50,p90,p99,p999,max
+THOUSANDTHS="min 0 p1 10 p10 100 p25 250 p50 500 p90 900 p99 990 p999 999 max 1000"
+
+#Fails unless every 'label value' line of a --quantiles output is within an
+#error of its nearest rank in a sorted text file; keys must be below 2^53
+#	expect_quantiles <sorted> <output> <most rank error>
+expect_quantiles() {
+	[ "$(wc -l < "$2")" -eq 9 ] || fail "$2 does not hold 9 quantiles"
+	awk -v list="$THOUSANDTHS" -v most="$3" '
+		NR == FNR { key[NR - 1] = $1 + 0; n = NR; next }
+		FNR == 1 { split(list, pairs, " "); for(i = 1; i < 18; i += 2) at[pairs[i]] = pairs[i + 1] }
+		{
+			#Nearest rank, and the ranks the reported key occupies
+			rank = int((at[$1] * n + 999) / 1000) - 1
+			if(rank < 0) rank = 0
+			first = lower($2 + 0); last = lower($2 + 1) - 1
+			if(last < first) { print $1 ": " $2 " is not a key"; exit 1 }
+			error = (rank < first) ? first - rank : (rank > last) ? rank - last : 0
+			if(($1 == "min" || $1 == "max") && error > 0) { print $1 " is not exact"; exit 1 }
+			if(error > most) { print $1 ": " $2 " is " error " ranks from rank " rank; exit 1 }
+		}
+		function lower(value,   low, high, mid) {
+			low = 0; high = n
+			while(low < high) { mid = int((low + high) / 2); if(key[mid] < value) low = mid + 1; else high = mid }
+			return low
+		}' "$1" "$2" || fail "$2 quantiles are wrong"
+}
+
+#Quantiles: exact by selection in memory and streamed, and approximate by sketch
+check_quantiles() {
+	for distribution in uniform zipf; do
+		generate q.bin 200000 1000000000000 $distribution
+		keys_of q.bin > q.dat
+		sort -n q.dat > sorted.txt
+		run -f q.dat -o sorted.bin
+
+		for input in q.dat q.bin sorted.bin; do
+			run -f $input --quantiles $QUANTILES -o out.txt
+			expect_quantiles sorted.txt out.txt 0
+			run -f $input --quantiles $QUANTILES -m 64K -j 3 -o out.txt
+			grep -q "in [3-9][0-9]* passes" run.log || fail "-m 64K did not stream $input"
+			expect_quantiles sorted.txt out.txt 0
+		done
+
+		#The sketch's rank error shrinks as its size grows
+		run -f q.bin --quantiles $QUANTILES --approx -o out.txt
+		expect_quantiles sorted.txt out.txt 4000
+		run -f q.bin --quantiles $QUANTILES --approx=2000 -j 3 -o out.txt
+		expect_quantiles sorted.txt out.txt 1000
+	done
+	expect_error "not between 0 and 1" -f q.dat --quantiles 1.5 -o out.txt
+	expect_error "Invalid quantile" -f q.dat --quantiles p50,px -o out.txt
+}
+
+#Merging: --merge of sorted files and --delta into a sorted base
+check_merge() {
+	generate a.dat 150000 0
+	generate b.bin 100000 0 few:500
+	generate c.dat 50000 1000000
+	keys_of b.bin > b.dat
+	cat a.dat b.dat c.dat > all.dat
+
+	#Sorted text, a flagged sorted binary file and text that must be checked
+	sort -n a.dat > a.txt
+	run -f b.dat -o b-sorted.bin
+	sort -n c.dat > c.txt
+	for budget in "" "-m 256K"; do
+		run --merge a.txt b-sorted.bin c.txt $budget -o out.txt
+		expect_sorted all.dat out.txt
+		run --merge a.txt b-sorted.bin c.txt $budget -o out.bin
+		keys_of out.bin > out.txt
+		expect_sorted all.dat out.txt
+	done
+	expect_error "is not sorted" --merge a.txt c.dat -o out.txt
+
+	#Only the delta is sorted, by the selected algorithm
+	run -f a.dat -o base.bin
+	for algorithm in radix msdradix samplesort; do
+		run -a $algorithm -f base.bin --delta b.dat -o out.txt
+		cat a.dat b.dat > expected.dat
+		expect_sorted expected.dat out.txt
+	done
+	run -f a.txt --delta c.dat -m 256K -o out.txt
+	cat a.dat c.dat > expected.dat
+	expect_sorted expected.dat out.txt
+	expect_error "is not sorted" -f a.dat --delta c.dat -o out.txt
+}
+
+#Distinct keys: --unique and --count multiplicities against uniq(1)
+check_unique() {
+	for data in "5000 uniform" "0 few:300" "0 zipf"; do
+		set -- $data
+		generate u.bin 200000 $1 $2
+		keys_of u.bin > u.dat
+		run -f u.dat -o sorted.bin
+		sort -n u.dat | uniq > unique.txt
+		sort -n u.dat | uniq -c | awk '{ print $2 " " $1 }' > counts.txt
+
+		for algorithm in radix parradix msdradix counting samplesort simdsort auto; do
+			for input in u.dat u.bin sorted.bin; do
+				run -a $algorithm -f $input --unique -o out.txt
+				cmp -s unique.txt out.txt || fail "--unique of $input ($2) with $algorithm"
+				run -a $algorithm -f $input --count -o out.txt
+				cmp -s counts.txt out.txt || fail "--count of $input ($2) with $algorithm"
+			done
+		done
+	done
+}
+
+case "$CHECK" in
+	counting)	check_counting ;;
+	parradix)	check_parradix ;;
+	msdradix)	check_msdradix ;;
+	simdsort)	check_simdsort ;;
+	samplesort)	check_samplesort ;;
+	external)	check_external ;;
+	keytypes)	check_keytypes ;;
+	inplace)	check_inplace ;;
+	select)		check_select ;;
+	quantiles)	check_quantiles ;;
+	merge)		check_merge ;;
+	unique)		check_unique ;;
+	*)				fail "unknown check" ;;
+esac
+echo "PASS ($CHECK)"